@@ -0,0 +1,158 @@
+/*! \file IRIS_bench.c
+\brief Microbenchmarks of the RAW reading of <I>IRIS_decoder.c</I>: get_raw_bytes(),
+ray decompression and the 8 to 16-bit conversion of RHOHV. The KDP conversion is a placeholder
+(kdp_8_to_16()) and not measured.
+
+Usage: IRIS_bench [-n reps] file.raw <BR>
+The RAW file is typically made with IRIS_rawgen. Reports one line per benchmark
+(see ODIM_bench.h). Compiled and linked like IRIS_decoder.c.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include "sig_data_types.h"
+#include "sigtypes.h"
+#include "dsp.h"
+#include "headers.h"
+#include "iris_task.h"
+#include "ingest.h"
+#include "product.h"
+#include "setup.h"
+#include "user_lib.h"
+#include "dsp_lib.h"
+#include "IRIS_raw.h"
+#include "ODIM_kernels.h"
+#include "ODIM_bench.h"
+
+/** \brief Decompresses all rays of the product like the decoder. Returns number of bins. */
+static double decompress_all(struct raw_product *pRaw, int types, int sweeps, int rays)
+{
+  struct data_ray ray;
+  SINT4 inlen, ioutlen;
+  int iS,iAz,iQ;
+  double bins=0;
+
+  irec_c=2;
+  ioff_c=0;
+  for(iS=0;iS<sweeps;iS++)
+  {
+     for(iQ=0;iQ<types;iQ++)
+     {
+        struct ingest_data_header inghdr;
+
+        get_raw_bytes((SINT2 *)&inghdr,INGEST_DATA_HEADER_SIZE);
+     }
+     for(iAz=0;iAz<rays;iAz++) for(iQ=0;iQ<types;iQ++)
+     {
+        uncompress_cowords( get_raw_bytes,
+                            pRaw->Record[0].PHeader.hdr.ibytes - ((irec_c * TAPE_RECORD_LEN) + ioff_c),
+                            &inlen, (SINT2 *)&ray, sizeof(ray)/2, &ioutlen ) ;
+        if(ioutlen>0) bins+=ray.hdr.ibincount;
+     }
+     if( ioff_c ) { ioff_c = 0 ; irec_c++ ; }
+  }
+  return(bins);
+}
+
+int main( int argc, char *argv[] )
+{
+  MESSAGE istatus ; SINT4 iSize, iChan ;
+  struct raw_product *pRaw;
+  struct ingest_header *inghdr;
+  int reps=10,r,types,type_i,sweeps,rays;
+  long datalen,n;
+  double *secs,bins=0;
+
+  {
+    int i;
+
+    for(i=1;i<argc-1;i++)
+    {
+      if(strcmp(argv[i],"-n")==0 && i+1<argc-1) reps=atoi(argv[++i]);
+    }
+    if(argc<2 || argv[argc-1][0]=='-' || reps<1)
+    {
+      printf("\nUsage: IRIS_bench [-n reps] file.raw\n\n");
+      exit(1);
+    }
+  }
+
+  istatus = imapopen( argv[argc-1], FALSE, (void**)(void*)&pRaw, &iSize, &iChan ) ;
+  if( istatus != SS_NORMAL )
+  {
+    fprintf( stderr,  "Could not open '%s' for Read/Write.\n", argv[argc-1] ) ;
+    return(1) ;
+  }
+  prod_c = (UINT1 *) pRaw ;
+  inghdr = &(pRaw->Record[1].IHeader);
+  for( types=type_i=0 ; type_i < 128 ; type_i++ )
+     if( lDspMaskTest( &inghdr->tcf.dsp.DataMask, type_i) ) types++;
+  sweeps=inghdr->tcf.scan.isweeps;
+  rays=inghdr->icf.irtotl;
+  datalen=pRaw->Record[0].PHeader.hdr.ibytes - 2*TAPE_RECORD_LEN;
+  datalen-=(datalen/TAPE_RECORD_LEN)*RAW_PROD_BHDR_SIZE;
+  secs=malloc(reps*sizeof(double));
+
+  printf("# %s: %d sweeps, %d rays, %d types, %ld data bytes\n",argv[argc-1],sweeps,rays,types,datalen);
+
+  /* get_raw_bytes, one coword at a time like uncompress_cowords and record at a time */
+  for(r=0;r<reps;r++)
+  {
+     SINT2 w;
+     double t0=bench_now();
+
+     irec_c=2; ioff_c=0;
+     for(n=0;n<datalen/2;n++) get_raw_bytes(&w,2);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("get_raw_bytes/word",secs,reps,(double)datalen,"B");
+
+  for(r=0;r<reps;r++)
+  {
+     SINT2 buf[TAPE_RECORD_LEN/2];
+     double t0=bench_now();
+
+     irec_c=2; ioff_c=0;
+     for(n=0;n+TAPE_RECORD_LEN-RAW_PROD_BHDR_SIZE<=datalen;n+=TAPE_RECORD_LEN-RAW_PROD_BHDR_SIZE)
+        get_raw_bytes(buf,TAPE_RECORD_LEN-RAW_PROD_BHDR_SIZE);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("get_raw_bytes/record",secs,reps,(double)datalen,"B");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     bins=decompress_all(pRaw,types,sweeps,rays);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("decompress/volume",secs,reps,bins,"bin");
+
+  /* conversions over one sweep worth of 8-bit bins with all byte values */
+  {
+     long nbins=(long)rays*1000;
+     uint8_t *in=malloc(nbins), *out=malloc(2*nbins);
+
+     for(n=0;n<nbins;n++) in[n]=(uint8_t)((n*7)&255);
+     for(r=0;r<reps;r++)
+     {
+        double t0=bench_now();
+
+        rhohv_8_to_16(in,nbins,out);
+        secs[r]=bench_now()-t0;
+     }
+     bench_report("rhohv_8_to_16",secs,reps,(double)nbins,"bin");
+     free(in); free(out);
+  }
+
+  free(secs);
+  istatus = imapclose( pRaw, iSize, iChan ) ;
+  if( istatus != SS_NORMAL ) { return(2); }
+  exit( EXIT_SUCCESS ) ;
+}
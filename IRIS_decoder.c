@@ -6,16 +6,31 @@ This code is modified from IRIS sigmet/src/utils/examples/change_raw.C by
 Harri Hohti of FMI and can be used only with IRIS libraries and headers.<BR> 
 The original copyright information is in the source code.<BR>
 
-<B>The program accepts four options:</B><BR>
+<B>The program accepts seven options:</B><BR>
 <B>-?</B> : usage <BR>
 <B>-v</B> : verbose output <BR>
 <B>-d</B> : prints all metadata information <BR>
 <B>-s</B> : only prints available quantities (IRIS and ODIM names). <B>Generates no output file</B>. <BR>
+<B>-t</B> : tail mode, the RAW file is decoded while IRIS is writing it. The decoder waits for
+ each record, at most ODIM_TAIL_TIMEOUT (default 60) seconds. With ODIM_SWEEP_COMMAND the
+ sweeps are emitted as they complete (see IRIS_raw.h). <BR>
+<B>-w</B> : decodes only the quantities wanted by ODIM_<I>SITE</I>_quantities (see test.sh and
+ ODIM_quantities.h), others are passed in compressed form. The scan numbers are those of the
+ RAW file, so do not use with subtasks combined to one volume. <BR>
+<B>-i</B> : inventory, all arguments are RAW files and a catalogue line (CSV) of each is printed:
+ file,site,task,date,time,sweeps,elangles,quantities,iris_types,prf,lowprf,rays,bins,rscale.
+ Only the header records and one record header per sweep are read, the lists are separated by ';'.
+ file, site and task are quoted, quantities unknown to ODIM are UNKNOWN.
+ catalog.sh runs it in parallel for directory trees. <BR>
 
  After option(s) the next argument is the full input file path (IRIS RAW file) and the last
  argument is the full output file path.<BR>
  <B>Example:</B> ./IRIS_decoder -d $IRIS_PRODUCT_RAW/VAN101231235505.RAW1234 output_file.dat <BR>
 
+ With ODIM_SWEEP_FILE or ODIM_SWEEP_COMMAND environment variables each sweep is written also
+ to a single scan file when decoded, and the command is run for it (see test.sh). With
+ ODIM_SECTOR_WIDTH (degrees) also each sector of the sweep is written and the command run for it.<BR>
+
  In operational use the program is typically installed in IRIS output pipe script, 
  which is connected to IRIS output device where RAW data is sent from IRIS output menu.
 
@@ -37,6 +52,10 @@ The original copyright information is in the source code.<BR>
  * TRANSFERED.<BR>
  _________________________________________________________________________*/
 
+/* 64-bit file offsets also in 32-bit builds */
+#define _FILE_OFFSET_BITS 64
+/* selects the decoder-only parts of the shared ODIM_*.h headers */
+#define IRIS_DECODER 1
 
 #include <locale.h>
 #include <math.h>
@@ -45,6 +64,7 @@ The original copyright information is in the source code.<BR>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <float.h>
 #include <limits.h>
@@ -60,10 +80,15 @@ The original copyright information is in the source code.<BR>
 #include "user_lib.h"
 #include "dsp_lib.h"
 #include "ODIM_struct.h"
+#include "ODIM_io.h"
+#include "ODIM_timing.h"
+#include "ODIM_log.h"
+#include "ODIM_quantities.h"
+#include "ODIM_cache.h"
+#include "ODIM_kernels.h"
+#include "IRIS_raw.h"
 
 #define SIGMET_SETUP_H 1
-#define PRODPTR( IREC, IOFF ) \
-  ((UINT1 *)(prod_c + (IREC * TAPE_RECORD_LEN) + IOFF))
 
 struct full_time_spec FullYmds_Time;
 struct ymds_time* const pYmds_Time = &FullYmds_Time.Ymds;
@@ -72,9 +97,6 @@ struct ymds_time* const pYmds_Time = &FullYmds_Time.Ymds;
 \brief pointer to MetaData structure */ 
 MetaData *meta; 
 int argF; /**<\brief Argument index pointing to input file */
-SINT4  irec_c ;         /**<\brief Record number (history: 6144 byte tape records) */
-SINT4  ioff_c ;         /**<\brief Offset within record */
-UINT1 *prod_c ;         /**<\brief Pointer to RAW product */
 UINT2  pol_code;
 int scans; /**<\brief Number of scans in the input subtask RAW file */
 int quantities; /**<\brief Number of quantities saved in the input subtask RAW file */
@@ -82,6 +104,10 @@ int SCAN_QUANTITIES=FALSE; /**<\brief Set TRUE if option -s given:
 Only prints available quantities, no output file generated */
 int VERB=FALSE; /**<\brief Set TRUE if option -v given: Increases verbosity.  */
 int DUMPALL=FALSE; /**<\brief Set TRUE if option -d given: Dumps all information and decodes to output file */
+int TAIL=FALSE; /**<\brief Set TRUE if option -t given: Decodes a RAW file still being written */
+int WANTED_ONLY=FALSE; /**<\brief Set TRUE if option -w given: Decodes only the wanted quantities */
+int INVENTORY=FALSE; /**<\brief Set TRUE if option -i given: Prints a catalogue line of each RAW file
+from its header records only */
 size_t fres;
 double NyqV;
 double NyqW;
@@ -89,24 +115,31 @@ double UnambV;
 double antgain=-1,antgainH,antgainV;
 double radomeloss=0,radomelossH,radomelossV;
 
-FILE *DATAF; /**<\brief File pointer for temporary output data */
-FILE *METAF; /**<\brief Output metadata and data are written to this file (in that order) */
-UINT4 totsize; /**<\brief Total size of MetaData structure */
+FILE *METAF; /**<\brief Output metadata and data are written to this file (in that order).
+The data of a scan is written in blocks of rays (see ODIM_io.h) to its place in file,
+the metadata is written first for space and again when complete. */
+char *SWEEP_FILE=NULL; /**<\brief Per-sweep intermediate file path (ODIM_SWEEP_FILE), "%d" is the sweep
+number. Each sweep is written also as a single scan file of its own as soon as it is decoded. */
+char *SWEEP_COMMAND=NULL; /**<\brief Command run in background for each per-sweep file, the file path
+appended as last argument (ODIM_SWEEP_COMMAND). The decoder waits for the commands before exit. */
+double SECTOR_WIDTH=0; /**<\brief Width of sector files in degrees (ODIM_SECTOR_WIDTH), 0 if none.
+Sectors of a sweep are written next to its sweep file, as soon as their rays are decoded. */
+int sweep_commands=0; /**<\brief Number of sweep commands started */
+uint64_t totsize; /**<\brief Total size of MetaData structure */
 UINT1 POL_H,POL_V,POL_HV; /**<\brief POL_ variables are booleans indicating polarization used */
 UINT1 IS_XHDR = 0;
 UINT1 singlePRF;
 int64_t binmethod_avg;
 double RXlossH, RXlossV, TXlossH, TXlossV,radconstHV,nomTXpower;
 
-/*!\fn void get_raw_bytes( SINT2 *buf_a, SINT4 icnt_a )
-\brief Routine to extract bytes from RAW record, and static variables used by the routine
- */
-void get_raw_bytes( SINT2 *buf_a, SINT4 icnt_a );
 /** \brief Processes the RAW product */
 static void product_raw(struct raw_product *pPRaw);
 void usage( void );
 /** \brief Sets name and ODIM code (see ODIM_struct.h) of quantities in MetaData structure */
 void ProcessDatatype(SINT4 quantity, SINT4 *datatypes);
+/** \brief Sets name and ODIM code of IRIS data type <I>datatype</I> to <I>*data_what</I>.
+Unknown data types leave it as it is. */
+void DatatypeWhat(SINT4 datatype, DataWhat *data_what);
 /** \brief Gives date (YYYYMMDD) and time (hhmmss) strings from ymds_time structure. <BR>
 <B> All times in time related functions are in UTC! </B> */
 time_t give_date_time(char *date, char *time, struct ymds_time ymds);
@@ -120,6 +153,16 @@ void DumpDatasetAttributes(int iS);
 void DumpCommonAttributes(void);
 /** \brief Prints all attributes (previous dumps combined) */ 
 void DumpAllAttributes(void);
+/** \brief Writes metadata of scan \#iS as a single scan intermediate file */
+long write_sweep_metadata(FILE *F, int iS);
+/** \brief Sets <I>*sector</I> to rays ray0... of scan \#iS, starting at <I>start</I>, and writes
+its metadata as a single scan intermediate file */
+long write_sector_metadata(FILE *F, int iS, DataSet *sector, long ray0, time_t start, long minsecs, long maxsecs);
+/** \brief Starts SWEEP_COMMAND for the per-sweep file <I>path</I> */
+void run_sweep_command(char *path);
+/** \brief Prints the catalogue line of RAW file <I>path</I> (option -i). Returns 0 if ok, 1 if the
+file is not a RAW product. */
+int inventory(char *path);
 
 /* ================================================== */
 /** Exit status will be "1" for any kind of error, "0" for successful return.
@@ -128,8 +171,8 @@ int main( int argc, char *argv[] )
 {
   MESSAGE istatus ; SINT4 iSize, iChan ; 
   struct raw_product *pRaw;
+  static char cachefile[1100];
 
-  setbuf(stdout,NULL);
   argF=1;
   {
     int i;
@@ -141,25 +184,88 @@ int main( int argc, char *argv[] )
       if(argv[i][1]=='s') SCAN_QUANTITIES = TRUE;
       if(argv[i][1]=='v') VERB = TRUE;
       if(argv[i][1]=='d') { DUMPALL = TRUE; VERB = TRUE; }
+      if(argv[i][1]=='t') TAIL = TRUE;
+      if(argv[i][1]=='w') WANTED_ONLY = TRUE;
+      if(argv[i][1]=='i') INVENTORY = TRUE;
       argF++;
     }
   }
+  if(INVENTORY)
+  {
+     int i,status=0;
+
+     for(i=argF;i<argc;i++) status |= inventory(argv[i]);
+     exit(status);
+  }
+  log_open("IRIS_decoder",VERB ? LOG_INFO : LOG_OUT);
+  log_product(argv[argF]);
+
+  timing_init("IRIS_decoder",argv[argF]);
+  timing_start(T_OPEN);
+  if(TAIL)
+  {
+     char *envp=getenv("ODIM_TAIL_TIMEOUT");
 
-  istatus = imapopen( argv[argF], FALSE, (void**)(void*)&pRaw, &iSize, &iChan ) ;
+     if(envp) tail_timeout=atof(envp);
+     pRaw=(struct raw_product *)tail_open(argv[argF]);
+     istatus=pRaw ? SS_NORMAL : 0;
+  }
+  else istatus = imapopen( argv[argF], FALSE, (void**)(void*)&pRaw, &iSize, &iChan ) ;
+  timing_stop(T_OPEN);
   if( istatus != SS_NORMAL ) 
   {
     fprintf( stderr,  "Could not open '%s' for Read/Write.\n", argv[argF] ) ;
     return(1) ;
   }
 
-  if(!SCAN_QUANTITIES) METAF=fopen(argv[argF+1],"w");
+  if(!SCAN_QUANTITIES)
+  {
+     static char sweepfile[1000];
+
+     SWEEP_FILE=getenv("ODIM_SWEEP_FILE");
+     SWEEP_COMMAND=getenv("ODIM_SWEEP_COMMAND");
+     if(getenv("ODIM_SECTOR_WIDTH")) SECTOR_WIDTH=atof(getenv("ODIM_SECTOR_WIDTH"));
+     if(SECTOR_WIDTH<0 || SECTOR_WIDTH>=360) SECTOR_WIDTH=0;
+     if((SWEEP_COMMAND || SECTOR_WIDTH>0) && !SWEEP_FILE)
+     {
+        snprintf(sweepfile,sizeof(sweepfile),"%s.sweep%%d",argv[argF+1]);
+        SWEEP_FILE=sweepfile;
+     }
+
+     /* a product decoded before with the same configuration is taken from the cache
+        (not in tail mode, and not when the sweeps are wanted as they are decoded) */
+     if(getenv("ODIM_CACHE_DIR") && !TAIL && !SWEEP_FILE)
+     {
+        timing_start(T_OPEN);
+        cache_entry(cachefile,sizeof(cachefile),cache_hash(0,pRaw,iSize),
+                    WANTED_ONLY ? cache_config_hash("IRIS_decoder -w",NULL) :
+                                  cache_config_hash("IRIS_decoder",cache_env_encoder),".dat");
+        timing_stop(T_OPEN);
+        if(!cache_fetch(cachefile,argv[argF+1]))
+        {
+           log_msg(LOG_INFO,"%s from cache %s\n",argv[argF+1],cachefile);
+           imapclose( pRaw, iSize, iChan ) ;
+           timing_report();
+           exit( EXIT_SUCCESS ) ;
+        }
+     }
+     cache_unshare(argv[argF+1]);
+     METAF=fopen(argv[argF+1],"w");
+  }
 
   meta=calloc(1,sizeof(MetaData));
   totsize=sizeof(MetaData);
   product_raw(pRaw);
+  if(METAF && cachefile[0]) cache_store(argv[argF+1],cachefile);
+  free_metadata(meta);
   free(meta);
-  istatus = imapclose( pRaw, iSize, iChan ) ;
-  if( istatus != SS_NORMAL ) { return(2); }
+  if(TAIL) tail_close((UINT1 *)pRaw);
+  else
+  {
+     istatus = imapclose( pRaw, iSize, iChan ) ;
+     if( istatus != SS_NORMAL ) { return(2); }
+  }
+  timing_report();
 
   exit( EXIT_SUCCESS ) ;
 }
@@ -175,14 +281,20 @@ static void product_raw(struct raw_product *pRaw)
 
   struct ingest_header *inghdr;
   struct product_hdr *prodhdr;
-  SINT4 type_i,iAz, datatypes[64], 
+  SINT4 type_i,iAz, *datatypes,
         datatype, scan, scanlo, scanhi ;
+  struct ingest_data_header *inghdrs;
+  UINT1 **scandata;
+  int *databytes;
+  long *scansize;
   /* struct data_convert Convert; */
   char cdate[10]={0}, ctime[10]={0};
   UINT1 *ray_times;
+  UINT1 *keep=NULL; /* keep[iS*quantities+iQ] set if quantity iQ of scan iS is decoded */
   time_t csecs;
+  long missing_rays=0;
 
-  DATAF=tmpfile();
+  timing_start(T_HEADER);
 
   /* The first two "records" of the product consist of a product
    * header structure and an ingest header structure.  Each is padded
@@ -198,6 +310,7 @@ static void product_raw(struct raw_product *pRaw)
    * the ID's in the product and ingest headers.
    */
   prodhdr=&pRaw->Record[0].PHeader;    
+  timing_count(prodhdr->hdr.ibytes,0,0);
 
   /*  if((pRaw->Record[0].PHeader.hdr.id    != ST_PRODUCT_HDR) || */
   if((prodhdr->hdr.id    != ST_PRODUCT_HDR) ||
@@ -217,9 +330,21 @@ static void product_raw(struct raw_product *pRaw)
          if(type_i == DB_XHDR) 
          { 
             IS_XHDR = 1; 
-            if(SCAN_QUANTITIES || VERB) printf("\nExtended header (XHDR) found, skipping.\n"); 
+            if(SCAN_QUANTITIES || VERB) log_msg(LOG_OUT,"\nExtended header (XHDR) found, skipping.\n"); 
             continue; 
          }
+         quantities++ ; 
+     }
+  }
+  datatypes=calloc(quantities+1,sizeof(SINT4));
+  inghdrs=calloc(quantities+1,sizeof(struct ingest_data_header)); /* +1 for XHDR */
+  scandata=calloc(quantities+1,sizeof(UINT1 *));
+  databytes=calloc(quantities+1,sizeof(int));
+  scansize=calloc(quantities+1,sizeof(long));
+  for( quantities=type_i=0 ; type_i < 128 ; type_i++ )
+  {
+      if( type_i != DB_XHDR && lDspMaskTest( &inghdr->tcf.dsp.DataMask, type_i) )
+      { 
          datatypes[quantities] = type_i; 
          quantities++ ; 
      }
@@ -253,20 +378,23 @@ static void product_raw(struct raw_product *pRaw)
     scans=scanhi;
   }
   meta->how.scan_count=scans; /* V23 */
+  meta->scans=scans;
+  meta->dataset=calloc(scans,sizeof(DataSet));
+  for(type_i=0;type_i<scans;type_i++) alloc_dataset(&meta->dataset[type_i],quantities,inghdr->icf.irtotl);
   ProcessDatatype(-1,datatypes);
 
   if(SCAN_QUANTITIES || VERB) 
   {
     /* Listing of available quantities */
-    printf("\nQuantities measured\n");
-    printf("IRIS     ODIM\n");
-    printf("--------------------\n");
+    log_msg(LOG_OUT,"\nQuantities measured\n");
+    log_msg(LOG_OUT,"IRIS     ODIM\n");
+    log_msg(LOG_OUT,"--------------------\n");
     for(type_i=0;type_i<quantities;type_i++)
     { 
-      printf("%-8s %-8s\n",sdata_name6(datatypes[type_i]),meta->dataset[0].data[type_i].what.quantity);
+      log_msg(LOG_OUT,"%-8s %-8s\n",sdata_name6(datatypes[type_i]),meta->dataset[0].data[type_i].what.quantity);
     }
-    printf("====================\n\n");
-    if(!VERB) return;
+    log_msg(LOG_OUT,"====================\n\n");
+    if(!VERB) { timing_stop(T_HEADER); goto done; }
   }
 
 
@@ -292,8 +420,8 @@ static void product_raw(struct raw_product *pRaw)
     sprintf(test_env,"ODIM_%s_source",meta->where.sitecode);
     if(getenv(test_env)==NULL)
     {
-      printf("\nThe IRIS RAW file comes from previously unknown radar having site name defined as \"%s\".\nSo there is no mandatory environment variable %s defined for it.\n",inghdr->icf.sSitename,test_env); 
-      printf("Please add the ODIM_%s_* and IRIS_%s_* environment variables to your conversion environment.\nSee test.sh provided with the software.\n\n",meta->where.sitecode,meta->where.sitecode);
+      log_msg(LOG_ERR,"\nThe IRIS RAW file comes from previously unknown radar having site name defined as \"%s\".\nSo there is no mandatory environment variable %s defined for it.\n",inghdr->icf.sSitename,test_env); 
+      log_msg(LOG_ERR,"Please add the ODIM_%s_* and IRIS_%s_* environment variables to your conversion environment.\nSee test.sh provided with the software.\n\n",meta->where.sitecode,meta->where.sitecode);
       
       exit(111);
     }
@@ -443,19 +571,54 @@ static void product_raw(struct raw_product *pRaw)
 
   irec_c = 2 ;                  /* Record number */
   ioff_c = 0 ;                  /* Offset within record */
+  /* quantities decoded in each scan */
+  keep=malloc(scans*quantities+1);
+  memset(keep,1,scans*quantities+1);
+  if(WANTED_ONLY)
+  {
+     char envname[50];
+     int iS,iQ;
+
+     SetQuantityParams();
+     sprintf(envname,"ODIM_%s_quantities",meta->where.sitecode);
+     get_wanted_quantities(getenv(envname));
+     for(iS=0;iS<scans;iS++) for(iQ=0;iQ<quantities;iQ++)
+        keep[iS*quantities+iQ]=quantity_wanted(wanted_quants_of_scan(scans==1 ? scanlo : iS+1),
+                                               meta->dataset[iS].data[iQ].what.QuantIdx);
+  }
+  for(type_i=0;type_i<scans;type_i++)
+  {
+     SINT4 n=0,iQ;
+
+     for(iQ=0;iQ<quantities;iQ++) n+=keep[type_i*quantities+iQ];
+     meta->dataset[type_i].quantities=n;
+  }
+
+  timing_stop(T_HEADER);
+  if(METAF) write_metadata(METAF,meta);
 
   for( scan = scanlo ; scan <= scanhi ; scan++ ) 
   {
-    struct ingest_data_header inghdrs[64] ; 
     SINT2 iQ,iS,tQ,azgates;
     char sTimeBuf[TIMENAME_SIZE];
-    UINT1 *scandata[64];
-    int databytes[64],first_ray=0,rotsgn=1;
+    int first_ray=0,rotsgn=1;
     /* double first_az, last_az; */
     double azdiff;
     int CHANGE_QUANTITY_RESOLUTION;
-    long N,scansize[64],min_raysecs,max_raysecs,raysecs;
+    long N,min_raysecs,max_raysecs,raysecs,block=1,block0=0;
+    UINT1 *keepQ;
+    SINT2 refQ=0; /* quantity giving the times and azimuths of rays */
+    off_t scanpos=METAF ? ftello(METAF) : 0,qpos=0,sweeppos=0;
+    FILE *SWEEPF=NULL,*SECTORF=NULL;
+    char sweeppath[1000],sectorpath[1100];
+    off_t sectorpos=0;
+    long sectorrays=0,sector0=0,sector_end=0,sector_minsecs=0,sector_maxsecs=0;
+    int sectors=0;
+    DataSet sector;
+    time_t scanstart;
     struct tm Sdd;
+    double sweep_decomp_secs=TIMING.secs[T_DECOMPRESS];
+    uint64_t sweep_bins=0;
 
     min_raysecs=100000;
     max_raysecs=0;
@@ -464,23 +627,46 @@ static void product_raw(struct raw_product *pRaw)
     POL_HV=0;
 
     if(scans==1) iS=0; else iS=scan-1;
-    meta->dataset[iS].quantities=quantities;
+    keepQ=&keep[iS*quantities];
+    for( iQ=0 ; iQ < quantities ; iQ++ ) scansize[iQ]=0; /* set from the first ray */
+    for( refQ=0 ; refQ < quantities-1 && !keepQ[refQ] ; refQ++ );
     meta->dataset[iS].how.scan_index=scan; /* V23 */
 
+    if(SWEEP_FILE)
+    {
+       /* metadata written for space, again when the sweep is complete */
+       if(strstr(SWEEP_FILE,"%d")) snprintf(sweeppath,sizeof(sweeppath),SWEEP_FILE,scan);
+       else snprintf(sweeppath,sizeof(sweeppath),"%s",SWEEP_FILE);
+       SWEEPF=fopen(sweeppath,"w");
+       if(SWEEPF==NULL) log_msg(LOG_WARN,"Could not open sweep file %s\n",sweeppath);
+       else
+       {
+          write_sweep_metadata(SWEEPF,iS);
+          sweeppos=ftello(SWEEPF);
+       }
+    }
+
     /* Extract the INGEST data file headers for each of the parameters
      * that were recorded.  The headers appear sequentially in the
      * first record of each scan.
      */
+    timing_start(T_HEADER);
     for( iQ=tQ=0 ; iQ < quantities+IS_XHDR ; iQ++,tQ++ ) 
     {
       get_raw_bytes( (SINT2*)&inghdrs[tQ], INGEST_DATA_HEADER_SIZE ) ;
       if(iQ==0 && IS_XHDR) tQ--;
     }
+    timing_stop(T_HEADER);
+    {
+      char sdate[20],stime[20];
+
+      scanstart=give_date_time(sdate,stime,inghdrs[0].time);
+    }
 
     if(VERB)
     {
-      printf("================================================\n"); 
-      printf( "Scan %2.2d began at: %s\n", scan, shhmmssddmonyyyy_r( &inghdrs[0].time, sTimeBuf ));
+      log_msg(LOG_INFO,"================================================\n"); 
+      log_msg(LOG_INFO,"Scan %2.2d began at: %s\n", scan, shhmmssddmonyyyy_r( &inghdrs[0].time, sTimeBuf ));
     }
     
     {
@@ -620,7 +806,6 @@ static void product_raw(struct raw_product *pRaw)
               datatype == DB_PMI8)
            { 
               databytes[iQ]=2;
-              ProcessDatatype(datatype,NULL);
            }  
            else
            { 
@@ -694,12 +879,34 @@ static void product_raw(struct raw_product *pRaw)
     }
 
 
+    /* metadata of the decoded quantities only */
+    for( iQ=tQ=0 ; iQ < quantities ; iQ++ ) if(keepQ[iQ]) meta->dataset[iS].data[tQ++]=meta->dataset[iS].data[iQ];
+
     /* Read the data from each of the azimuth angles, and for each of the
      * quantities recorded.
      */
     azgates=inghdr->icf.irtotl;
+    if(SECTOR_WIDTH>0 && SWEEP_FILE && azgates>0) sectorrays=(long)ceil(SECTOR_WIDTH*azgates/360.0-1.0e-6);
     for( iAz=0 ; iAz < azgates ; iAz++ ) 
     {
+       if(sectorrays && iAz==sector0)
+       {
+          /* metadata written for space, again when the sector is complete */
+          sector_end=sector0+sectorrays;
+          if(sector_end>azgates) sector_end=azgates;
+          sector_minsecs=LONG_MAX;
+          sector_maxsecs=0;
+          sectors++;
+          snprintf(sectorpath,sizeof(sectorpath),"%s.sector%d",sweeppath,sectors);
+          alloc_dataset(&sector,meta->dataset[iS].quantities,sector_end-sector0);
+          SECTORF=fopen(sectorpath,"w");
+          if(SECTORF==NULL) log_msg(LOG_WARN,"Could not open sector file %s\n",sectorpath);
+          else
+          {
+             write_sector_metadata(SECTORF,iS,&sector,sector0,scanstart,0,0);
+             sectorpos=ftello(SECTORF);
+          }
+       }
        for( iQ=0 ; iQ < quantities ; iQ++ ) 
        {
          struct data_ray ray;
@@ -707,33 +914,55 @@ static void product_raw(struct raw_product *pRaw)
          SINT4 inlen, ioutlen; /* irecHold = irec_c, ioffHold = ioff_c ; */
 
          if(iQ==0 && IS_XHDR) uncomp=2; /* uncompress twice if XHDR present to skip it */
+         timing_start(T_DECOMPRESS);
+         if(!keepQ[iQ] && iQ!=refQ)
+         {
+            /* not wanted, passed without expanding */
+            do { skip_cowords(); uncomp--; } while(uncomp);
+            timing_stop(T_DECOMPRESS);
+            continue;
+         }
          do {
                uncompress_cowords( get_raw_bytes,
-                                   pRaw->Record[0].PHeader.hdr.ibytes - ((irec_c * TAPE_RECORD_LEN) + ioff_c),
+                                   raw_bytes_left(pRaw->Record[0].PHeader.hdr.ibytes),
                                    &inlen, (SINT2 *)&ray, sizeof(ray)/2, &ioutlen ) ;
                uncomp--;
          } while(uncomp);
+         timing_stop(T_DECOMPRESS);
 
          if(!iAz)
          {
            /* scan size in bins: bins in ray * azimuth gates */ 
-            scansize[iQ]=ray.hdr.ibincount * inghdr->icf.irtotl;
-            scandata[iQ]=calloc(scansize[iQ],databytes[iQ]);
-            /* fill the data array with 'undetect' */
-            memset(scandata[iQ],255,scansize[iQ]*databytes[iQ]);
+            if(keepQ[iQ]) scansize[iQ]=ray.hdr.ibincount * inghdr->icf.irtotl;
+            if(iQ==refQ)
+            {
+               long raybytes=0;
+
+               for(tQ=0;tQ<quantities;tQ++) if(keepQ[tQ]) raybytes+=ray.hdr.ibincount*databytes[tQ];
+               block=budget_rays(azgates,raybytes);
+            }
+            /* data of a block of rays, filled with 'undetect' */
+            if(keepQ[iQ])
+            {
+               scandata[iQ]=calloc(block*ray.hdr.ibincount,databytes[iQ]);
+               memset(scandata[iQ],255,block*ray.hdr.ibincount*databytes[iQ]);
+            }
             /*            printf("bincount az:%d qu:%d=%d %d\n",iAz,iQ,datatypes[iQ],ray.hdr.ibincount); */
 
             meta->dataset[iS].where.nbins=ray.hdr.ibincount;
-            if(iQ==0)
+            if(iQ==refQ)
             {
                azdiff=fDegFromBin2(ray.hdr.iaz_end)-fPDegFromBin2(ray.hdr.iaz_start);
                if(azdiff<-azgates/2) azdiff+=azgates;
                if(azdiff>azgates/2) azdiff-=azgates;
                if(azdiff>0) rotsgn=1; else rotsgn=-1;
+               meta->dataset[iS].how.antspeed=(double)rotsgn*fDegFromBin2(inghdr->tcf.scan.iscan_speed);
+               meta->dataset[iS].how.rpm=meta->dataset[iS].how.antspeed/6.0;
+               meta->dataset[iS].how.angres=(double)inghdr->tcf.scan.ires1000/1000.0;
             }
          }
-         N=iAz*ray.hdr.ibincount*databytes[iQ];
-         if(!iQ)
+         N=(iAz-block0)*ray.hdr.ibincount*databytes[iQ];
+         if(iQ==refQ)
          {
              raysecs = ray.hdr.itime;
              if(raysecs>=max_raysecs) 
@@ -741,14 +970,21 @@ static void product_raw(struct raw_product *pRaw)
                 max_raysecs=raysecs; 
                 first_ray=iAz+rotsgn;
              }
+             if(raysecs<sector_minsecs) sector_minsecs=raysecs;
+             if(raysecs>sector_maxsecs) sector_maxsecs=raysecs;
 	     /* V23: Start and stop azimuths of each ray */ 
-             meta->dataset[iS].how.startazA[iAz] = fPDegFromBin2(ray.hdr.iaz_start); /* V23 */
-             meta->dataset[iS].how.stopazA[iAz] = fPDegFromBin2(ray.hdr.iaz_end); /* V23 */
+             meta->dataset[iS].startazA[iAz] = fPDegFromBin2(ray.hdr.iaz_start); /* V23 */
+             meta->dataset[iS].stopazA[iAz] = fPDegFromBin2(ray.hdr.iaz_end); /* V23 */
 	     /*
-             meta->dataset[iS].how.startelA[iAz]=fElDegFromBin2(ray.hdr.iel_start);
-             meta->dataset[iS].how.stopelA[iAz]=fElDegFromBin2(ray.hdr.iel_end);
+             meta->dataset[iS].startelA[iAz]=fElDegFromBin2(ray.hdr.iel_start);
+             meta->dataset[iS].stopelA[iAz]=fElDegFromBin2(ray.hdr.iel_end);
              */
          }
+         if(!keepQ[iQ])
+         {
+            if(ioutlen <= 0) { log_msg(LOG_WARN,"RAY %d MISSING, SCAN %d\n",iAz,scan); missing_rays++; }
+            continue;
+         }
 
         /* If there is a ray here, then extract data. Otherwise
          * entire ray is missing and ray kept filled with 'undetect' value.
@@ -757,6 +993,7 @@ static void product_raw(struct raw_product *pRaw)
          if( ioutlen > 0 )
          {
 
+            timing_start(T_CONVERT);
             CHANGE_QUANTITY_RESOLUTION = FALSE;
             datatype = datatypes[iQ];
             /*      printf("DATA %s AZ %d\n",sdata_name6(datatype),iAz); */
@@ -765,38 +1002,14 @@ static void product_raw(struct raw_product *pRaw)
 
                 /* ADD: run thru bins and convert to 16-bit */
                 case DB_KDP:               /* KDP (1 byte) */
-                {
-                  long bI;
-                  UINT2 newBinVal;
-                  UINT1 *pBinVal = ray.data.iData1;
-  
                   CHANGE_QUANTITY_RESOLUTION = TRUE;
-                  newBinVal=1;
-                  for(bI=0 ; bI < ray.hdr.ibincount; bI++,pBinVal++)
-                  {
-                    memcpy(&scandata[iQ][N+bI*2],&newBinVal,2); /* ADD CORRECT RELATION HERE */
-                  }
-                } break;
+                  kdp_8_to_16(ray.data.iData1,ray.hdr.ibincount,&scandata[iQ][N]);
+                break;
 
 	        case DB_RHOHV: case DB_SQI: case DB_CCOR8: case DB_PMI8:  /* RhoHV etc (1 byte) */
-                {
-                  long bI;
-                  UINT2 newBinVal;
-                  UINT1 *pBinVal = ray.data.iData1;
-  
                   CHANGE_QUANTITY_RESOLUTION = TRUE;
-                  for(bI=0 ; bI < ray.hdr.ibincount; bI++,pBinVal++)
-                  {
-                    while(1)
-                    {
-                      if(*pBinVal==255) { newBinVal=65535; break; }
-                      if(*pBinVal==0) { newBinVal=0; break; }
-                      newBinVal=(UINT2)(1.0000001+65533.0*sqrt(((double)*pBinVal-1.0)/253.0));
-                      break;
-                    }
-                    memcpy(&scandata[iQ][N+bI*2],&newBinVal,2);
-                  }
-                } break;
+                  rhohv_8_to_16(ray.data.iData1,ray.hdr.ibincount,&scandata[iQ][N]);
+                break;
             }
 
             if(!CHANGE_QUANTITY_RESOLUTION)
@@ -812,20 +1025,79 @@ static void product_raw(struct raw_product *pRaw)
                    memcpy(&scandata[iQ][N],ray.data.iData2,ray.hdr.ibincount*databytes[iQ]);
                }
             }
+            timing_stop(T_CONVERT);
+            sweep_bins+=ray.hdr.ibincount;
          } else 
          { 
-           if(iQ==0) printf("RAY %d MISSING, SCAN %d\n",iAz,scan); 
+           if(iQ==refQ) { log_msg(LOG_WARN,"RAY %d MISSING, SCAN %d\n",iAz,scan); missing_rays++; }
          }
          totsize+=ray.hdr.ibincount*databytes[iQ];
        }  
+
+       /* block done, its rays are written to the data of each quantity. Blocks end at sector ends. */
+       if(iAz+1-block0 == block || iAz+1 == azgates || (sectorrays && iAz+1 == sector_end))
+       {
+          off_t sectorq=sectorpos;
+
+          timing_start(T_WRITE);
+          for( qpos=scanpos,iQ=0 ; iQ < quantities ; qpos+=(off_t)scansize[iQ]*databytes[iQ],iQ++ )
+          {
+             long raybytes=scansize[iQ]/azgates*databytes[iQ];
+
+             if(!keepQ[iQ]) continue;
+             if(METAF)
+             {
+                fseeko(METAF,qpos+(off_t)block0*raybytes,SEEK_SET);
+                fwrite(scandata[iQ],raybytes,iAz+1-block0,METAF);
+             }
+             if(SWEEPF)
+             {
+                fseeko(SWEEPF,sweeppos+(qpos-scanpos)+(off_t)block0*raybytes,SEEK_SET);
+                fwrite(scandata[iQ],raybytes,iAz+1-block0,SWEEPF);
+             }
+             if(SECTORF)
+             {
+                fseeko(SECTORF,sectorq+(off_t)(block0-sector0)*raybytes,SEEK_SET);
+                fwrite(scandata[iQ],raybytes,iAz+1-block0,SECTORF);
+                sectorq+=(off_t)(sector_end-sector0)*raybytes;
+             }
+             memset(scandata[iQ],255,block*raybytes);
+          }
+          timing_stop(T_WRITE);
+          block0=iAz+1;
+       }
+
+       if(sectorrays && iAz+1 == sector_end)
+       {
+          /* sector complete */
+          if(SECTORF)
+          {
+             timing_start(T_WRITE);
+             rewind(SECTORF);
+             write_sector_metadata(SECTORF,iS,&sector,sector0,scanstart,sector_minsecs,sector_maxsecs);
+             fclose(SECTORF);
+             SECTORF=NULL;
+             timing_stop(T_WRITE);
+             if(SWEEP_COMMAND) run_sweep_command(sectorpath);
+          }
+          free(sector.data);
+          free(sector.startazA);
+          sector0=sector_end;
+       }
     }
+    if(METAF)
+    {
+       /* to the end of the scan, also if no block was written */
+       for( qpos=scanpos,iQ=0 ; iQ < quantities ; iQ++ ) qpos+=(off_t)scansize[iQ]*databytes[iQ];
+       fseeko(METAF,qpos,SEEK_SET);
+    }
+
+    timing_sweep(iS,TIMING.secs[T_DECOMPRESS]-sweep_decomp_secs);
+    timing_count(0,0,sweep_bins);
 
     if(first_ray==azgates) first_ray=0;
     if(first_ray<0) first_ray=azgates-1;
 
-    meta->dataset[iS].how.antspeed=(double)rotsgn*fDegFromBin2(inghdr->tcf.scan.iscan_speed);
-    meta->dataset[iS].how.rpm=meta->dataset[iS].how.antspeed/6.0;
-    meta->dataset[iS].how.angres=(double)inghdr->tcf.scan.ires1000/1000.0;
     /*    printf("CALC a1gate %ld\n",(long)(first_az/meta->dataset[iS].how.angres)); */
     meta->dataset[iS].where.a1gate=first_ray;
 
@@ -842,13 +1114,24 @@ static void product_raw(struct raw_product *pRaw)
     sprintf(meta->dataset[iS].what.enddate,"%s",cdate);
     sprintf(meta->dataset[iS].what.endtime,"%s",ctime);
 
+    if(SWEEPF)
+    {
+       /* sweep complete, it can be encoded while the next ones are decoded */
+       timing_start(T_WRITE);
+       rewind(SWEEPF);
+       write_sweep_metadata(SWEEPF,iS);
+       fclose(SWEEPF);
+       timing_stop(T_WRITE);
+       if(SWEEP_COMMAND) run_sweep_command(sweeppath);
+    }
+
     if(VERB && !DUMPALL) DumpDatasetAttributes(iS);
     
     for( iQ=0 ; iQ < quantities ; iQ++ )
     { 
-      if(VERB && !DUMPALL) DumpDataAttributes(iS,iQ);
-       fwrite(&scandata[iQ][0],scansize[iQ],databytes[iQ],DATAF);
+      if(VERB && !DUMPALL && iQ < meta->dataset[iS].quantities) DumpDataAttributes(iS,iQ);
        free(scandata[iQ]);
+       scandata[iQ]=NULL;
     } 
     /* Done with this scan.  Discard the remainder of this block, if
      * any.
@@ -856,388 +1139,549 @@ static void product_raw(struct raw_product *pRaw)
     if( ioff_c ) { ioff_c = 0 ; irec_c++ ; }
   }
 
+  if(METAF)
   {
      off_t filesize;
-     unsigned char *totdata;
-
-     filesize=ftell(DATAF);
-     totdata=malloc(filesize);
-     rewind(DATAF);
-     fres=fread(totdata,filesize,1,DATAF);
-     fwrite(meta,sizeof(MetaData),1,METAF);
-     fwrite(totdata,filesize,1,METAF);
-     /*     printf("%lu %lu\n",totsize,ftell(METAF)); */
-     free(totdata);
+
+     /* metadata complete now */
+     timing_start(T_WRITE);
+     filesize=ftello(METAF);
+     rewind(METAF);
+     write_metadata(METAF,meta);
+     /*     printf("%lu %lu\n",totsize,filesize); */
+     fclose(METAF);
+     timing_stop(T_WRITE);
+     timing_count(0,filesize,0);
   }
-  fclose(DATAF);
-  fclose(METAF);
 
   if(DUMPALL) DumpAllAttributes();
 
-  return;
-}
-
-
-
-/* ================================================== */
-/** Co-Routine to read the next run of bytes from the raw product file,
- * skipping and checking the record headers as we go.
- */
-void get_raw_bytes( SINT2 *buf_a, SINT4 icnt_a )
-{
-  SINT4 icnt, iremain = icnt_a ; UINT1 *pbuf = (UINT1 *)buf_a ;
-
-  while( iremain > 0 ) {
-    /* If the offset is zero, then get the next record header and
-     * compare the record numbers.  Exit if there is a mismatch.
-     */
-    if( ioff_c == 0 ) {
-      struct raw_prod_bhdr bhdr ;
-      memcpy( (void *)&bhdr, PRODPTR(irec_c, ioff_c), RAW_PROD_BHDR_SIZE ) ;
-      if( bhdr.irec != irec_c ) {
-        fprintf( stderr,  "Block header mismatch (%d) at block %d\n",
-                 bhdr.irec, irec_c ) ; exit(1) ;
-      }
-      ioff_c += RAW_PROD_BHDR_SIZE ;
-    }
+  /* sweep commands must be finished before the volume is encoded */
+  while(sweep_commands)
+  {
+     int status;
+     pid_t pid=wait(&status);
 
-    /* Extract as many bytes out of this record as we can.  Bump record
-     * number and zero the offset if we read it all.
-     */
-    icnt = TAPE_RECORD_LEN - ioff_c ;
-    if( icnt > iremain ) icnt = iremain ;
+     if(pid<0) break;
+     sweep_commands--;
+     if(!WIFEXITED(status) || WEXITSTATUS(status))
+        log_msg(LOG_WARN,"Sweep command %s (pid %d) failed\n",SWEEP_COMMAND,(int)pid);
+  }
 
-    memcpy( pbuf, PRODPTR(irec_c, ioff_c), icnt ) ;
-    iremain -= icnt ; ioff_c += icnt ; pbuf += icnt ;
+  log_msg(LOG_INFO,"\nDecoded %d scans, %d quantities, %ld missing rays, site %s, volume %s %s\n",
+          scans,quantities,missing_rays,meta->where.sitecode,meta->what.date,meta->what.time);
 
-    if( ioff_c == TAPE_RECORD_LEN ) { ioff_c = 0 ; irec_c++ ; }
-  }
+ done:
+  free(datatypes); free(inghdrs); free(scandata); free(databytes); free(scansize);
+  free(ray_times); free(keep);
+  return;
 }
 
 
+
 void usage( void )
 {
   printf( "\nCommand line options:\n" ) ;
   printf( " -h : Usage\n" ) ;
   printf( " -v : Verbose output\n" ) ;
   printf( " -d : Prints all meta data information\n" ) ;
-  printf( " -s : Only Prints available quantities\n\n" ) ;
+  printf( " -s : Only Prints available quantities\n" ) ;
+  printf( " -t : Tail mode, decodes RAW file while it is written\n" ) ;
+  printf( " -w : Decodes only quantities wanted by ODIM_SITE_quantities\n" ) ;
+  printf( " -i : Prints a catalogue line (CSV) of each RAW file given, from headers only\n\n" ) ;
   printf( " After options the arguments are: input RAW file path, output file path\n");
-  printf( " Example: ./IRIS_decoder -d $IRIS_PRODUCT_RAW/VAN101231235505.RAW1234 output_file.dat\n\n");
+  printf( " Example: ./IRIS_decoder -d $IRIS_PRODUCT_RAW/VAN101231235505.RAW1234 output_file.dat\n");
+  printf( " With -i: ./IRIS_decoder -i file.raw ... (see catalog.sh)\n\n");
 }
 
-/** Assigns name and ODIM code to IRIS data type. If quantity index is given and datatypes pointer
-    is NULL, only that datatype is processed. Otherwise all data types pointed with *datatypes 
-    are processed. 
-    The /datasetN/dataM/what of all scans 1-N are set to correct values M in MetaData structure.
-*/ 
-void ProcessDatatype(SINT4 quantity, SINT4 *datatypes)
+int inventory(char *path)
 {
-   int iQ,iS,QN,datatype;
-   DataWhat data_what;
-
-   memset(&data_what,0,sizeof(DataWhat));  
-   if(datatypes==NULL) QN=1; else QN=quantities;
-      
-   for(iQ=0 ; iQ < QN ; iQ++)
-   {
-           if(datatypes!=NULL) datatype = datatypes[iQ];
-           else datatype=quantity;
- 
-           switch( datatype ) 
-            {
-
-                case DB_DBT:               /* Horiz total power (1 byte) */
-                  data_what.QuantIdx = OQ_TH;
-                  sprintf(data_what.quantity,"TH");
-                break;
-
-                case DB_DBZ:               /* Clutter Corrected reflectivity (1 byte) */
-                  data_what.QuantIdx = OQ_DBZH;
-                  sprintf(data_what.quantity,"DBZH");
-                break;
-
-                case DB_VEL:               /* Radial velocity (H) (1 byte) */
-                  data_what.QuantIdx=OQ_VRADH;
-                  sprintf(data_what.quantity,"VRADH");
-                break;
-
-                case DB_WIDTH:             /* Width (H) (1 byte) */
-                  data_what.QuantIdx=OQ_WRADH;
-                  sprintf(data_what.quantity,"WRADH");
-                break;
-
-                case DB_ZDR:               /* Differential reflectivity (1 byte) */
-                  data_what.QuantIdx=OQ_ZDR;
-                  sprintf(data_what.quantity,"ZDR");
-                break;
-
-                case DB_ZDRC:               /* Corrected differential reflectivity (1 byte) */
-                  data_what.QuantIdx=OQ_ZDRC;
-                  sprintf(data_what.quantity,"ZDRC");
-                break;
-
-                case DB_ZDRC2:               /* Corrected differential reflectivity (2 byte) */
-                  data_what.QuantIdx=OQ_ZDRC2;
-                  sprintf(data_what.quantity,"ZDRC");
-                break;
-
-                case DB_DBZC:              /* Fully corrected reflectivity (1 byte) */
-                  data_what.QuantIdx=OQ_DBZHC;
-                  sprintf(data_what.quantity,"DBZHC");
-                break;
-
-                case DB_DBT2:              /* Horiz uncorrected reflectivity (2 byte) */
-                  data_what.QuantIdx=OQ_TH2;
-                  sprintf(data_what.quantity,"TH");
-                break;
-
-                case DB_DBZ2:              /* Corrected reflectivity (2 byte) */
-                  data_what.QuantIdx=OQ_DBZH2;
-                  sprintf(data_what.quantity,"DBZH");
-                break;
-
-                case DB_VEL2:              /* Velocity (2 byte) */
-                  data_what.QuantIdx=OQ_VRADH2;
-                  sprintf(data_what.quantity,"VRADH");
-                break;
-
-                case DB_WIDTH2:            /* Width (2 byte) */
-                  data_what.QuantIdx=OQ_WRADH2;
-                  sprintf(data_what.quantity,"WRADH");
-                break;
-
-                case DB_ZDR2:              /* Differential reflectivity (2 byte) */
-                  data_what.QuantIdx=OQ_ZDR2;
-                  sprintf(data_what.quantity,"ZDR");
-                break;
-
-                case DB_KDP: case DB_KDP2:    /* Kdp (specific differential phase)(1 byte) */
-                  data_what.QuantIdx=OQ_KDP2;
-                  sprintf(data_what.quantity,"KDP");
-                break;
-
-                case DB_PHIDP:             /* PHIdp (differential phase)(1 byte) */
-                  data_what.QuantIdx=OQ_PHIDP;
-                  sprintf(data_what.quantity,"PHIDP");
-                break;
+  static union raw_record hrec[2];
+  struct product_hdr *prodhdr=&hrec[0].PHeader;
+  struct ingest_header *inghdr=&hrec[1].IHeader;
+  struct raw_prod_bhdr bhdr;
+  struct ingest_data_header idh;
+  struct stat st;
+  char line[4096],cdate[10]={0},ctime[10]={0},task[13]={0};
+  size_t len=0;
+  SINT4 type_i,scan,scanlo,scanhi,records,xhdr=0;
+  long lowprf;
+  int fd,i;
+  DataWhat data_what;
+
+  /* only the two header records are read, and a record header per sweep probed */
+  fd=open(path,O_RDONLY);
+  if(fd<0 || fstat(fd,&st) || pread(fd,hrec,sizeof(hrec),0)!=(ssize_t)sizeof(hrec) ||
+     prodhdr->hdr.id != ST_PRODUCT_HDR || inghdr->hdr.id != ST_INGEST_HDR || inghdr->tcf.hdr.id != ST_TASK_CONF)
+  {
+     fprintf( stderr, "ERROR: %s is not a RAW product\n", path ) ;
+     if(fd>=0) close(fd);
+     return(1);
+  }
+  records=st.st_size/TAPE_RECORD_LEN;
 
-                case DB_VELC:              /* Corrected Velocity (1 byte) */
-                  data_what.QuantIdx=OQ_VRADDH;
-                  sprintf(data_what.quantity,"VRADDH");
-                break;
+  if( prodhdr->pcf.psi.raw.iflags & RAW_FLG_SWEEP ) scanlo=scanhi=prodhdr->pcf.psi.raw.isweep;
+  else { scanlo=1; scanhi=inghdr->tcf.scan.isweeps; }
 
-                case DB_SQI:               /* SQI (1 byte) converted to 2-byte */
-                  data_what.QuantIdx=OQ_SQIH;
-                  sprintf(data_what.quantity,"SQIH");
-                break;
+  give_date_time(cdate,ctime,inghdr->icf.VolumeYmds);
+  for(i=0;i<12;i++) task[i]=inghdr->tcf.end.stname[i];
+  for(i=11;i>=0 && (task[i]==' ' || task[i]==0);i--) task[i]=0;
+  /* file, site and task are quoted (CSV, quotes doubled), e.g. for commas in the file path */
+  for(i=0;i<3;i++)
+  {
+     char site[4]={0},*field=i==0 ? path : i==1 ? site : task,*c;
+
+     if(i==1) memcpy(site,inghdr->icf.sSitename,3);
+     line[len++]='"';
+     for(c=field;*c && len<sizeof(line)-4;c++) { if(*c=='"') line[len++]='"'; line[len++]=*c; }
+     if(*c) break;
+     line[len++]='"';
+     line[len++]=',';
+  }
+  if(i<3)
+  {
+     fprintf( stderr, "ERROR: catalogue line of %s too long\n", path ) ;
+     close(fd);
+     return(1);
+  }
+  len+=snprintf(line+len,sizeof(line)-len,"%s,%s,%d,",cdate,ctime,scanhi-scanlo+1);
 
-                case DB_RHOHV: case DB_RHOHV2:            /* RhoHV(0) (1 byte) */
-                  data_what.QuantIdx=OQ_RHOHV2;
-                  sprintf(data_what.quantity,"RHOHV");
-                break;
+  /* elevations from the ingest data header at the first record of each sweep */
+  if(lDspMaskTest(&inghdr->tcf.dsp.DataMask,DB_XHDR)) xhdr=1;
+  for(scan=scanlo;scan<=scanhi && len<sizeof(line);scan++)
+  {
+     SINT4 lo=2,hi=records,mid;
 
-                case DB_DBZC2:             /* Fully corrected reflectivity (2 byte) */
-                  data_what.QuantIdx=OQ_DBZHC2;
-                  sprintf(data_what.quantity,"DBZHC");
-                break;
+     while(lo<hi)
+     {
+        mid=(lo+hi)/2;
+        if(pread(fd,&bhdr,RAW_PROD_BHDR_SIZE,(off_t)mid*TAPE_RECORD_LEN)!=RAW_PROD_BHDR_SIZE) { hi=mid; continue; }
+        if(bhdr.isweep<scan) lo=mid+1; else hi=mid;
+     }
+     if(scan>scanlo) len+=snprintf(line+len,sizeof(line)-len,";");
+     if(lo<records &&
+        pread(fd,&bhdr,RAW_PROD_BHDR_SIZE,(off_t)lo*TAPE_RECORD_LEN)==RAW_PROD_BHDR_SIZE && bhdr.isweep==scan &&
+        pread(fd,&idh,INGEST_DATA_HEADER_SIZE,(off_t)lo*TAPE_RECORD_LEN+RAW_PROD_BHDR_SIZE+xhdr*INGEST_DATA_HEADER_SIZE)==INGEST_DATA_HEADER_SIZE)
+        len+=snprintf(line+len,sizeof(line)-len,"%.2f",fDegFromBin2(idh.iangle));
+  }
+  close(fd);
 
-                case DB_VELC2:             /* Corrected Velocity (2 byte) */
-                  data_what.QuantIdx=OQ_VRADDH2;
-                  sprintf(data_what.quantity,"VRADDH");
-                break;
+  /* quantities as ODIM and IRIS names, UNKNOWN if the IRIS type has no ODIM quantity */
+  for(i=0;i<2 && len<sizeof(line);i++)
+  {
+     int n=0;
 
-                case DB_SQI2:              /* SQI (2 byte) */
-                  data_what.QuantIdx=OQ_SQIH2;
-                  sprintf(data_what.quantity,"SQIH");
-                break;
+     len+=snprintf(line+len,sizeof(line)-len,",");
+     for(type_i=0;type_i<128 && len<sizeof(line);type_i++)
+     {
+        if(type_i==DB_XHDR || !lDspMaskTest(&inghdr->tcf.dsp.DataMask,type_i)) continue;
+        memset(&data_what,0,sizeof(DataWhat));
+        DatatypeWhat(type_i,&data_what);
+        if(!data_what.quantity[0]) sprintf(data_what.quantity,"UNKNOWN");
+        len+=snprintf(line+len,sizeof(line)-len,"%s%s",n++ ? ";" : "",i ? sdata_name6(type_i) : data_what.quantity);
+     }
+  }
 
-                case DB_PHIDP2:            /* PHIdp (differential phase)(2 byte) */
-                  data_what.QuantIdx=OQ_PHIDP2;
-                  sprintf(data_what.quantity,"PHIDP");
-                break;
+  switch( prodhdr->end.itrig )
+  {
+     case PRF_2_3: case PRF_3_4: case PRF_4_5:
+        lowprf=NINT( fPrfLowFromHighCase( prodhdr->end.iprf, prodhdr->end.itrig ));
+     break;
+     default:
+        lowprf=prodhdr->end.iprf;
+     break;
+  }
+  if(len<sizeof(line))
+     len+=snprintf(line+len,sizeof(line)-len,",%d,%ld,%d,%d,%.2f\n",(int)prodhdr->end.iprf,lowprf,
+                   (int)inghdr->icf.irtotl,(int)inghdr->tcf.rng.ibin_out_num,0.01*(double)inghdr->tcf.rng.ibin_out_step);
+  if(len>=sizeof(line))
+  {
+     fprintf( stderr, "ERROR: catalogue line of %s too long\n", path ) ;
+     return(1);
+  }
+  /* one write per line, so that lines of parallel runs to the same output are not mixed */
+  if(write(1,line,len)!=(ssize_t)len) return(1);
+  return(0);
+}
 
-                case DB_LDRH:              /* LDR H to V (1 byte) */
-                  data_what.QuantIdx=OQ_LDR;
-                  sprintf(data_what.quantity,"LDR");
-                break;
+long write_sweep_metadata(FILE *F, int iS)
+{
+   MetaData sweep=*meta;
 
-                case DB_LDRH2:             /* LDR H to V (2 byte) */
-                  data_what.QuantIdx=OQ_LDR2;
-                  sprintf(data_what.quantity,"LDR");
-                break;
+   sweep.scans=1;
+   sweep.dataset=&meta->dataset[iS];
+   return(write_metadata(F,&sweep));
+}
 
-                case DB_LDRV:              /* LDR V to H (1 byte) */
-                  data_what.QuantIdx=OQ_LDRV;
-                  sprintf(data_what.quantity,"LDRV");
-                break;
+long write_sector_metadata(FILE *F, int iS, DataSet *sector, long ray0, time_t start, long minsecs, long maxsecs)
+{
+   DataSet *set=&meta->dataset[iS];
+   MetaData sweep=*meta;
+   long rays=sector->where.nrays,k;
+   time_t secs;
+   struct tm Sdd;
+
+   memcpy(sector->data,set->data,set->quantities*sizeof(QuantitySet));
+   sector->what=set->what;
+   sector->where=set->where;
+   sector->how=set->how;
+   sector->where.nrays=rays;
+   sector->where.a1gate=0;
+   sector->where.startaz=set->startazA[ray0];
+   sector->where.stopaz=set->stopazA[ray0+rays-1];
+   for(k=0;k<6;k++) memcpy(sector->startazA+k*rays,set->startazA+k*set->where.nrays+ray0,rays*sizeof(double));
+
+   /* times of the sector from the times of its rays */
+   secs=start+minsecs;
+   sector->how.startepochs=secs;
+   gmtime_r(&secs,&Sdd);
+   strftime(sector->what.startdate,sizeof(sector->what.startdate),"%Y%m%d",&Sdd);
+   strftime(sector->what.starttime,sizeof(sector->what.starttime),"%H%M%S",&Sdd);
+   secs=start+maxsecs;
+   sector->how.endepochs=secs;
+   gmtime_r(&secs,&Sdd);
+   strftime(sector->what.enddate,sizeof(sector->what.enddate),"%Y%m%d",&Sdd);
+   strftime(sector->what.endtime,sizeof(sector->what.endtime),"%H%M%S",&Sdd);
+
+   sweep.scans=1;
+   sweep.dataset=sector;
+   return(write_metadata(F,&sweep));
+}
 
-                case DB_LDRV2:              /* LDR V to H (2 byte) */
-                  data_what.QuantIdx=OQ_LDRV2;
-                  sprintf(data_what.quantity,"LDRV");
-                break;
+void run_sweep_command(char *path)
+{
+   char cmd[2100];
+   pid_t pid;
 
-                case DB_HCLASS:             /* HydroClass (1 byte) */
-                  data_what.QuantIdx=OQ_HCLASS;
-                  sprintf(data_what.quantity,"HCLASS");
-                break;
+   snprintf(cmd,sizeof(cmd),"%s %s",SWEEP_COMMAND,path);
+   pid=fork();
+   if(pid==0)
+   {
+      execl("/bin/sh","sh","-c",cmd,(char *)NULL);
+      _exit(127);
+   }
+   if(pid<0) { log_msg(LOG_WARN,"Could not start sweep command %s\n",cmd); return; }
+   sweep_commands++;
+   log_msg(LOG_INFO,"Sweep command started: %s\n",cmd);
+}
 
-                case DB_HCLASS2:             /* HydroClass (2 byte) */
-                  data_what.QuantIdx=OQ_HCLASS2;
-                  sprintf(data_what.quantity,"HCLASS");
-                break;
+void DatatypeWhat(SINT4 datatype, DataWhat *data_what)
+{
+   switch( datatype ) 
+    {
 
-                /* Enhanced total power (1 byte) */
-                case DB_DBTV8:               
-                  data_what.QuantIdx = OQ_TV;
-                  sprintf(data_what.quantity,"TV");
+        case DB_DBT:               /* Horiz total power (1 byte) */
+          data_what->QuantIdx = OQ_TH;
+          sprintf(data_what->quantity,"TH");
+        break;
+
+        case DB_DBZ:               /* Clutter Corrected reflectivity (1 byte) */
+          data_what->QuantIdx = OQ_DBZH;
+          sprintf(data_what->quantity,"DBZH");
+        break;
+
+        case DB_VEL:               /* Radial velocity (H) (1 byte) */
+          data_what->QuantIdx=OQ_VRADH;
+          sprintf(data_what->quantity,"VRADH");
+        break;
+
+        case DB_WIDTH:             /* Width (H) (1 byte) */
+          data_what->QuantIdx=OQ_WRADH;
+          sprintf(data_what->quantity,"WRADH");
+        break;
+
+        case DB_ZDR:               /* Differential reflectivity (1 byte) */
+          data_what->QuantIdx=OQ_ZDR;
+          sprintf(data_what->quantity,"ZDR");
+        break;
+
+        case DB_ZDRC:               /* Corrected differential reflectivity (1 byte) */
+          data_what->QuantIdx=OQ_ZDRC;
+          sprintf(data_what->quantity,"ZDRC");
+        break;
+
+        case DB_ZDRC2:               /* Corrected differential reflectivity (2 byte) */
+          data_what->QuantIdx=OQ_ZDRC2;
+          sprintf(data_what->quantity,"ZDRC");
+        break;
+
+        case DB_DBZC:              /* Fully corrected reflectivity (1 byte) */
+          data_what->QuantIdx=OQ_DBZHC;
+          sprintf(data_what->quantity,"DBZHC");
+        break;
+
+        case DB_DBT2:              /* Horiz uncorrected reflectivity (2 byte) */
+          data_what->QuantIdx=OQ_TH2;
+          sprintf(data_what->quantity,"TH");
+        break;
+
+        case DB_DBZ2:              /* Corrected reflectivity (2 byte) */
+          data_what->QuantIdx=OQ_DBZH2;
+          sprintf(data_what->quantity,"DBZH");
+        break;
+
+        case DB_VEL2:              /* Velocity (2 byte) */
+          data_what->QuantIdx=OQ_VRADH2;
+          sprintf(data_what->quantity,"VRADH");
+        break;
+
+        case DB_WIDTH2:            /* Width (2 byte) */
+          data_what->QuantIdx=OQ_WRADH2;
+          sprintf(data_what->quantity,"WRADH");
+        break;
+
+        case DB_ZDR2:              /* Differential reflectivity (2 byte) */
+          data_what->QuantIdx=OQ_ZDR2;
+          sprintf(data_what->quantity,"ZDR");
+        break;
+
+        case DB_KDP: case DB_KDP2:    /* Kdp (specific differential phase)(1 byte) */
+          data_what->QuantIdx=OQ_KDP2;
+          sprintf(data_what->quantity,"KDP");
+        break;
+
+        case DB_PHIDP:             /* PHIdp (differential phase)(1 byte) */
+          data_what->QuantIdx=OQ_PHIDP;
+          sprintf(data_what->quantity,"PHIDP");
+        break;
+
+        case DB_VELC:              /* Corrected Velocity (1 byte) */
+          data_what->QuantIdx=OQ_VRADDH;
+          sprintf(data_what->quantity,"VRADDH");
+        break;
+
+        case DB_SQI:               /* SQI (1 byte) converted to 2-byte */
+          data_what->QuantIdx=OQ_SQIH;
+          sprintf(data_what->quantity,"SQIH");
+        break;
+
+        case DB_RHOHV: case DB_RHOHV2:            /* RhoHV(0) (1 byte) */
+          data_what->QuantIdx=OQ_RHOHV2;
+          sprintf(data_what->quantity,"RHOHV");
+        break;
+
+        case DB_DBZC2:             /* Fully corrected reflectivity (2 byte) */
+          data_what->QuantIdx=OQ_DBZHC2;
+          sprintf(data_what->quantity,"DBZHC");
+        break;
+
+        case DB_VELC2:             /* Corrected Velocity (2 byte) */
+          data_what->QuantIdx=OQ_VRADDH2;
+          sprintf(data_what->quantity,"VRADDH");
+        break;
+
+        case DB_SQI2:              /* SQI (2 byte) */
+          data_what->QuantIdx=OQ_SQIH2;
+          sprintf(data_what->quantity,"SQIH");
+        break;
+
+        case DB_PHIDP2:            /* PHIdp (differential phase)(2 byte) */
+          data_what->QuantIdx=OQ_PHIDP2;
+          sprintf(data_what->quantity,"PHIDP");
+        break;
+
+        case DB_LDRH:              /* LDR H to V (1 byte) */
+          data_what->QuantIdx=OQ_LDR;
+          sprintf(data_what->quantity,"LDR");
+        break;
+
+        case DB_LDRH2:             /* LDR H to V (2 byte) */
+          data_what->QuantIdx=OQ_LDR2;
+          sprintf(data_what->quantity,"LDR");
+        break;
+
+        case DB_LDRV:              /* LDR V to H (1 byte) */
+          data_what->QuantIdx=OQ_LDRV;
+          sprintf(data_what->quantity,"LDRV");
+        break;
+
+        case DB_LDRV2:              /* LDR V to H (2 byte) */
+          data_what->QuantIdx=OQ_LDRV2;
+          sprintf(data_what->quantity,"LDRV");
+        break;
+
+        case DB_HCLASS:             /* HydroClass (1 byte) */
+          data_what->QuantIdx=OQ_HCLASS;
+          sprintf(data_what->quantity,"HCLASS");
+        break;
+
+        case DB_HCLASS2:             /* HydroClass (2 byte) */
+          data_what->QuantIdx=OQ_HCLASS2;
+          sprintf(data_what->quantity,"HCLASS");
+        break;
+
+        /* Enhanced total power (1 byte) */
+        case DB_DBTV8:               
+          data_what->QuantIdx = OQ_TV;
+          sprintf(data_what->quantity,"TV");
 		break; 
 
-                /* Enhanced total power (2 byte) */
-                case DB_DBTV16:              
-                  data_what.QuantIdx=OQ_TV2;
-                  sprintf(data_what.quantity,"TV");
-                break;
+        /* Enhanced total power (2 byte) */
+        case DB_DBTV16:              
+          data_what->QuantIdx=OQ_TV2;
+          sprintf(data_what->quantity,"TV");
+        break;
 
-                /* Enhanced total power (1 byte) */
-                case DB_DBTE8:               
-                  data_what.QuantIdx = OQ_TX;
-                  sprintf(data_what.quantity,"TX");
+        /* Enhanced total power (1 byte) */
+        case DB_DBTE8:               
+          data_what->QuantIdx = OQ_TX;
+          sprintf(data_what->quantity,"TX");
 		break; 
 
-                /* Enhanced total power (2 byte) */
-                case DB_DBTE16:              
-                  data_what.QuantIdx=OQ_TX2;
-                  sprintf(data_what.quantity,"TX");
-                break;
+        /* Enhanced total power (2 byte) */
+        case DB_DBTE16:              
+          data_what->QuantIdx=OQ_TX2;
+          sprintf(data_what->quantity,"TX");
+        break;
 		
-                /* Enhanced reflectivity (1 byte) */
-                case DB_DBZE8:              
-                  data_what.QuantIdx=OQ_DBZX;
-                  sprintf(data_what.quantity,"DBZX");
-                break;
-
-                /* Enhanced reflectivity (2 byte) */
-                case DB_DBZE16:              
-                  data_what.QuantIdx=OQ_DBZX2;
-                  sprintf(data_what.quantity,"DBZX");
-                break;
-
-                /* Signal to noise ratio (1 byte) */
-                case DB_SNR8:              
-                  data_what.QuantIdx=OQ_SNR;
-                  sprintf(data_what.quantity,"SNR");
-                break;
-
-                /* Signal to noise ratio (2 byte) */
-                case DB_SNR16:              
-                  data_what.QuantIdx=OQ_SNR2;
-                  sprintf(data_what.quantity,"SNR");
-                break;
-
-                /* V-channel reflectivity (1 byte) */
-                case DB_DBZV8:              
-                  data_what.QuantIdx=OQ_DBZV;
-                  sprintf(data_what.quantity,"DBZV");
-                break;
-
-                /* V-channel reflectivity (2 byte) */
-                case DB_DBZV16:              
-                  data_what.QuantIdx=OQ_DBZV2;
-                  sprintf(data_what.quantity,"DBZV");
-                break;
+        /* Enhanced reflectivity (1 byte) */
+        case DB_DBZE8:              
+          data_what->QuantIdx=OQ_DBZX;
+          sprintf(data_what->quantity,"DBZX");
+        break;
+
+        /* Enhanced reflectivity (2 byte) */
+        case DB_DBZE16:              
+          data_what->QuantIdx=OQ_DBZX2;
+          sprintf(data_what->quantity,"DBZX");
+        break;
+
+        /* Signal to noise ratio (1 byte) */
+        case DB_SNR8:              
+          data_what->QuantIdx=OQ_SNR;
+          sprintf(data_what->quantity,"SNR");
+        break;
+
+        /* Signal to noise ratio (2 byte) */
+        case DB_SNR16:              
+          data_what->QuantIdx=OQ_SNR2;
+          sprintf(data_what->quantity,"SNR");
+        break;
+
+        /* V-channel reflectivity (1 byte) */
+        case DB_DBZV8:              
+          data_what->QuantIdx=OQ_DBZV;
+          sprintf(data_what->quantity,"DBZV");
+        break;
+
+        /* V-channel reflectivity (2 byte) */
+        case DB_DBZV16:              
+          data_what->QuantIdx=OQ_DBZV2;
+          sprintf(data_what->quantity,"DBZV");
+        break;
 
 		/*------------------- V8.13.7 ---------------------*/
 
-                /* PMI (Polarimetric meteo index) (1 byte) converted to 2-byte */
-                case DB_PMI8:              
-                  data_what.QuantIdx=OQ_PMI2;
-                  sprintf(data_what.quantity,"PMI");
-                break;
+        /* PMI (Polarimetric meteo index) (1 byte) converted to 2-byte */
+        case DB_PMI8:              
+          data_what->QuantIdx=OQ_PMI2;
+          sprintf(data_what->quantity,"PMI");
+        break;
 
-                /* PMI (Polarimetric meteo index) (2 byte) */
-                case DB_PMI16:              
-                  data_what.QuantIdx=OQ_PMI2;
-                  sprintf(data_what.quantity,"PMI");
+        /* PMI (Polarimetric meteo index) (2 byte) */
+        case DB_PMI16:              
+          data_what->QuantIdx=OQ_PMI2;
+          sprintf(data_what->quantity,"PMI");
 
 
-                break;
-                /* The log receiver signal-to-noise ratio (1 byte) */
-                case DB_LOG8:              
-                  data_what.QuantIdx=OQ_LOG;
-                  sprintf(data_what.quantity,"LOG");
-                break;
+        break;
+        /* The log receiver signal-to-noise ratio (1 byte) */
+        case DB_LOG8:              
+          data_what->QuantIdx=OQ_LOG;
+          sprintf(data_what->quantity,"LOG");
+        break;
 
-                /* The log receiver signal-to-noise ratio (2 byte) */
-                case DB_LOG16:              
-                  data_what.QuantIdx=OQ_LOG2;
-                  sprintf(data_what.quantity,"DBZV");
-                break;
+        /* The log receiver signal-to-noise ratio (2 byte) */
+        case DB_LOG16:              
+          data_what->QuantIdx=OQ_LOG2;
+          sprintf(data_what->quantity,"DBZV");
+        break;
 
 		/* Doppler channel clutter signal power (-CSR) (1 byte) */
-                case DB_CSP8:              
-                  data_what.QuantIdx=OQ_CSP;
-                  sprintf(data_what.quantity,"CSP");
-                break;
+        case DB_CSP8:              
+          data_what->QuantIdx=OQ_CSP;
+          sprintf(data_what->quantity,"CSP");
+        break;
 
 		/* Doppler channel clutter signal power (-CSR) (2 byte) */
-                case DB_CSP16:              
-                  data_what.QuantIdx=OQ_CSP2;
-                  sprintf(data_what.quantity,"CSP");
-                break;
-
-
-                /* Cross correlation, uncorrected CCOR (1 byte) converted from 1-byte */
-                case DB_CCOR8:              
-                  data_what.QuantIdx=OQ_CCOR2;
-                  sprintf(data_what.quantity,"CCOR");
-                break;
-
-                /* Cross correlation, uncorrected CCOR (2 byte) */
-                case DB_CCOR16:              
-                  data_what.QuantIdx=OQ_CCOR2;
-                  sprintf(data_what.quantity,"CCOR");
-                break;
-
-
-                /* Attenuation of Zh (1 byte) */
-                case DB_AH8:              
-                  data_what.QuantIdx=OQ_PIA;
-                  sprintf(data_what.quantity,"PIA");
-                break;
-
-                /* Attenuation of Zh (2 byte) */
-                case DB_AH16:              
-                  data_what.QuantIdx=OQ_PIA2;
-                  sprintf(data_what.quantity,"PIA");
-                break;
-
-
-                /* Attenuation of Zv (1 byte) */
-                case DB_AV8:              
-                  data_what.QuantIdx=OQ_ATTV;
-                  sprintf(data_what.quantity,"ATTV");
-                break;
-
-                /* Attenuation of Zv (2 byte) */
-                case DB_AV16:              
-                  data_what.QuantIdx=OQ_ATTV2;
-                  sprintf(data_what.quantity,"ATTV");
-                break;
-
+        case DB_CSP16:              
+          data_what->QuantIdx=OQ_CSP2;
+          sprintf(data_what->quantity,"CSP");
+        break;
+
+
+        /* Cross correlation, uncorrected CCOR (1 byte) converted from 1-byte */
+        case DB_CCOR8:              
+          data_what->QuantIdx=OQ_CCOR2;
+          sprintf(data_what->quantity,"CCOR");
+        break;
+
+        /* Cross correlation, uncorrected CCOR (2 byte) */
+        case DB_CCOR16:              
+          data_what->QuantIdx=OQ_CCOR2;
+          sprintf(data_what->quantity,"CCOR");
+        break;
+
+
+        /* Attenuation of Zh (1 byte) */
+        case DB_AH8:              
+          data_what->QuantIdx=OQ_PIA;
+          sprintf(data_what->quantity,"PIA");
+        break;
+
+        /* Attenuation of Zh (2 byte) */
+        case DB_AH16:              
+          data_what->QuantIdx=OQ_PIA2;
+          sprintf(data_what->quantity,"PIA");
+        break;
+
+
+        /* Attenuation of Zv (1 byte) */
+        case DB_AV8:              
+          data_what->QuantIdx=OQ_ATTV;
+          sprintf(data_what->quantity,"ATTV");
+        break;
+
+        /* Attenuation of Zv (2 byte) */
+        case DB_AV16:              
+          data_what->QuantIdx=OQ_ATTV2;
+          sprintf(data_what->quantity,"ATTV");
+        break;
+
+
+        /* Attenuation of Zdr (1 byte) */
+        case DB_AZDR8:              
+          data_what->QuantIdx=OQ_ATTZDR;
+          sprintf(data_what->quantity,"ATTZDR");
+        break;
+
+        /* Attenuation of Zdr (2 byte) */
+        case DB_AZDR16:              
+          data_what->QuantIdx=OQ_ATTZDR2;
+          sprintf(data_what->quantity,"ATTZDR");
+        break;
+    }
+}
 
-                /* Attenuation of Zdr (1 byte) */
-                case DB_AZDR8:              
-                  data_what.QuantIdx=OQ_ATTZDR;
-                  sprintf(data_what.quantity,"ATTZDR");
-                break;
+/** Assigns name and ODIM code to IRIS data type. If quantity index is given and datatypes pointer
+    is NULL, only that datatype is processed. Otherwise all data types pointed with *datatypes 
+    are processed. 
+    The /datasetN/dataM/what of all scans 1-N are set to correct values M in MetaData structure.
+*/ 
+void ProcessDatatype(SINT4 quantity, SINT4 *datatypes)
+{
+   int iQ,iS,QN,datatype;
+   DataWhat data_what;
 
-                /* Attenuation of Zdr (2 byte) */
-                case DB_AZDR16:              
-                  data_what.QuantIdx=OQ_ATTZDR2;
-                  sprintf(data_what.quantity,"ATTZDR");
-                break;
-            }
+   memset(&data_what,0,sizeof(DataWhat));  
+   if(datatypes==NULL) QN=1; else QN=quantities;
+      
+   for(iQ=0 ; iQ < QN ; iQ++)
+   {
+           if(datatypes!=NULL) datatype = datatypes[iQ];
+           else datatype=quantity;
+ 
+           DatatypeWhat(datatype,&data_what);
 
            /* printf("%d %d %s %s\n",iQ,datatype,data_what.quantity,sdata_name6(datatype)); */
        for(iS=0;iS<scans;iS++)
@@ -1280,25 +1724,25 @@ time_t sec_from_date_time(char *date, char *time)
 
 void DumpCommonAttributes()
 {
-    printf("\nCommon attributes\n");
-    printf("-----------------\n\n");
+    log_msg(LOG_INFO,"\nCommon attributes\n");
+    log_msg(LOG_INFO,"-----------------\n\n");
 
-    printf("what.date          : %s\n",meta->what.date);
-    printf("what.time          : %s\n",meta->what.time);
-    printf("where.sitecode     : %s\n\n",meta->where.sitecode);
+    log_msg(LOG_INFO,"what.date          : %s\n",meta->what.date);
+    log_msg(LOG_INFO,"what.time          : %s\n",meta->what.time);
+    log_msg(LOG_INFO,"where.sitecode     : %s\n\n",meta->where.sitecode);
 
-    printf("where.lon          : %.6f deg\n",meta->where.lon);
-    printf("where.lat          : %.6f deg\n",meta->where.lat);
-    printf("where.height       : %.1f m\n",meta->where.height);
-    printf("where.towerheight  : %.1f m\n\n",meta->where.towerheight);
+    log_msg(LOG_INFO,"where.lon          : %.6f deg\n",meta->where.lon);
+    log_msg(LOG_INFO,"where.lat          : %.6f deg\n",meta->where.lat);
+    log_msg(LOG_INFO,"where.height       : %.1f m\n",meta->where.height);
+    log_msg(LOG_INFO,"where.towerheight  : %.1f m\n\n",meta->where.towerheight);
 
-    printf("how.sw_version     : %s\n",meta->how.sw_version);
-    printf("how.beamwidth      : %.3f deg\n",meta->how.beamwidth);
-    printf("how.wavelength     : %.3f cm\n",meta->how.wavelength);
+    log_msg(LOG_INFO,"how.sw_version     : %s\n",meta->how.sw_version);
+    log_msg(LOG_INFO,"how.beamwidth      : %.3f deg\n",meta->how.beamwidth);
+    log_msg(LOG_INFO,"how.wavelength     : %.3f cm\n",meta->how.wavelength);
     if(meta->how.freeze < DBL_MAX)
-    printf("how.freeze         : %.1f  km\n",meta->how.freeze);
-    printf("how.peakpwr        : %.3f  kW\n",meta->how.peakpwr);
-    printf("how.RAC            : %f dB/km\n",meta->how.RAC);
+    log_msg(LOG_INFO,"how.freeze         : %.1f  km\n",meta->how.freeze);
+    log_msg(LOG_INFO,"how.peakpwr        : %.3f  kW\n",meta->how.peakpwr);
+    log_msg(LOG_INFO,"how.RAC            : %f dB/km\n",meta->how.RAC);
 }
 
 void DumpDatasetAttributes(int iS)
@@ -1307,54 +1751,54 @@ void DumpDatasetAttributes(int iS)
     SetWhere setwhere=meta->dataset[iS].where;
     How sethow=meta->dataset[iS].how;
 
-    printf("\nScan #%d attributes\n",iS+1);
-    printf("------------------\n\n");
-
-    printf("dataset[%d].what.startdate       : %s\n",iS,setwhat.startdate);
-    printf("dataset[%d].what.starttime       : %s\n",iS,setwhat.starttime);
-    printf("dataset[%d].what.enddate         : %s\n",iS,setwhat.enddate);
-    printf("dataset[%d].what.endtime         : %s\n\n",iS,setwhat.endtime);
-
-    printf("dataset[%d].where.bin_elangle    : %ld\n",iS,(long)setwhere.bin_elangle);
-    printf("dataset[%d].where.elangle        : %.2f deg\n",iS,setwhere.elangle);
-    printf("dataset[%d].where.rstart         : %.3f km\n",iS,setwhere.rstart);
-    printf("dataset[%d].where.rscale         : %.2f m\n",iS,setwhere.rscale);
-    printf("dataset[%d].where.nrays          : %ld\n",iS,(long)setwhere.nrays);
-    printf("dataset[%d].where.nbins          : %ld\n",iS,(long)setwhere.nbins);
-    printf("dataset[%d].where.a1gate         : %ld\n\n",iS,(long)setwhere.a1gate);
-
-    printf("dataset[%d].how.task             : %s\n",iS,sethow.task);
-    printf("dataset[%d].how.binmethod_avg    : %ld\n",iS,(long)sethow.binmethod_avg);
-    printf("dataset[%d].how.radhoriz         : %.2f km\n",iS,sethow.radhoriz);
+    log_msg(LOG_INFO,"\nScan #%d attributes\n",iS+1);
+    log_msg(LOG_INFO,"------------------\n\n");
+
+    log_msg(LOG_INFO,"dataset[%d].what.startdate       : %s\n",iS,setwhat.startdate);
+    log_msg(LOG_INFO,"dataset[%d].what.starttime       : %s\n",iS,setwhat.starttime);
+    log_msg(LOG_INFO,"dataset[%d].what.enddate         : %s\n",iS,setwhat.enddate);
+    log_msg(LOG_INFO,"dataset[%d].what.endtime         : %s\n\n",iS,setwhat.endtime);
+
+    log_msg(LOG_INFO,"dataset[%d].where.bin_elangle    : %ld\n",iS,(long)setwhere.bin_elangle);
+    log_msg(LOG_INFO,"dataset[%d].where.elangle        : %.2f deg\n",iS,setwhere.elangle);
+    log_msg(LOG_INFO,"dataset[%d].where.rstart         : %.3f km\n",iS,setwhere.rstart);
+    log_msg(LOG_INFO,"dataset[%d].where.rscale         : %.2f m\n",iS,setwhere.rscale);
+    log_msg(LOG_INFO,"dataset[%d].where.nrays          : %ld\n",iS,(long)setwhere.nrays);
+    log_msg(LOG_INFO,"dataset[%d].where.nbins          : %ld\n",iS,(long)setwhere.nbins);
+    log_msg(LOG_INFO,"dataset[%d].where.a1gate         : %ld\n\n",iS,(long)setwhere.a1gate);
+
+    log_msg(LOG_INFO,"dataset[%d].how.task             : %s\n",iS,sethow.task);
+    log_msg(LOG_INFO,"dataset[%d].how.binmethod_avg    : %ld\n",iS,(long)sethow.binmethod_avg);
+    log_msg(LOG_INFO,"dataset[%d].how.radhoriz         : %.2f km\n",iS,sethow.radhoriz);
     if(POL_H | POL_HV)
-    printf("dataset[%d].how.MDSH (cal I0)    : %.3f dBm\n",iS,sethow.MDSH);
+    log_msg(LOG_INFO,"dataset[%d].how.MDSH (cal I0)    : %.3f dBm\n",iS,sethow.MDSH);
     if(POL_V | POL_HV)
-    printf("dataset[%d].how.MDSV (cal I0)    : %.3f dBm\n",iS,sethow.MDSV);
+    log_msg(LOG_INFO,"dataset[%d].how.MDSV (cal I0)    : %.3f dBm\n",iS,sethow.MDSV);
     if(POL_H | POL_HV)
-    printf("dataset[%d].how.radconstH        : %.3f dB\n",iS,sethow.radconstH);
+    log_msg(LOG_INFO,"dataset[%d].how.radconstH        : %.3f dB\n",iS,sethow.radconstH);
     if(POL_V | POL_HV)
-    printf("dataset[%d].how.radconstHV       : %.3f dB\n",iS,sethow.radconstHV);
+    log_msg(LOG_INFO,"dataset[%d].how.radconstHV       : %.3f dB\n",iS,sethow.radconstHV);
     if(POL_HV)
-    printf("dataset[%d].how.HVratio          : %.3f dBZ\n",iS,sethow.HVratio);
-    printf("dataset[%d].how.NEZ              : %.3f dBZ\n",iS,sethow.NEZ);
-    printf("dataset[%d].how.pulsewidth       : %.3f us\n",iS,sethow.pulsewidth);
-    printf("dataset[%d].how.lowprf           : %.0f Hz\n",iS,sethow.lowprf);
-    printf("dataset[%d].how.highprf          : %.0f Hz\n",iS,sethow.highprf);
-    printf("dataset[%d].how.avgpwr           : %.1f W\n",iS,sethow.avgpwr);
-    printf("dataset[%d].how.UnambVel         : %.3f m/s\n",iS,sethow.UnambVel);
-    printf("dataset[%d].how.NI               : %.3f m/s\n",iS,sethow.NI);
-    printf("dataset[%d].how.rpm              : %.3f RPM, %.3f deg/s\n",iS,sethow.rpm,sethow.rpm*6.0);
-    printf("dataset[%d].how.angres           : %.3f deg\n",iS,sethow.angres);
-    printf("dataset[%d].how.polarization     : %s\n",iS,sethow.polarization);
-    printf("dataset[%d].how.Vsamples         : %ld\n",iS,(long)sethow.Vsamples);
-    printf("dataset[%d].how.Dclutter         : filter #%s\n",iS,sethow.Dclutter);
-    printf("dataset[%d].how.ProcMode         : %s\n",iS,sethow.ProcMode);
-    printf("dataset[%d].how.XMTphase         : %s\n",iS,sethow.XMTphase);
-    printf("dataset[%d].how.SQI              : %.2f\n",iS,sethow.SQI);
-    printf("dataset[%d].how.CSR              : %.2f dB\n",iS,sethow.CSR);
-    printf("dataset[%d].how.LOG              : %.2f dB\n",iS,sethow.LOG);
-    printf("dataset[%d].how.SNRT              : %.2f dB\n",iS,sethow.SNRT);
-    printf("dataset[%d].how.PMI              : %.2f\n\n",iS,sethow.PMI);
+    log_msg(LOG_INFO,"dataset[%d].how.HVratio          : %.3f dBZ\n",iS,sethow.HVratio);
+    log_msg(LOG_INFO,"dataset[%d].how.NEZ              : %.3f dBZ\n",iS,sethow.NEZ);
+    log_msg(LOG_INFO,"dataset[%d].how.pulsewidth       : %.3f us\n",iS,sethow.pulsewidth);
+    log_msg(LOG_INFO,"dataset[%d].how.lowprf           : %.0f Hz\n",iS,sethow.lowprf);
+    log_msg(LOG_INFO,"dataset[%d].how.highprf          : %.0f Hz\n",iS,sethow.highprf);
+    log_msg(LOG_INFO,"dataset[%d].how.avgpwr           : %.1f W\n",iS,sethow.avgpwr);
+    log_msg(LOG_INFO,"dataset[%d].how.UnambVel         : %.3f m/s\n",iS,sethow.UnambVel);
+    log_msg(LOG_INFO,"dataset[%d].how.NI               : %.3f m/s\n",iS,sethow.NI);
+    log_msg(LOG_INFO,"dataset[%d].how.rpm              : %.3f RPM, %.3f deg/s\n",iS,sethow.rpm,sethow.rpm*6.0);
+    log_msg(LOG_INFO,"dataset[%d].how.angres           : %.3f deg\n",iS,sethow.angres);
+    log_msg(LOG_INFO,"dataset[%d].how.polarization     : %s\n",iS,sethow.polarization);
+    log_msg(LOG_INFO,"dataset[%d].how.Vsamples         : %ld\n",iS,(long)sethow.Vsamples);
+    log_msg(LOG_INFO,"dataset[%d].how.Dclutter         : filter #%s\n",iS,sethow.Dclutter);
+    log_msg(LOG_INFO,"dataset[%d].how.ProcMode         : %s\n",iS,sethow.ProcMode);
+    log_msg(LOG_INFO,"dataset[%d].how.XMTphase         : %s\n",iS,sethow.XMTphase);
+    log_msg(LOG_INFO,"dataset[%d].how.SQI              : %.2f\n",iS,sethow.SQI);
+    log_msg(LOG_INFO,"dataset[%d].how.CSR              : %.2f dB\n",iS,sethow.CSR);
+    log_msg(LOG_INFO,"dataset[%d].how.LOG              : %.2f dB\n",iS,sethow.LOG);
+    log_msg(LOG_INFO,"dataset[%d].how.SNRT              : %.2f dB\n",iS,sethow.SNRT);
+    log_msg(LOG_INFO,"dataset[%d].how.PMI              : %.2f\n\n",iS,sethow.PMI);
 }
 
 void DumpDataAttributes(int iS, int iQ)
@@ -1362,24 +1806,24 @@ void DumpDataAttributes(int iS, int iQ)
     DataWhat datawhat=meta->dataset[iS].data[iQ].what;
     DataHow datahow=meta->dataset[iS].data[iQ].how;
 
-    printf("\nQuantity index %s attributes\n",datawhat.quantity);
-    printf("------------------------------\n\n");
+    log_msg(LOG_INFO,"\nQuantity index %s attributes\n",datawhat.quantity);
+    log_msg(LOG_INFO,"------------------------------\n\n");
   
-    printf("dataset[%d].data[%d].what.quantity   : %s\n",iS,iQ,datawhat.quantity);
-    printf("dataset[%d].data[%d].what.QuantIdx   : %d\n",iS,iQ,datawhat.QuantIdx);
-    printf("dataset[%d].data[%d].what.bytes      : %d\n",iS,iQ,datawhat.bytes);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].what.quantity   : %s\n",iS,iQ,datawhat.quantity);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].what.QuantIdx   : %d\n",iS,iQ,datawhat.QuantIdx);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].what.bytes      : %d\n",iS,iQ,datawhat.bytes);
 
     if(datahow.SQI > 0.0)
-    printf("dataset[%d].data[%d].how.SQI         : %.2f\n",iS,iQ,datahow.SQI);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].how.SQI         : %.2f\n",iS,iQ,datahow.SQI);
     if(datahow.CSR < 999.0)
-    printf("dataset[%d].data[%d].how.CSR         : %.2f dB\n",iS,iQ,datahow.CSR);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].how.CSR         : %.2f dB\n",iS,iQ,datahow.CSR);
     if(datahow.LOG > 0.0)
-    printf("dataset[%d].data[%d].how.LOG         : %.2f dB\n",iS,iQ,datahow.LOG);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].how.LOG         : %.2f dB\n",iS,iQ,datahow.LOG);
     if(datahow.SNRT > 0.0)
-    printf("dataset[%d].data[%d].how.SNRT         : %.2f dB\n",iS,iQ,datahow.SNRT);
+    log_msg(LOG_INFO,"dataset[%d].data[%d].how.SNRT         : %.2f dB\n",iS,iQ,datahow.SNRT);
     if(datahow.PMI > 0.0)
-    printf("dataset[%d].data[%d].how.PMI         : %.2f\n",iS,iQ,datahow.PMI);
-    printf("\n");
+    log_msg(LOG_INFO,"dataset[%d].data[%d].how.PMI         : %.2f\n",iS,iQ,datahow.PMI);
+    log_msg(LOG_INFO,"\n");
 }
 
 void DumpAllAttributes()
@@ -1390,7 +1834,7 @@ void DumpAllAttributes()
    for(iS=0;iS<scans;iS++)
    { 
         DumpDatasetAttributes(iS);
-        for(iQ=0;iQ<quantities;iQ++) DumpDataAttributes(iS,iQ);
+        for(iQ=0;iQ<meta->dataset[iS].quantities;iQ++) DumpDataAttributes(iS,iQ);
    }
 }   
 
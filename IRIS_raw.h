@@ -0,0 +1,157 @@
+/*! \file IRIS_raw.h
+\brief Record reader of IRIS RAW products, used by <I>IRIS_decoder.c</I> and <I>IRIS_bench.c</I>.
+
+The product is accessed thru a pointer to the mapped file. Data following the two header
+records is a stream of bytes split to 6144 byte records, each starting with a raw_prod_bhdr.
+get_raw_bytes() reads the stream from the position irec_c, ioff_c and is given to
+uncompress_cowords() of the IRIS library as the input routine. skip_cowords() passes a
+compressed ray without expanding it.<BR>
+
+A product still being written by IRIS is read in tail mode: tail_open() maps the file for the
+largest possible product (RAW_MAX_RECORDS records) and get_raw_bytes() waits at each record
+boundary until the record is in the file. If the file does not grow in tail_timeout seconds
+the product is taken as broken, as is a truncated file without tail mode.<BR>
+Include after the IRIS headers.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* record numbers of raw_prod_bhdr are 16-bit */
+#define RAW_MAX_RECORDS 32767
+#define RAW_MAX_BYTES ((SINT4)RAW_MAX_RECORDS * TAPE_RECORD_LEN)
+
+#define PRODPTR( IREC, IOFF ) \
+  ((UINT1 *)(prod_c + (IREC * TAPE_RECORD_LEN) + IOFF))
+
+SINT4  irec_c ;         /**<\brief Record number (history: 6144 byte tape records) */
+SINT4  ioff_c ;         /**<\brief Offset within record */
+UINT1 *prod_c ;         /**<\brief Pointer to RAW product */
+int    tail_fd = -1 ;   /**<\brief File of the product in tail mode, -1 if not in tail mode */
+double tail_timeout = 60.0 ; /**<\brief Seconds to wait for the file to grow in tail mode */
+long   tail_poll_ms = 200 ;  /**<\brief Poll interval of the file size in tail mode */
+
+/* ================================================== */
+/** In tail mode waits until the product has records up to <I>irec</I>. Exits if the file
+ * does not grow in tail_timeout seconds.
+ */
+void wait_raw_record( SINT4 irec )
+{
+  struct stat st ;
+  off_t lastsize = -1 ;
+  double waited = 0.0 ;
+  struct timespec poll ;
+
+  if( tail_fd < 0 ) return ;
+  poll.tv_sec = tail_poll_ms / 1000 ;
+  poll.tv_nsec = (tail_poll_ms % 1000) * 1000000L ;
+  while( 1 ) {
+    if( fstat( tail_fd, &st ) ) { perror( "fstat" ) ; exit(1) ; }
+    if( st.st_size >= (off_t)(irec + 1) * TAPE_RECORD_LEN ) return ;
+    if( st.st_size != lastsize ) { lastsize = st.st_size ; waited = 0.0 ; }
+    if( waited >= tail_timeout || irec >= RAW_MAX_RECORDS ) {
+      fprintf( stderr, "Product ended at block %d, no data for %.0f s\n",
+               (int)(st.st_size / TAPE_RECORD_LEN), waited ) ;
+      exit(1) ;
+    }
+    nanosleep( &poll, NULL ) ;
+    waited += 0.001 * tail_poll_ms ;
+  }
+}
+
+/* ================================================== */
+/** Opens a product being written for reading in tail mode, waiting for its header records.
+ * Returns the pointer to the product, NULL if failed.
+ */
+UINT1 *tail_open( const char *path )
+{
+  void *p ;
+
+  tail_fd = open( path, O_RDONLY ) ;
+  if( tail_fd < 0 ) return( NULL ) ;
+  /* Pages past the end of file become readable when the file grows. Private and writable
+   * as imapopen(), the headers are modified by the decoder. Pages not modified show the
+   * data appended to the file (Linux). */
+  p = mmap( NULL, RAW_MAX_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE, tail_fd, 0 ) ;
+  if( p == MAP_FAILED ) { close( tail_fd ) ; tail_fd = -1 ; return( NULL ) ; }
+  wait_raw_record( 1 ) ;
+  return( (UINT1 *)p ) ;
+}
+
+/* ================================================== */
+/** Closes a product opened with tail_open() */
+void tail_close( UINT1 *p )
+{
+  munmap( p, RAW_MAX_BYTES ) ;
+  close( tail_fd ) ;
+  tail_fd = -1 ;
+}
+
+/* ================================================== */
+/** Gives the bytes of the product left after the current position. The size in the
+ * product header is not final while the product is written, in tail mode the limit is the
+ * largest possible product.
+ */
+SINT4 raw_bytes_left( SINT4 ibytes )
+{
+  SINT4 pos = (irec_c * TAPE_RECORD_LEN) + ioff_c ;
+
+  if( tail_fd >= 0 && ibytes < RAW_MAX_BYTES ) ibytes = RAW_MAX_BYTES ;
+  return( ibytes - pos ) ;
+}
+
+/* ================================================== */
+/** Co-Routine to read the next run of bytes from the raw product file,
+ * skipping and checking the record headers as we go. If buf_a is NULL
+ * the bytes are skipped.
+ */
+void get_raw_bytes( SINT2 *buf_a, SINT4 icnt_a )
+{
+  SINT4 icnt, iremain = icnt_a ; UINT1 *pbuf = (UINT1 *)buf_a ;
+
+  while( iremain > 0 ) {
+    /* If the offset is zero, then get the next record header and
+     * compare the record numbers.  Exit if there is a mismatch.
+     */
+    if( ioff_c == 0 ) {
+      struct raw_prod_bhdr bhdr ;
+      wait_raw_record( irec_c ) ;
+      memcpy( (void *)&bhdr, PRODPTR(irec_c, ioff_c), RAW_PROD_BHDR_SIZE ) ;
+      if( bhdr.irec != irec_c ) {
+        fprintf( stderr,  "Block header mismatch (%d) at block %d\n",
+                 bhdr.irec, irec_c ) ; exit(1) ;
+      }
+      ioff_c += RAW_PROD_BHDR_SIZE ;
+    }
+
+    /* Extract as many bytes out of this record as we can.  Bump record
+     * number and zero the offset if we read it all.
+     */
+    icnt = TAPE_RECORD_LEN - ioff_c ;
+    if( icnt > iremain ) icnt = iremain ;
+
+    if( pbuf ) { memcpy( pbuf, PRODPTR(irec_c, ioff_c), icnt ) ; pbuf += icnt ; }
+    iremain -= icnt ; ioff_c += icnt ;
+
+    if( ioff_c == TAPE_RECORD_LEN ) { ioff_c = 0 ; irec_c++ ; }
+  }
+}
+
+/* ================================================== */
+/** Skips the compressed cowords of one ray, as uncompress_cowords() would read them,
+ * without expanding the ray. Returns the number of input words.
+ */
+SINT4 skip_cowords( void )
+{
+  UINT2 code ; SINT4 inlen = 0 ;
+
+  while( 1 ) {
+    get_raw_bytes( (SINT2 *)&code, 2 ) ; inlen++ ;
+    if( code == 1 ) break ;                    /* end of ray */
+    if( code & 0x8000 ) {                      /* data words follow, zero runs have none */
+      get_raw_bytes( NULL, 2 * (code & 0x7FFF) ) ; inlen += code & 0x7FFF ;
+    }
+  }
+  return( inlen ) ;
+}
@@ -0,0 +1,743 @@
+/*! \file IRIS_rawgen.c
+\brief Program to generate synthetic IRIS RAW products for performance and scaling tests
+of <I>IRIS_decoder.c</I> and <I>ODIM_encoder.c</I>
+
+The generated file is a volume RAW product of one subtask: product header, ingest header,
+and per sweep the ingest data headers followed by the compressed rays of all moments, in
+6144 byte records like IRIS writes them. The decoder reads it like any RAW product.<BR>
+The moment fields are a simple synthetic weather situation: convective cells and a stratiform
+rain area with a melting layer, ground clutter near the radar and a uniform wind with height
+shear, all with noise. Outside of echoes the bins are empty, so the data compresses about like
+real data. The same seed (option -R) always gives the same product.
+
+Like IRIS_decoder.c the program is compiled against the IRIS headers and libraries.
+
+<B>Options:</B><BR>
+<B>-h</B> : usage <BR>
+<B>-v</B> : verbose output <BR>
+<B>-s sweeps</B> : number of sweeps (default 10) <BR>
+<B>-e list</B> : comma-separated elevation angles [deg], sets also the number of sweeps <BR>
+<B>-r rays</B> : rays per sweep (default 360) <BR>
+<B>-b bins</B> : range bins per ray (default 500) <BR>
+<B>-g step</B> : range bin step [m] (default 500) <BR>
+<B>-a avg</B> : range averaging factor of input bins (default 1) <BR>
+<B>-m list</B> : comma-separated IRIS moments, 2 at the end for 2-byte data, e.g.
+DBT2,DBZ2,VEL2,WIDTH2,ZDR2,KDP2,PHIDP2,RHOHV2,SQI2,HCLASS2 (default DBT2,DBZ2,VEL2,WIDTH2,ZDR2) <BR>
+<B>-p mode</B> : PRF mode 1 (single), 23, 34 or 45 (dual-PRF ratios, default 1) <BR>
+<B>-f prf</B> : (high) PRF [Hz] (default 1000) <BR>
+<B>-P pol</B> : polarization H, V, HV (alternating) or SIM (simultaneous, default) <BR>
+<B>-S site</B> : IRIS site name, first three letters are the site code (default VAN) <BR>
+<B>-t time</B> : volume start time YYYYMMDDhhmm (default 201303151250) <BR>
+<B>-x fraction</B> : fraction of missing rays (default 0) <BR>
+<B>-X</B> : include extended headers (XHDR) <BR>
+<B>-R seed</B> : random seed (default 1) <BR>
+
+ The last argument is the output RAW file path.<BR>
+ <B>Example:</B> ./IRIS_rawgen -s 20 -r 3600 -b 2000 -g 125 -m DBZ2,VEL2,WIDTH2,ZDR2,RHOHV2 big.raw
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include "sig_data_types.h"
+#include "sigtypes.h"
+#include "dsp.h"
+#include "headers.h"
+#include "iris_task.h"
+#include "ingest.h"
+#include "product.h"
+#include "setup.h"
+#include "user_lib.h"
+#include "dsp_lib.h"
+
+# define MAX_GEN_MOMENTS 32
+# define MAX_GEN_SWEEPS 100
+# define MAX_CELLS 12
+# define EARTH_R43 8494.7 /**<\brief 4/3 earth radius [km] for beam height */
+# define MELT_H 2.0 /**<\brief melting layer height [km] */
+
+/*! Synthetic field from which a moment is encoded */
+enum { F_DBT, F_DBZ, F_VEL, F_WIDTH, F_ZDR, F_KDP, F_PHIDP, F_RHOHV, F_SQI, F_HCLASS, F_FIELDS };
+
+/*!\struct MomentDef
+\brief IRIS moment which the generator can write
+*/
+typedef struct {
+                  const char *name; /*!< name in option -m */
+                  SINT4 type;       /*!< IRIS data type DB_* */
+                  int bytes;        /*!< bytes per bin */
+                  int field;        /*!< synthetic field F_* */
+                  int filtered;     /*!< TRUE if clutter is removed from the moment */
+               } MomentDef;
+
+static const MomentDef moment_defs[] = {
+   {"DBT",DB_DBT,1,F_DBT,0},          {"DBT2",DB_DBT2,2,F_DBT,0},
+   {"DBZ",DB_DBZ,1,F_DBZ,1},          {"DBZ2",DB_DBZ2,2,F_DBZ,1},
+   {"DBZC",DB_DBZC,1,F_DBZ,1},        {"DBZC2",DB_DBZC2,2,F_DBZ,1},
+   {"VEL",DB_VEL,1,F_VEL,0},          {"VEL2",DB_VEL2,2,F_VEL,0},
+   {"VELC",DB_VELC,1,F_VEL,1},        {"VELC2",DB_VELC2,2,F_VEL,1},
+   {"WIDTH",DB_WIDTH,1,F_WIDTH,0},    {"WIDTH2",DB_WIDTH2,2,F_WIDTH,0},
+   {"ZDR",DB_ZDR,1,F_ZDR,0},          {"ZDR2",DB_ZDR2,2,F_ZDR,0},
+   {"KDP",DB_KDP,1,F_KDP,0},          {"KDP2",DB_KDP2,2,F_KDP,0},
+   {"PHIDP",DB_PHIDP,1,F_PHIDP,0},    {"PHIDP2",DB_PHIDP2,2,F_PHIDP,0},
+   {"RHOHV",DB_RHOHV,1,F_RHOHV,0},    {"RHOHV2",DB_RHOHV2,2,F_RHOHV,0},
+   {"SQI",DB_SQI,1,F_SQI,0},          {"SQI2",DB_SQI2,2,F_SQI,0},
+   {"HCLASS",DB_HCLASS,1,F_HCLASS,0}, {"HCLASS2",DB_HCLASS2,2,F_HCLASS,0},
+   {NULL,0,0,0,0}
+};
+
+/*!\struct Cell
+\brief Convective cell of the synthetic weather
+*/
+typedef struct {
+                  double x,y;   /*!< center [km] */
+                  double rad;   /*!< radius [km] */
+                  double peak;  /*!< peak reflectivity [dBZ] */
+                  double top;   /*!< echo top [km] */
+               } Cell;
+
+int VERB=FALSE; /**<\brief Set TRUE if option -v given */
+int sweeps=10, rays=360, bins=500, binstep=500, binavg=1, prfmode=1, prf=1000;
+int XHDR=FALSE;
+double missing_frac=0.0;
+double elevs[MAX_GEN_SWEEPS];
+const MomentDef *moments[MAX_GEN_MOMENTS];
+int nmoments;
+SINT2 ipolar=POL_SIMULTANEOUS, itrig=PRF_1_1;
+SINT4 ilambda=531; /**<\brief wavelength [1/100 cm] */
+char sitename[16]="VAN";
+char voltime[20]="201303151250";
+double NyqV, NyqW, VaH, VaL;
+Cell cells[MAX_CELLS];
+int ncells;
+double strat_az0,strat_az1;
+double wind_to;
+
+FILE *RAWF; /**<\brief Output RAW file */
+UINT1 rec_c[TAPE_RECORD_LEN]; /**<\brief Record under construction */
+SINT4 irec_c;  /**<\brief Record number */
+SINT4 ioff_c;  /**<\brief Offset within record */
+SINT2 isweep_c; /**<\brief Sweep number written to record headers */
+
+static uint64_t rng_state=1;
+
+/** \brief Uniform random number in [0,1) (xorshift64*) */
+static double urand(void)
+{
+   rng_state ^= rng_state >> 12;
+   rng_state ^= rng_state << 25;
+   rng_state ^= rng_state >> 27;
+   return((double)((rng_state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0);
+}
+
+/** \brief Uniform random number in [-1,1) */
+static double srand1(void) { return(2.0*urand()-1.0); }
+
+static BIN2 bin2_from_deg(double deg)
+{
+   deg=fmod(deg,360.0);
+   if(deg<0) deg+=360.0;
+   return((BIN2)((UINT4)(deg*65536.0/360.0+0.5) & 0xFFFF));
+}
+
+static BIN4 bin4_from_deg(double deg)
+{
+   deg=fmod(deg,360.0);
+   if(deg<0) deg+=360.0;
+   return((BIN4)(deg*4294967296.0/360.0));
+}
+
+/** \brief Sets data type <I>type</I> in DSP data mask. The mask words in file order are
+word 0 (types 0-31), extended header type, and words 1-4 (types 32-159). */
+static void mask_set(struct dsp_data_mask *mask, SINT4 type)
+{
+   UINT4 *w=(UINT4 *)mask;
+
+   if(type<32) w[0] |= 1U<<type;
+   else w[1+type/32] |= 1U<<(type%32);
+}
+
+/** \brief Writes the current record (if any bytes in it) and starts a new one */
+static void flush_record(void)
+{
+   if(!ioff_c) return;
+   if(fwrite(rec_c,TAPE_RECORD_LEN,1,RAWF)!=1) { fprintf(stderr,"ERROR: Write failed at record %d\n",irec_c); exit(1); }
+   irec_c++;
+   ioff_c=0;
+}
+
+/** \brief Counterpart of get_raw_bytes() of the decoder: puts bytes to records, each
+record starting with a raw_prod_bhdr */
+static void put_raw_bytes(const void *buf, SINT4 icnt)
+{
+   const UINT1 *pbuf=buf;
+
+   while(icnt>0)
+   {
+     SINT4 n;
+
+     if(ioff_c==0)
+     {
+        struct raw_prod_bhdr bhdr;
+
+        if(irec_c>32767)
+        {
+           fprintf(stderr,"ERROR: Product exceeds 32767 records (16-bit record number of block header)\n");
+           exit(1);
+        }
+        memset(rec_c,0,TAPE_RECORD_LEN);
+        memset(&bhdr,0,sizeof(bhdr));
+        bhdr.irec=irec_c;
+        bhdr.isweep=isweep_c;
+        memcpy(rec_c,&bhdr,RAW_PROD_BHDR_SIZE);
+        ioff_c=RAW_PROD_BHDR_SIZE;
+     }
+     n=TAPE_RECORD_LEN-ioff_c;
+     if(n>icnt) n=icnt;
+     memcpy(rec_c+ioff_c,pbuf,n);
+     icnt-=n; ioff_c+=n; pbuf+=n;
+     if(ioff_c==TAPE_RECORD_LEN) flush_record();
+   }
+}
+
+/** \brief Compresses <I>n</I> words to IRIS cowords: 0x8000+N is followed by N data words,
+2-0x7FFF is a run of zero words and 0x0001 ends the ray. Returns number of cowords. */
+static long compress_cowords(const UINT2 *in, long n, UINT2 *out)
+{
+   long i=0,k=0,start,z;
+
+   while(i<n)
+   {
+      /* zero run of two or more words */
+      for(z=0;i+z<n && in[i+z]==0 && z<0x7FFF;z++);
+      if(z>=2) { out[k++]=(UINT2)z; i+=z; continue; }
+
+      /* data run ends where next zero run begins */
+      start=i;
+      while(i<n && i-start<0x7FFF && !(in[i]==0 && i+1<n && in[i+1]==0)) i++;
+      out[k++]=(UINT2)(0x8000|(i-start));
+      memcpy(&out[k],&in[start],(i-start)*2);
+      k+=i-start;
+   }
+   out[k++]=1;
+   return(k);
+}
+
+/** \brief Converts a physical value of field to IRIS bin value. 0 is reserved for no data. */
+static UINT2 encode_bin(int field, int bytes, double x)
+{
+   double N,maxN=(bytes==1) ? 255.0 : 65535.0;
+
+   switch(field)
+   {
+      case F_DBT: case F_DBZ:
+        N = (bytes==1) ? 2.0*x+64.0 : 100.0*x+32768.0;
+      break;
+      case F_VEL:
+        N = (bytes==1) ? 128.0+127.0*x/NyqV : 100.0*x+32768.0;
+      break;
+      case F_WIDTH:
+        N = (bytes==1) ? 256.0*x/NyqW : 100.0*x;
+      break;
+      case F_ZDR:
+        N = (bytes==1) ? 16.0*x+128.0 : 100.0*x+32768.0;
+      break;
+      case F_KDP:
+        if(bytes==2) N=100.0*x+32768.0;
+        else
+        {
+          /* 1-byte KDP is logarithmic: |KDP| = 0.25*600^((N-129)/126)/lambda[cm] */
+          double a=fabs(x)*0.01*(double)ilambda/0.25;
+
+          if(a<1.0) N=128.0;
+          else if(x>0) N=129.0+126.0*log(a)/log(600.0);
+          else N=127.0-126.0*log(a)/log(600.0);
+        }
+      break;
+      case F_PHIDP:
+        N = (bytes==1) ? 1.0+254.0*fmod(x,180.0)/180.0 : 1.0+65534.0*fmod(x,360.0)/360.0;
+      break;
+      case F_RHOHV: case F_SQI:
+        N = (bytes==1) ? 1.0+253.0*x*x : 1.0+65533.0*x;
+      break;
+      default:
+        N = x;
+      break;
+   }
+   if(N<1.0) N=1.0;
+   if(N>maxN) N=maxN;
+   return((UINT2)(N+0.5));
+}
+
+/** \brief Places the convective cells, stratiform area and wind of the weather situation */
+static void init_weather(void)
+{
+   double maxr=1.0e-3*(double)binstep*bins;
+   int i;
+
+   ncells=4+(int)(urand()*(MAX_CELLS-4));
+   for(i=0;i<ncells;i++)
+   {
+      double r=maxr*(0.1+0.8*urand()), a=2.0*M_PI*urand();
+
+      cells[i].x=r*sin(a);
+      cells[i].y=r*cos(a);
+      cells[i].rad=3.0+12.0*urand();
+      cells[i].peak=35.0+25.0*urand();
+      cells[i].top=6.0+8.0*urand();
+   }
+   strat_az0=360.0*urand();
+   strat_az1=strat_az0+60.0+90.0*urand();
+   wind_to=360.0*urand();
+}
+
+/** \brief Computes all synthetic fields of one ray. <I>echo</I> tells which bins have
+weather (1), clutter only (2) or nothing (0). */
+static void synth_ray(int iAz, double az, double el, double *F[F_FIELDS], UINT1 *echo)
+{
+   double saz=sin(az*M_PI/180.0), caz=cos(az*M_PI/180.0);
+   double sel=sin(el*M_PI/180.0), cel=cos(el*M_PI/180.0);
+   double relaz=fmod(az-strat_az0+360.0,360.0);
+   int in_strat=(relaz < strat_az1-strat_az0);
+   double phi=20.0+2.0*srand1();
+   int b,c;
+
+   for(b=0;b<bins;b++)
+   {
+      double r=1.0e-3*(double)binstep*(b+0.5);
+      double h=r*sel + r*r/(2.0*EARTH_R43);
+      double x=r*cel*saz, y=r*cel*caz;
+      double z=-100.0, sens=-35.0+20.0*log10(r);
+      double clut=0.0;
+      int is_clutter;
+
+      for(c=0;c<ncells;c++)
+      {
+         double dx=x-cells[c].x, dy=y-cells[c].y, d2=dx*dx+dy*dy, rr=cells[c].rad*cells[c].rad;
+         double zc;
+
+         if(d2>4.0*rr || h>cells[c].top+2.0) continue;
+         zc=cells[c].peak*(1.0-0.25*d2/rr);
+         if(h>cells[c].top) zc-=10.0*(h-cells[c].top);
+         if(zc>z) z=zc;
+      }
+      if(in_strat && r>20.0 && h<7.0)
+      {
+         double zs=28.0-3.0*fabs(h-MELT_H);
+
+         if(fabs(h-MELT_H)<0.3) zs+=8.0; /* bright band */
+         if(zs>z) z=zs;
+      }
+      z+=1.5*srand1();
+
+      is_clutter=(r<15.0 && h<0.5 && urand()<0.3);
+      if(is_clutter) clut=20.0+20.0*urand();
+
+      if(z>sens && h<15.0) echo[b]=1; else echo[b]=is_clutter ? 2 : 0;
+      if(!echo[b]) continue;
+
+      F[F_DBZ][b]=z;
+      F[F_DBT][b]=(echo[b]==1) ? (is_clutter ? 10.0*log10(pow(10.0,0.1*z)+pow(10.0,0.1*clut)) : z) : clut;
+
+      {
+         double v=(10.0+2.0*h)*cos((az-wind_to)*M_PI/180.0)*cel + 0.7*srand1();
+
+         /* dual-PRF unfolding errors, multiples of 2*Va of high or low PRF ray */
+         if(prfmode!=1 && urand()<0.02) v+=((iAz&1) ? 2.0*VaL : 2.0*VaH)*(urand()<0.5 ? -1.0 : 1.0);
+         if(echo[b]==2) v=0.3*srand1();
+         v-=2.0*NyqV*floor((v+NyqV)/(2.0*NyqV));
+         F[F_VEL][b]=v;
+      }
+      F[F_WIDTH][b]=(echo[b]==2) ? 0.3 : 0.5+0.02*(z>0 ? z : 0)+0.5*urand();
+      F[F_ZDR][b]=(echo[b]==2) ? 3.0*srand1() : 0.2+0.04*(z-20.0)+0.3*srand1();
+      if(F[F_ZDR][b]<-1.0) F[F_ZDR][b]=-1.0;
+      F[F_RHOHV][b]=(echo[b]==2) ? 0.6+0.2*urand() :
+                    (fabs(h-MELT_H)<0.3 ? 0.92 : 0.985)-0.01*urand();
+      F[F_SQI][b]=(z-sens>30.0) ? 0.95 : 0.3+0.65*(z-sens)/30.0;
+      if(F[F_SQI][b]<0.0) F[F_SQI][b]=0.0;
+      F[F_KDP][b]=(echo[b]==1 && z>35.0) ? 0.05*pow(10.0,(z-35.0)/12.0) : 0.05*srand1();
+      phi+=2.0*F[F_KDP][b]*1.0e-3*(double)binstep;
+      F[F_PHIDP][b]=phi+2.0*srand1();
+      if(echo[b]==2) F[F_HCLASS][b]=1;
+      else if(h>MELT_H+0.3) F[F_HCLASS][b]=4;
+      else if(h>MELT_H-0.3) F[F_HCLASS][b]=3;
+      else if(z>52.0) F[F_HCLASS][b]=6;
+      else F[F_HCLASS][b]=2;
+   }
+}
+
+/** \brief Sets ymds_time from UNIX seconds */
+static void ymds_from_secs(struct ymds_time *ymds, time_t secs)
+{
+   struct tm Sdd;
+
+   gmtime_r(&secs,&Sdd);
+   memset(ymds,0,sizeof(*ymds));
+   ymds->isec=Sdd.tm_hour*3600+Sdd.tm_min*60+Sdd.tm_sec;
+   ymds->iyear=Sdd.tm_year+1900;
+   ymds->imon=Sdd.tm_mon+1;
+   ymds->iday=Sdd.tm_mday;
+}
+
+void usage( void );
+static void parse_args(int argc, char *argv[]);
+
+/* ================================================== */
+/** Exit status will be "1" for any kind of error, "0" for successful return.
+*/
+int main( int argc, char *argv[] )
+{
+  union raw_record hdrs[2];
+  struct product_hdr *prodhdr=&hdrs[0].PHeader;
+  struct ingest_header *inghdr=&hdrs[1].IHeader;
+  struct tm Sdd;
+  time_t volsecs,sweepsecs;
+  double antspeed=12.0, *F[F_FIELDS];
+  UINT1 *echo;
+  UINT2 *words,*cw;
+  long nwords,rays_written=0,rays_missing=0,iM;
+  int iS,iAz,f;
+
+  parse_args(argc,argv);
+
+  for(f=0;f<F_FIELDS;f++) F[f]=calloc(bins,sizeof(double));
+  echo=calloc(bins,1);
+  nwords=sizeof(struct ray_header)/2 + (bins*2+1)/2;
+  words=calloc(nwords,2);
+  cw=calloc(2*nwords+8,2);
+
+  memset(&Sdd,0,sizeof(Sdd));
+  if(sscanf(voltime,"%4d%2d%2d%2d%2d",&Sdd.tm_year,&Sdd.tm_mon,&Sdd.tm_mday,&Sdd.tm_hour,&Sdd.tm_min)!=5)
+  {
+     fprintf(stderr,"ERROR: Time %s is not YYYYMMDDhhmm\n",voltime); exit(1);
+  }
+  Sdd.tm_year-=1900;
+  Sdd.tm_mon--;
+  volsecs=timegm(&Sdd);
+
+  NyqV=fNyquistVelocity(prf,itrig,ilambda,ipolar);
+  NyqW=fNyquistWidth(prf,ilambda,ipolar);
+  VaH=0.0025*0.01*(double)ilambda*prf;
+  VaL=0.0025*0.01*(double)ilambda*fPrfLowFromHighCase(prf,itrig);
+  init_weather();
+
+  /* Product header and ingest header records. Product size is rewritten at end. */
+  memset(hdrs,0,sizeof(hdrs));
+  prodhdr->hdr.id=ST_PRODUCT_HDR;
+  prodhdr->hdr.ibytes=0;
+  prodhdr->pcf.psi.raw.iflags=0; /* all sweeps */
+  prodhdr->end.iprf=prf;
+  prodhdr->end.itrig=itrig;
+  prodhdr->end.ipolar=ipolar;
+  prodhdr->end.ilambda=ilambda;
+
+  inghdr->hdr.id=ST_INGEST_HDR;
+  inghdr->icf.irtotl=rays;
+  ymds_from_secs(&inghdr->icf.VolumeYmds,volsecs);
+  snprintf(inghdr->icf.sSitename,sizeof(inghdr->icf.sSitename),"%s",sitename);
+  snprintf(inghdr->icf.siris_version,sizeof(inghdr->icf.siris_version),"8.13");
+  inghdr->icf.ilat=bin4_from_deg(60.2706);
+  inghdr->icf.ilon=bin4_from_deg(24.8690);
+  inghdr->icf.ialtitude=8300;  /* cm */
+  inghdr->icf.irad_hgt=30;     /* m */
+  inghdr->icf.iMeltingHeight=0x8000 ^ (UINT2)(1000.0*MELT_H);
+
+  inghdr->tcf.hdr.id=ST_TASK_CONF;
+  {
+     char stname[12];
+
+     memset(stname,' ',12);
+     memcpy(stname,"PPI_SYNTH",9);
+     memcpy(inghdr->tcf.end.stname,stname,12);
+  }
+  inghdr->tcf.misc.iHorzBeamWidth=bin4_from_deg(0.95);
+  inghdr->tcf.misc.iVertBeamWidth=bin4_from_deg(0.95);
+  inghdr->tcf.misc.ilambda=ilambda;
+  inghdr->tcf.misc.ixmt_pwr=250000; /* W */
+  inghdr->tcf.rng.ibin_first=0;
+  inghdr->tcf.rng.ibin_last=binstep*bins*100; /* cm */
+  inghdr->tcf.rng.ibin_out_num=bins;
+  inghdr->tcf.rng.ibin_in_num=bins*binavg;
+  inghdr->tcf.rng.ibin_out_step=binstep*100;
+  inghdr->tcf.scan.isweeps=sweeps;
+  inghdr->tcf.scan.iscan_speed=bin2_from_deg(antspeed);
+  inghdr->tcf.scan.ires1000=(SINT2)(360000.0/rays+0.5);
+  inghdr->tcf.dsp.ipw=80;   /* 1/100 us */
+  inghdr->tcf.dsp.isamp=(prfmode==1) ? 50 : 40;
+  inghdr->tcf.dsp.igas_atten=1600; /* 1/100000 dB/km */
+  inghdr->tcf.cal.iI0Horiz=-11000;
+  inghdr->tcf.cal.iI0Vert=-11000;
+  inghdr->tcf.cal.iRadarConstantHoriz=7000;
+  inghdr->tcf.cal.iRadarConstantVert=7000;
+  inghdr->tcf.cal.iReceiverBandwidth=700;
+  inghdr->tcf.cal.isqi_thr=(SINT2)(0.45*256);
+  inghdr->tcf.cal.iccr_thr=-(SINT2)(18*16);
+  inghdr->tcf.cal.izns_thr=(SINT2)(2.5*16);
+  inghdr->tcf.cal.isig_thr=(SINT2)(2*16);
+  inghdr->GParm.iz_calib=-(SINT2)(45*16);
+  inghdr->GParm.inse_hv_ratio=100;
+
+  if(XHDR) mask_set(&inghdr->tcf.dsp.DataMask,DB_XHDR);
+  for(iM=0;iM<nmoments;iM++)
+  {
+     mask_set(&inghdr->tcf.dsp.DataMask,moments[iM]->type);
+     if(!lDspMaskTest(&inghdr->tcf.dsp.DataMask,moments[iM]->type))
+     {
+        fprintf(stderr,"ERROR: DSP data mask layout of the IRIS headers not recognized\n"); exit(1);
+     }
+  }
+
+  RAWF=fopen(argv[argc-1],"w");
+  if(!RAWF) { fprintf(stderr,"ERROR: Could not open %s for writing\n",argv[argc-1]); exit(1); }
+  fwrite(hdrs,sizeof(hdrs),1,RAWF);
+  irec_c=2;
+  ioff_c=0;
+
+  sweepsecs=volsecs;
+  for(iS=0;iS<sweeps;iS++)
+  {
+     int first_ray=(int)(urand()*rays);
+     double rotsecs=360.0/antspeed;
+     BIN2 iel=bin2_from_deg(elevs[iS]);
+
+     isweep_c=iS+1;
+
+     /* ingest data headers for each recorded type, in data type order */
+     for(iM=-1;iM<nmoments;iM++)
+     {
+        struct ingest_data_header idh;
+        UINT1 buf[INGEST_DATA_HEADER_SIZE];
+
+        if(iM<0 && !XHDR) continue;
+        memset(&idh,0,sizeof(idh));
+        idh.hdr.id=ST_INGEST_DATA;
+        idh.hdr.ibytes=INGEST_DATA_HEADER_SIZE;
+        ymds_from_secs(&idh.time,sweepsecs);
+        idh.isndx=iS+1;
+        idh.ibits_bin=(iM<0) ? 16 : 8*moments[iM]->bytes;
+        idh.iangle=iel;
+        memset(buf,0,sizeof(buf));
+        memcpy(buf,&idh,sizeof(idh)<sizeof(buf) ? sizeof(idh) : sizeof(buf));
+        put_raw_bytes(buf,INGEST_DATA_HEADER_SIZE);
+     }
+
+     for(iAz=0;iAz<rays;iAz++)
+     {
+        struct ray_header rhdr;
+        double az0=360.0*iAz/rays, az1=360.0*(iAz+1)/rays;
+        double jit=0.02*srand1();
+        /* ray 0 is never missing, the decoder takes the ray size from it */
+        int missing=(iAz>0 && urand()<missing_frac);
+
+        rhdr.iaz_start=bin2_from_deg(az0);
+        rhdr.iaz_end=bin2_from_deg(az1);
+        rhdr.iel_start=bin2_from_deg(elevs[iS]+jit);
+        rhdr.iel_end=bin2_from_deg(elevs[iS]+jit);
+        rhdr.ibincount=bins;
+        rhdr.itime=(UINT2)(rotsecs*(double)((iAz-first_ray+rays)%rays)/rays);
+
+        if(!missing) synth_ray(iAz,0.5*(az0+az1),elevs[iS],F,echo);
+
+        if(XHDR)
+        {
+          if(missing) { UINT2 eor=1; put_raw_bytes(&eor,2); }
+          else
+          {
+            SINT4 ms=(SINT4)(1000.0*rhdr.itime);
+            long n=sizeof(struct ray_header)/2+2;
+
+            memcpy(words,&rhdr,sizeof(rhdr));
+            memcpy(&words[sizeof(struct ray_header)/2],&ms,4);
+            ((struct ray_header *)words)->ibincount=2;
+            n=compress_cowords(words,n,cw);
+            put_raw_bytes(cw,n*2);
+          }
+        }
+
+        for(iM=0;iM<nmoments;iM++)
+        {
+           const MomentDef *md=moments[iM];
+           long n,b;
+
+           if(missing) { UINT2 eor=1; put_raw_bytes(&eor,2); continue; }
+
+           memset(words,0,nwords*2);
+           memcpy(words,&rhdr,sizeof(rhdr));
+           if(md->bytes==1)
+           {
+              UINT1 *d=(UINT1 *)&words[sizeof(struct ray_header)/2];
+              for(b=0;b<bins;b++) if(echo[b]==1 || (echo[b]==2 && !md->filtered))
+                 d[b]=(UINT1)encode_bin(md->field,1,F[md->field][b]);
+              n=sizeof(struct ray_header)/2 + (bins+1)/2;
+           }
+           else
+           {
+              UINT2 *d=&words[sizeof(struct ray_header)/2];
+              for(b=0;b<bins;b++) if(echo[b]==1 || (echo[b]==2 && !md->filtered))
+                 d[b]=encode_bin(md->field,2,F[md->field][b]);
+              n=sizeof(struct ray_header)/2 + bins;
+           }
+           n=compress_cowords(words,n,cw);
+           put_raw_bytes(cw,n*2);
+        }
+        if(missing) rays_missing++; else rays_written++;
+     }
+     /* sweep ends at record boundary */
+     flush_record();
+     if(VERB) printf("Sweep %2d elevation %5.2f, records %d\n",iS+1,elevs[iS],irec_c);
+     sweepsecs+=(time_t)(rotsecs+2.0);
+  }
+
+  /* product size to product header */
+  prodhdr->hdr.ibytes=irec_c*TAPE_RECORD_LEN;
+  rewind(RAWF);
+  fwrite(hdrs,sizeof(hdrs),1,RAWF);
+  if(fclose(RAWF)) { fprintf(stderr,"ERROR: Could not write %s\n",argv[argc-1]); exit(1); }
+
+  if(VERB) printf("%s: %d sweeps, %d rays, %d bins, %d moments, %ld rays missing, %ld bytes\n",
+                  argv[argc-1],sweeps,rays,bins,nmoments,rays_missing,(long)irec_c*TAPE_RECORD_LEN);
+
+  for(f=0;f<F_FIELDS;f++) free(F[f]);
+  free(echo); free(words); free(cw);
+  exit( EXIT_SUCCESS ) ;
+}
+
+/** \brief Parses options to global settings. Exits on errors. */
+static void parse_args(int argc, char *argv[])
+{
+  static const double default_elevs[]={0.3,0.7,1.5,3.0,5.0,9.0,0.5,0.9,1.3,2.0,4.0,7.0,11.0,15.0,25.0,45.0};
+  char mlist[500]="DBT2,DBZ2,VEL2,WIDTH2,ZDR2", elist[500]="";
+  char *tok;
+  int i,ndef=sizeof(default_elevs)/sizeof(double);
+  unsigned long seed=1;
+
+  if(argc==1) { usage(); exit(1); }
+  for(i=1;i<argc-1;i++)
+  {
+    char opt;
+
+    if(argv[i][0]!='-') { usage(); exit(1); }
+    opt=argv[i][1];
+    if(opt=='h') { usage(); exit(1); }
+    if(opt=='v') { VERB=TRUE; continue; }
+    if(opt=='X') { XHDR=TRUE; continue; }
+    if(i+1>=argc-1) { usage(); exit(1); }
+    i++;
+    switch(opt)
+    {
+       case 's': sweeps=atoi(argv[i]); break;
+       case 'e': snprintf(elist,sizeof(elist),"%s",argv[i]); break;
+       case 'r': rays=atoi(argv[i]); break;
+       case 'b': bins=atoi(argv[i]); break;
+       case 'g': binstep=atoi(argv[i]); break;
+       case 'a': binavg=atoi(argv[i]); break;
+       case 'm': snprintf(mlist,sizeof(mlist),"%s",argv[i]); break;
+       case 'p': prfmode=atoi(argv[i]); break;
+       case 'f': prf=atoi(argv[i]); break;
+       case 'S': snprintf(sitename,sizeof(sitename),"%s",argv[i]); break;
+       case 't': snprintf(voltime,sizeof(voltime),"%s",argv[i]); break;
+       case 'x': missing_frac=atof(argv[i]); break;
+       case 'R': seed=strtoul(argv[i],NULL,10); break;
+       case 'P':
+         if(strcmp(argv[i],"H")==0) ipolar=POL_HORIZ_FIX;
+         else if(strcmp(argv[i],"V")==0) ipolar=POL_VERT_FIX;
+         else if(strcmp(argv[i],"HV")==0) ipolar=POL_ALTERNATING;
+         else if(strcmp(argv[i],"SIM")==0) ipolar=POL_SIMULTANEOUS;
+         else { fprintf(stderr,"ERROR: Unknown polarization %s\n",argv[i]); exit(1); }
+       break;
+       default: usage(); exit(1);
+    }
+  }
+
+  switch(prfmode)
+  {
+     case 1: itrig=PRF_1_1; break;
+     case 23: itrig=PRF_2_3; break;
+     case 34: itrig=PRF_3_4; break;
+     case 45: itrig=PRF_4_5; break;
+     default: fprintf(stderr,"ERROR: PRF mode %d not one of 1, 23, 34, 45\n",prfmode); exit(1);
+  }
+
+  if(elist[0])
+  {
+    for(sweeps=0,tok=strtok(elist,",");tok && sweeps<MAX_GEN_SWEEPS;tok=strtok(NULL,","))
+       elevs[sweeps++]=atof(tok);
+  }
+  else
+  {
+    if(sweeps>MAX_GEN_SWEEPS) sweeps=MAX_GEN_SWEEPS;
+    for(i=0;i<sweeps;i++) elevs[i] = (i<ndef) ? default_elevs[i] : default_elevs[i%ndef]+0.1*(i/ndef);
+  }
+
+  for(nmoments=0,tok=strtok(mlist,",");tok;tok=strtok(NULL,","))
+  {
+    const MomentDef *md;
+
+    for(md=moment_defs;md->name;md++) if(strcmp(md->name,tok)==0) break;
+    if(!md->name) { fprintf(stderr,"ERROR: Unknown moment %s\n",tok); exit(1); }
+    if(nmoments==MAX_GEN_MOMENTS) { fprintf(stderr,"ERROR: Too many moments\n"); exit(1); }
+    moments[nmoments++]=md;
+  }
+  /* rays carry the moments in data type order */
+  {
+    int a,b;
+
+    for(a=1;a<nmoments;a++) for(b=a;b>0 && moments[b-1]->type>moments[b]->type;b--)
+    {
+       const MomentDef *t=moments[b]; moments[b]=moments[b-1]; moments[b-1]=t;
+    }
+    for(a=1;a<nmoments;a++) if(moments[a]->type==moments[a-1]->type)
+    {
+       fprintf(stderr,"ERROR: Moment %s given twice\n",moments[a]->name); exit(1);
+    }
+  }
+
+  if(sweeps<1 || rays<1 || bins<1 || binstep<1 || binavg<1 || nmoments<1 || prf<1)
+  {
+     fprintf(stderr,"ERROR: Sweeps, rays, bins, bin step, averaging, PRF and moments must be positive\n");
+     exit(1);
+  }
+  if(rays>32767 || (long)bins*binavg>32767)
+  {
+     fprintf(stderr,"ERROR: Rays and input bins (bins*avg) are limited to 32767 in IRIS headers\n");
+     exit(1);
+  }
+  if((size_t)bins*2 > sizeof(((struct data_ray *)0)->data))
+  {
+     fprintf(stderr,"ERROR: At most %lu bins fit in IRIS data ray\n",
+             (unsigned long)(sizeof(((struct data_ray *)0)->data)/2));
+     exit(1);
+  }
+  rng_state=0x9E3779B97F4A7C15ULL ^ (uint64_t)seed;
+  if(!rng_state) rng_state=1;
+}
+
+void usage( void )
+{
+  printf( "\nCommand line options:\n" ) ;
+  printf( " -h : Usage\n" ) ;
+  printf( " -v : Verbose output\n" ) ;
+  printf( " -s sweeps : Number of sweeps (default 10)\n" ) ;
+  printf( " -e list : Comma-separated elevations [deg], sets also number of sweeps\n" ) ;
+  printf( " -r rays : Rays per sweep (default 360)\n" ) ;
+  printf( " -b bins : Range bins per ray (default 500)\n" ) ;
+  printf( " -g step : Range bin step [m] (default 500)\n" ) ;
+  printf( " -a avg : Range averaging factor (default 1)\n" ) ;
+  printf( " -m list : Comma-separated moments, 2 at end for 2-byte data (default DBT2,DBZ2,VEL2,WIDTH2,ZDR2)\n" ) ;
+  printf( "           DBT DBZ DBZC VEL VELC WIDTH ZDR KDP PHIDP RHOHV SQI HCLASS\n" ) ;
+  printf( " -p mode : PRF mode 1, 23, 34 or 45 (default 1)\n" ) ;
+  printf( " -f prf : (High) PRF [Hz] (default 1000)\n" ) ;
+  printf( " -P pol : Polarization H, V, HV or SIM (default SIM)\n" ) ;
+  printf( " -S site : IRIS site name (default VAN)\n" ) ;
+  printf( " -t time : Volume time YYYYMMDDhhmm (default 201303151250)\n" ) ;
+  printf( " -x fraction : Fraction of missing rays (default 0)\n" ) ;
+  printf( " -X : Include extended headers (XHDR)\n" ) ;
+  printf( " -R seed : Random seed (default 1)\n\n" ) ;
+  printf( " The last argument is the output RAW file path\n");
+  printf( " Example: ./IRIS_rawgen -s 20 -r 3600 -b 2000 -g 125 -m DBZ2,VEL2,WIDTH2,ZDR2,RHOHV2 big.raw\n\n");
+}
@@ -0,0 +1,174 @@
+/*! \file ODIM_bench.c
+\brief Microbenchmarks of <I>ODIM_encoder.c</I>: 8/16-bit requantization (Encode==8/16),
+conversion to float physical values (ODIM_PHYSICAL), range bin averaging (ODIM_AVERAGE),
+histograms (ODIM_STATISTICS) and the dataset write of the encoder (create_dataset_by_policy()
+and write_dataset_rows()) at each compression level and storage policy of ODIM_STORAGE.
+
+Usage: ODIM_bench [-n reps] [-r rays] [-b bins] <BR>
+The scan is a synthetic reflectivity field of <I>rays</I> x <I>bins</I> (default 360 x 500)
+with 60 % undetect bins. Datasets are written to an in-memory HDF5 file, so the compression
+level benchmarks measure deflate and HDF5 overhead without disk. Reports one line per
+benchmark (see ODIM_bench.h), the compression ratio is printed as a comment.
+Compiled like ODIM_encoder.c: h5cc -O2 ODIM_bench.c -o bin/ODIM_bench -lz
+*/
+
+#include <hdf5.h>
+#include <hdf5_hl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ODIM_kernels.h"
+#include "ODIM_hdf5.h"
+#include "ODIM_bench.h"
+
+int main(int argc, char** argv)
+{
+  int reps=10,rays=360,bins=500,r,p,bytes;
+  /* storage policies (ODIM_STORAGE), levels 0...9 reported as dataset<bits>/level<n> */
+  const char *policies[]={"0","1","2","3","4","5","6","7","8","9","shuffle/6","auto1.2/6","contiguous",NULL};
+  long n,N;
+  double *secs;
+  uint8_t *d16,*d8,*out;
+  float *fout;
+  uint32_t *work;
+  ScanStats stats;
+  /* DBZH2 -> DBZH and DBZH -> DBZH2 as in encoder, gains 0.01 and 0.5 */
+  double eps=1.0e-6, c_gain8=0.01/0.5, c_off8=eps+(-327.68+32.0)/0.5;
+  double c_gain16=0.5/0.01, c_off16=eps+(-32.0+327.68)/0.01;
+
+  {
+    int i;
+
+    for(i=1;i<argc;i++)
+    {
+      if(i+1<argc && strcmp(argv[i],"-n")==0) reps=atoi(argv[++i]);
+      else if(i+1<argc && strcmp(argv[i],"-r")==0) rays=atoi(argv[++i]);
+      else if(i+1<argc && strcmp(argv[i],"-b")==0) bins=atoi(argv[++i]);
+      else { printf("\nUsage: ODIM_bench [-n reps] [-r rays] [-b bins]\n\n"); exit(1); }
+    }
+    if(reps<1 || rays<1 || bins<1) { printf("\nUsage: ODIM_bench [-n reps] [-r rays] [-b bins]\n\n"); exit(1); }
+  }
+
+  N=(long)rays*bins;
+  d16=malloc(2*N);
+  d8=malloc(N);
+  out=malloc(2*N);
+  fout=malloc(N*sizeof(float));
+  work=malloc(3*bins*sizeof(uint32_t));
+  secs=malloc(reps*sizeof(double));
+
+  /* smooth field with noise, undetect (0) outside echoes */
+  {
+     uint64_t s=88172645463325252ULL;
+
+     for(n=0;n<N;n++)
+     {
+        long ray=n/bins, bin=n%bins;
+        double z=25.0+20.0*sin(ray*0.05)*cos(bin*0.02);
+        uint16_t W=0;
+
+        s^=s<<13; s^=s>>7; s^=s<<17;
+        if(sin(ray*0.03+bin*0.011)>0.2) W=(uint16_t)(32768.0+100.0*(z+(double)(s%300)/100.0));
+        memcpy(d16+2*n,&W,2);
+        d8[n]=W ? (uint8_t)(2.0*(z+(double)(s%300)/100.0)+64.0) : 0;
+     }
+  }
+
+  printf("# scan %d rays x %d bins\n",rays,bins);
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     requant_16_to_8(d16,N,65535,0,255,0,c_gain8,c_off8,out);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("requant_16_to_8",secs,reps,(double)N,"bin");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     requant_8_to_16(d8,N,255,0,65535,0,c_gain16,c_off16,out);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("requant_8_to_16",secs,reps,(double)N,"bin");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     phys_16_to_f32(d16,N,65535,0,0.01f,-327.68f,NAN,NAN,fout);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("phys_16_to_f32",secs,reps,(double)N,"bin");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     phys_8_to_f32(d8,N,255,0,0.5f,-32.0f,NAN,NAN,fout);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("phys_8_to_f32",secs,reps,(double)N,"bin");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     average_16(d16,rays,bins,4,1,65535,0,out,work);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("average_16_4x1",secs,reps,(double)N,"bin");
+
+  for(r=0;r<reps;r++)
+  {
+     double t0=bench_now();
+
+     memset(&stats,0,sizeof(stats));
+     stats_8(d8,rays,bins,255,0,&stats);
+     secs[r]=bench_now()-t0;
+  }
+  bench_report("stats_8",secs,reps,(double)N,"bin");
+
+  H5Eset_auto2(H5E_DEFAULT,NULL,NULL);
+  for(bytes=1;bytes<=2;bytes++) for(p=0;policies[p];p++)
+  {
+     hsize_t dims[2]={rays,bins},stored=0;
+     char name[40],spec[40];
+
+     snprintf(spec,sizeof(spec),"*=%s",policies[p]);
+     for(r=0;r<reps;r++)
+     {
+        StoragePolicy pol=get_storage_policy(spec,"DBZH",NULL,6);
+        hid_t fapl,H5F,G,D;
+        void *data=(bytes==1) ? (void *)d8 : (void *)d16;
+        double t0;
+
+        fapl=H5Pcreate(H5P_FILE_ACCESS);
+        H5Pset_fapl_core(fapl,1<<20,0);
+        H5F=H5Fcreate("bench.h5",H5F_ACC_TRUNC,H5P_DEFAULT,fapl);
+        G=H5Gcreate2(H5F,"/dataset1",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+        t0=bench_now();
+        D=create_dataset_by_policy(G,"data",&pol,bytes,2,dims,dims,data);
+        write_dataset_rows(D,bytes,0,rays,bins,data);
+        H5Dclose(D); /* chunk is compressed and flushed here */
+        secs[r]=bench_now()-t0;
+        D=H5Dopen2(G,"data",H5P_DEFAULT);
+        stored=H5Dget_storage_size(D);
+        H5Dclose(D);
+        H5Gclose(G);
+        H5Fclose(H5F);
+        H5Pclose(fapl);
+     }
+     if(policies[p][1]) snprintf(name,sizeof(name),"dataset%d/%s",8*bytes,policies[p]);
+     else snprintf(name,sizeof(name),"dataset%d/level%s",8*bytes,policies[p]);
+     printf("# %s ratio %.3f\n",name,(double)stored/(double)(N*bytes));
+     bench_report(name,secs,reps,(double)N,"bin");
+  }
+
+  free(d16); free(d8); free(out); free(fout); free(work); free(secs);
+  return(0);
+}
@@ -0,0 +1,53 @@
+/*! \file ODIM_bench.h
+\brief Repetition timing and percentile report of the microbenchmarks <I>IRIS_bench.c</I>
+and <I>ODIM_bench.c</I>.
+
+Each benchmark is run <I>reps</I> times and reported as one line<BR>
+<I>name p50 p90 p99 rate</I><BR>
+where the percentiles are seconds per run (nearest rank) and rate is items per second at
+the median. Lines starting with '#' are comments. bench.sh compares the lines to a baseline.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+/** \brief Monotonic clock [s] */
+static double bench_now(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC,&now);
+   return((double)now.tv_sec + 1.0e-9*(double)now.tv_nsec);
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+   double x=*(const double *)a, y=*(const double *)b;
+
+   return((x>y) - (x<y));
+}
+
+/** \brief Percentile <I>q</I> (0...1) of sorted times, nearest rank */
+static double bench_percentile(const double *sorted, int n, double q)
+{
+   int k=(int)ceil(q*n)-1;
+
+   if(k<0) k=0;
+   if(k>=n) k=n-1;
+   return(sorted[k]);
+}
+
+/** \brief Prints the report line of benchmark <I>name</I>. <I>secs</I> has the times of
+<I>n</I> runs (sorted here) and each run handles <I>items</I> of <I>unit</I>. */
+static void bench_report(const char *name, double *secs, int n, double items, const char *unit)
+{
+   double p50;
+
+   qsort(secs,n,sizeof(double),bench_cmp);
+   p50=bench_percentile(secs,n,0.5);
+   printf("%-28s %11.6f %11.6f %11.6f  %.2f M%s/s\n",name,p50,bench_percentile(secs,n,0.9),
+          bench_percentile(secs,n,0.99),p50>0 ? 1.0e-6*items/p50 : 0.0,unit);
+   fflush(stdout);
+}
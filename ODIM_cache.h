@@ -0,0 +1,233 @@
+/*! \file ODIM_cache.h
+\brief Conversion cache of <I>IRIS_decoder.c</I> and <I>ODIM_encoder.c</I>.
+
+The cache is switched on by setting ODIM_CACHE_DIR to a directory. An output is stored there
+under a key made of a hash of the input bytes and a hash of the effective configuration: the
+cache version (CACHE_VERSION), the ODIM_* and IRIS_* environment variables affecting the output (site settings, quantity
+selection, compression level, ODIM_Conventions...) and the program options. If the same
+input comes again with the same configuration, the stored output is hard linked (or copied
+to another file system) to the output path and the conversion is skipped.<BR>
+The decoder caches intermediate files by the RAW product, the encoder HDF5 files by the
+intermediate files, so a repeated product costs the hashing of the RAW and intermediate files.
+The decoded product is shared by output profiles: the decoder key leaves out the variables
+only the encoder reads (cache_env_encoder), e.g. quantity selection and compression level, so
+converting a product for another profile only encodes the intermediate file of the first
+conversion, and the encoder reads only the wanted sweeps and quantities of it. With decoder
+option -w the quantity selection is part of the decoder key.
+Entries are never changed once stored: an output linked to an entry is unlinked before it is
+written again, also when the cache is not on (cache_unshare()).
+Entries are touched when used, so the cache can be cleaned by age, e.g.
+find $ODIM_CACHE_DIR -type f -mtime +7 -delete
+*/
+
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+extern char **environ;
+
+/* Version of the conversion, part of every cache key. Change it when a program changes its
+   output, so that entries of older programs are not used. */
+# define CACHE_VERSION "iris_to_hdf5 cache 2"
+
+/* Environment variables not affecting the output: paths, logging, timing, memory and
+   the incremental sweep output (patterns of fnmatch) */
+static const char *cache_env_ignored[] = {"ODIM_OUTPUT_DIR","ODIM_OUTPUT_FILE","ODIM_NAME_FILE",
+   "ODIM_LOG_FILE","ODIM_LOG_FORMAT","ODIM_TIMING_FILE","ODIM_TIMING_FORMAT","ODIM_MEMORY_BUDGET",
+   "ODIM_TAIL_TIMEOUT","ODIM_SWEEP_FILE","ODIM_SWEEP_COMMAND","ODIM_SECTOR_WIDTH","ODIM_CACHE_DIR",
+   "ODIM_CART_THREADS","ODIM_CART_CACHE_DIR","ODIM_DEALIAS_THREADS",NULL};
+
+#ifdef IRIS_DECODER
+/* Variables read by the encoder only. The decoder ignores them, so that output profiles
+   differing in these share the decoded product. */
+static const char *cache_env_encoder[] = {"ODIM_COMPRESSION_LEVEL","ODIM_Conventions",
+   "ODIM_what_version","ODIM_how_simulated","ODIM_ORIGCENTER","ODIM_*_quantities","ODIM_STORAGE",
+   "ODIM_ENCODE_DEADLINE","ODIM_PROFILE*","ODIM_PHYSICAL*",
+   "ODIM_CART_*","ODIM_CROP_*","ODIM_AVERAGE","ODIM_STATISTICS",
+   "ODIM_EMPTY_DATA","ODIM_DEALIAS*",NULL};
+#endif
+
+/** \brief Continues hash <I>h</I> with <I>n</I> bytes at <I>p</I>. Four lanes of 64-bit
+multiply-xorshift over 32 byte blocks, not cryptographic. Start with h=0. */
+uint64_t cache_hash(uint64_t h, const void *p, size_t n)
+{
+   const unsigned char *c=p;
+   uint64_t l[4],w;
+   const uint64_t K=0x9E3779B97F4A7C15ULL;
+   size_t i;
+   int k;
+
+   for(k=0;k<4;k++) l[k]=h+(uint64_t)(k+1)*K;
+   for(i=0;i+32<=n;i+=32)
+   {
+      for(k=0;k<4;k++)
+      {
+         memcpy(&w,c+i+8*k,8);
+         l[k]=(l[k]^w)*K;
+         l[k]^=l[k]>>29;
+      }
+   }
+   h=l[0]^(l[1]<<1)^(l[2]<<2)^(l[3]<<3)^n;
+   for(;i<n;i++) h=(h^c[i])*0x100000001B3ULL;
+   h^=h>>33; h*=0xFF51AFD7ED558CCDULL; h^=h>>33;
+   return(h);
+}
+
+static int cache_strcmp(const void *a, const void *b)
+{
+   return(strcmp(*(char * const *)a,*(char * const *)b));
+}
+
+/** \brief Tests if environment string <I>env</I> (name=value) is of a variable matching a
+pattern of <I>patterns</I> */
+int cache_env_match(const char *env, const char **patterns)
+{
+   char name[256];
+   size_t len=strcspn(env,"=");
+   int k;
+
+   if(!patterns || len>=sizeof(name)) return(0);
+   memcpy(name,env,len);
+   name[len]=0;
+   for(k=0;patterns[k];k++) if(!fnmatch(patterns[k],name,0)) return(1);
+   return(0);
+}
+
+/** \brief Hash of the configuration: CACHE_VERSION, the sorted ODIM_* and IRIS_* environment
+variables except those of cache_env_ignored and <I>ignored</I> (NULL if none), and
+<I>options</I> of the program. */
+uint64_t cache_config_hash(const char *options, const char **ignored)
+{
+   char **env;
+   size_t n=0,i;
+   uint64_t h;
+
+   for(i=0;environ[i];i++) n++;
+   env=calloc(n+1,sizeof(char *));
+   for(n=i=0;environ[i];i++)
+   {
+      if(strncmp(environ[i],"ODIM_",5) && strncmp(environ[i],"IRIS_",5) &&
+         strncmp(environ[i],"FiniteBandwithLoss=",19)) continue;
+      if(cache_env_match(environ[i],cache_env_ignored) || cache_env_match(environ[i],ignored)) continue;
+      env[n++]=environ[i];
+   }
+   qsort(env,n,sizeof(char *),cache_strcmp);
+   h=cache_hash(0,CACHE_VERSION,sizeof(CACHE_VERSION));
+   h=cache_hash(h,options,strlen(options)+1);
+   for(i=0;i<n;i++) h=cache_hash(h,env[i],strlen(env[i])+1);
+   free(env);
+   return(h);
+}
+
+/** \brief Continues hash <I>*h</I> with the contents of file <I>path</I>. Returns 0 if ok. */
+int cache_hash_file(const char *path, uint64_t *h)
+{
+   static unsigned char buf[1<<20];
+   ssize_t n;
+   int fd=open(path,O_RDONLY);
+
+   if(fd<0) return(-1);
+   while((n=read(fd,buf,sizeof(buf)))>0) *h=cache_hash(*h,buf,n);
+   close(fd);
+   return(n<0 ? -1 : 0);
+}
+
+/** \brief Path of cache entry of <I>key</I> and extension <I>ext</I> to <I>path</I>, empty if
+ODIM_CACHE_DIR is not set. Returns <I>path</I>. */
+char *cache_entry(char *path, size_t size, uint64_t key, uint64_t config, const char *ext)
+{
+   char *dir=getenv("ODIM_CACHE_DIR");
+
+   path[0]=0;
+   if(dir && dir[0]) snprintf(path,size,"%s/%016llx%016llx%s",dir,(unsigned long long)key,
+                              (unsigned long long)config,ext);
+   return(path);
+}
+
+/** \brief Copies file <I>from</I> to <I>to</I>. Returns 0 if ok. */
+int cache_copy(const char *from, const char *to)
+{
+   static unsigned char buf[1<<20];
+   ssize_t n=0;
+   int in,out,ok=1;
+
+   if((in=open(from,O_RDONLY))<0) return(-1);
+   if((out=open(to,O_WRONLY|O_CREAT|O_TRUNC,0644))<0) { close(in); return(-1); }
+   while(ok && (n=read(in,buf,sizeof(buf)))>0) ok=(write(out,buf,n)==n);
+   if(n<0) ok=0;
+   close(in);
+   if(close(out)) ok=0;
+   if(!ok) unlink(to);
+   return(ok ? 0 : -1);
+}
+
+/** \brief Links (or copies) <I>from</I> to <I>to</I>, replacing an old <I>to</I>.
+Returns 0 if ok. */
+int cache_link(const char *from, const char *to)
+{
+   unlink(to);
+   if(!link(from,to)) return(0);
+   return(cache_copy(from,to));
+}
+
+/** \brief Unlinks output <I>path</I> if it is a regular file having other links, so that
+writing it does not change a cache entry. */
+void cache_unshare(const char *path)
+{
+   struct stat st;
+
+   if(!stat(path,&st) && S_ISREG(st.st_mode) && st.st_nlink>1) unlink(path);
+}
+
+/** \brief Gives cache entry <I>entry</I> as file <I>path</I>. Returns 0 on a hit, -1 if there
+is no such entry. */
+int cache_fetch(const char *entry, const char *path)
+{
+   if(!entry[0] || access(entry,R_OK)) return(-1);
+   if(cache_link(entry,path)) return(-1);
+   utime(entry,NULL);
+   return(0);
+}
+
+/** \brief Reads the string of cache entry <I>entry</I> to <I>str</I>. Returns 0 on a hit. */
+int cache_fetch_string(const char *entry, char *str, size_t size)
+{
+   FILE *F;
+   size_t n;
+
+   if(!entry[0] || !(F=fopen(entry,"r"))) return(-1);
+   n=fread(str,1,size-1,F);
+   str[n]=0;
+   fclose(F);
+   return(n ? 0 : -1);
+}
+
+/** \brief Stores string <I>str</I> as cache entry <I>entry</I> */
+void cache_store_string(const char *entry, const char *str)
+{
+   char tmp[1100];
+   FILE *F;
+
+   if(!entry[0]) return;
+   snprintf(tmp,sizeof(tmp),"%s.%ld.tmp",entry,(long)getpid());
+   if(!(F=fopen(tmp,"w"))) return;
+   fputs(str,F);
+   if(fclose(F) || rename(tmp,entry)) unlink(tmp);
+}
+
+/** \brief Stores file <I>path</I> as cache entry <I>entry</I>. The entry appears atomically,
+so concurrent conversions see it complete or not at all. */
+void cache_store(const char *path, const char *entry)
+{
+   char tmp[1100];
+
+   if(!entry[0]) return;
+   snprintf(tmp,sizeof(tmp),"%s.%ld.tmp",entry,(long)getpid());
+   if(cache_link(path,tmp) || rename(tmp,entry)) unlink(tmp);
+}
@@ -0,0 +1,525 @@
+/*! \file ODIM_cart.h
+\brief Cartesian products of <I>ODIM_encoder.c</I>: PPI, CAPPI and PCAPPI images (ODIM
+object IMAGE) projected from the polar scans while they are in memory.
+
+The product is made if ODIM_CART_FILE gives its file name (in ODIM_OUTPUT_DIR):<BR>
+<B>ODIM_CART_PRODUCT</B> : PPI (default), CAPPI or PCAPPI <BR>
+<B>ODIM_CART_PRODPAR</B> : PPI elevation angle [deg], default the lowest scan; CAPPI and PCAPPI
+height above the radar [m], default 1000 <BR>
+<B>ODIM_CART_GRID</B> : pixels per side and pixel size [m], default "500 1000" <BR>
+<B>ODIM_CART_QUANTITIES</B> : comma separated ODIM quantities of the image, default DBZH <BR>
+<B>ODIM_CART_THREADS</B> : projector threads, default the number of online processors <BR>
+<B>ODIM_CART_CACHE_DIR</B> : directory of the lookup tables, none if not set <BR>
+
+The grid is azimuthal equidistant, centred at the radar and north up, the beam follows the
+4/3 earth radius model and the value of a pixel is the one of the nearest bin. A CAPPI pixel
+is taken from the scan whose beam centre is nearest to the height, and is nodata if the
+height is not within half a beam width of it; a PCAPPI takes the nearest scan anyway.<BR>
+The lookup table gives for each pixel the range bin, the azimuth in 1/100 degrees and the scan.
+It depends only on the grid, the product and the elevations, range bins and height of the
+radar, so it is computed (in parallel) once per geometry and read from ODIM_CART_CACHE_DIR
+afterwards. Rays are found from the azimuth by a map made of startazA and stopazA of each
+volume, which needs no trigonometry, so the per ray azimuths and a1gate of the volume are
+respected.<BR>
+Values are float32 physical values as with ODIM_PHYSICAL=only, nodata and undetect being
+ODIM_PHYSICAL_NODATA and ODIM_PHYSICAL_UNDETECT (NaN); pixels outside the scans are nodata.
+The scans kept for the projection are not limited by ODIM_MEMORY_BUDGET.
+Include after ODIM_struct.h, ODIM_hdf5.h and ODIM_cache.h, link with -pthread.
+*/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+# define CART_MAX_QUANTS 16  /**<\brief quantities of an image */
+# define CART_MAX_SCANS 64   /**<\brief scans of a CAPPI */
+# define CART_MAX_THREADS 64 /**<\brief projector threads */
+# define CART_AZ_CELLS 36000 /**<\brief azimuth cells of the tables, 0.01 degrees */
+# define CART_EARTH_RADIUS 6371000.0
+
+# define CART_PPI 0
+# define CART_CAPPI 1
+# define CART_PCAPPI 2
+
+static const char *cart_product_name[3]={"PPI","CAPPI","PCAPPI"};
+
+/*!\struct CartScan
+\brief A polar scan kept for the projection */
+typedef struct {
+                  double elangle,rstart,rscale; /*!< [deg], [km], [m] as in SetWhere */
+                  long nbins,nrays;
+                  SetWhat what;
+                  int *raymap;                  /*!< ray of each azimuth cell, -1 if none */
+                  float *data[CART_MAX_QUANTS]; /*!< physical values, NULL if not encoded */
+               } CartScan;
+
+/*!\struct CartConfig
+\brief Cartesian product configuration and its scans */
+typedef struct {
+                  char *file;           /*!< output file name, NULL if no product */
+                  int product;          /*!< CART_PPI, CART_CAPPI or CART_PCAPPI */
+                  double prodpar;       /*!< elevation angle or height */
+                  int prodpar_set;      /*!< PPI angle given, otherwise the lowest scan */
+                  long size;            /*!< pixels per side */
+                  double scale;         /*!< pixel size [m] */
+                  int threads;
+                  int quantities;
+                  char quantity[CART_MAX_QUANTS][20];
+                  int scans;
+                  CartScan scan[CART_MAX_SCANS];
+                  float nodata,undetect;
+                  RootWhat what;        /*!< of the volume, source included */
+                  RootWhere where;
+                  double beamwidth;     /*!< vertical beam width [deg] */
+               } CartConfig;
+
+/*!\struct CartTable
+\brief Lookup table of the pixels */
+typedef struct {
+                  long n;
+                  int32_t *bin;  /*!< range bin, -1 if the pixel is outside the scans */
+                  uint16_t *az;  /*!< azimuth cell */
+                  uint8_t *scan; /*!< scan of the pixel */
+               } CartTable;
+
+/*!\struct CartJob
+\brief Rows of the image done by one thread */
+typedef struct {
+                  CartConfig *cart;
+                  CartTable *tab;
+                  int q;         /*!< quantity projected */
+                  float *out;    /*!< image */
+                  long row0,row1;
+               } CartJob;
+
+/** \brief Reads the configuration of the Cartesian product to <I>*cart</I>. Returns 1 if a
+product is made. */
+int cart_init(CartConfig *cart, float nodata, float undetect)
+{
+   char *envp,*list,*name,*save=NULL;
+
+   memset(cart,0,sizeof(CartConfig));
+   cart->file=getenv("ODIM_CART_FILE");
+   if(cart->file && !cart->file[0]) cart->file=NULL;
+   cart->nodata=nodata;
+   cart->undetect=undetect;
+   if((envp=getenv("ODIM_CART_PRODUCT")))
+   {
+      if(!strcmp(envp,"CAPPI")) cart->product=CART_CAPPI;
+      if(!strcmp(envp,"PCAPPI")) cart->product=CART_PCAPPI;
+   }
+   cart->prodpar=(cart->product==CART_PPI) ? 0.0 : 1000.0;
+   if((envp=getenv("ODIM_CART_PRODPAR"))) { cart->prodpar=atof(envp); cart->prodpar_set=1; }
+   cart->size=500;
+   cart->scale=1000.0;
+   if((envp=getenv("ODIM_CART_GRID"))) sscanf(envp,"%ld %lf",&cart->size,&cart->scale);
+   if(cart->size<1) cart->size=500;
+   if(cart->scale<=0.0) cart->scale=1000.0;
+   cart->threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+   if((envp=getenv("ODIM_CART_THREADS"))) cart->threads=atoi(envp);
+   if(cart->threads<1) cart->threads=1;
+   if(cart->threads>CART_MAX_THREADS) cart->threads=CART_MAX_THREADS;
+
+   envp=getenv("ODIM_CART_QUANTITIES");
+   list=strdup(envp ? envp : "DBZH");
+   for(name=strtok_r(list," ,",&save);name && cart->quantities<CART_MAX_QUANTS;name=strtok_r(NULL," ,",&save))
+      snprintf(cart->quantity[cart->quantities++],20,"%s",name);
+   free(list);
+   return(cart->file!=NULL);
+}
+
+/** \brief Sets the volume metadata of the product */
+void cart_volume(CartConfig *cart, RootWhat *what, RootWhere *where, How *how)
+{
+   cart->what=*what;
+   cart->where=*where;
+   cart->beamwidth=how->beamwV>0.0 ? how->beamwV : how->beamwidth;
+   if(cart->beamwidth<=0.0) cart->beamwidth=1.0;
+}
+
+/** \brief Index of ODIM quantity <I>quantity</I> in the product, -1 if not in it */
+int cart_quantity(CartConfig *cart, const char *quantity)
+{
+   int q;
+
+   for(q=0;q<cart->quantities;q++) if(!strcmp(cart->quantity[q],quantity)) return(q);
+   return(-1);
+}
+
+/** \brief Frees the data of scan <I>slot</I> */
+void cart_free_scan(CartConfig *cart, int slot)
+{
+   int q;
+
+   free(cart->scan[slot].raymap);
+   for(q=0;q<CART_MAX_QUANTS;q++) free(cart->scan[slot].data[q]);
+   memset(&cart->scan[slot],0,sizeof(CartScan));
+}
+
+/** \brief Takes scan <I>set</I> to the product if it is used. A PPI keeps the lowest scan or
+the one nearest to its angle, a CAPPI all. Returns the slot of the scan, -1 if not used. */
+int cart_begin_scan(CartConfig *cart, DataSet *set)
+{
+   CartScan *s;
+   double el=set->where.elangle;
+   long k,c,c0,c1;
+   int slot;
+
+   if(cart->product==CART_PPI)
+   {
+      if(cart->scans)
+      {
+         double old=cart->scan[0].elangle;
+
+         if(cart->prodpar_set ? fabs(el-cart->prodpar)>=fabs(old-cart->prodpar) : el>=old) return(-1);
+         cart_free_scan(cart,0);
+      }
+      slot=0;
+      cart->scans=1;
+   }
+   else
+   {
+      if(cart->scans>=CART_MAX_SCANS) return(-1);
+      slot=cart->scans++;
+   }
+   s=&cart->scan[slot];
+   s->elangle=el;
+   s->rstart=set->where.rstart;
+   s->rscale=set->where.rscale;
+   s->nbins=set->where.nbins;
+   s->nrays=set->where.nrays;
+   s->what=set->what;
+
+   /* azimuth cells covered by each ray */
+   s->raymap=malloc(CART_AZ_CELLS*sizeof(int));
+   for(c=0;c<CART_AZ_CELLS;c++) s->raymap[c]=-1;
+   for(k=0;k<s->nrays;k++)
+   {
+      double a0=set->startazA[k],a1=set->stopazA[k];
+
+      if(a1<a0) a1+=360.0;
+      if(a1-a0<=0.0 || a1-a0>=180.0) /* no width, nominal one */
+      {
+         a0=0.5*(a0+a1)-180.0/s->nrays;
+         a1=a0+360.0/s->nrays;
+      }
+      c0=lround(a0*CART_AZ_CELLS/360.0);
+      c1=lround(a1*CART_AZ_CELLS/360.0);
+      for(c=c0;c<c1;c++) s->raymap[((c%CART_AZ_CELLS)+CART_AZ_CELLS)%CART_AZ_CELLS]=(int)k;
+   }
+   return(slot);
+}
+
+/** \brief Buffer of the physical values of quantity <I>q</I> of scan <I>slot</I>, nrays x nbins */
+float *cart_scan_buffer(CartConfig *cart, int slot, int q)
+{
+   CartScan *s=&cart->scan[slot];
+
+   if(!s->data[q]) s->data[q]=malloc(s->nrays*s->nbins*sizeof(float));
+   return(s->data[q]);
+}
+
+/** \brief Key of the lookup table: the grid, the product and the geometry of its scans */
+uint64_t cart_table_key(CartConfig *cart)
+{
+   double geom[4];
+   uint64_t h=0;
+   int iS;
+
+   h=cache_hash(h,&cart->product,sizeof(int));
+   h=cache_hash(h,&cart->prodpar,sizeof(double));
+   h=cache_hash(h,&cart->size,sizeof(long));
+   h=cache_hash(h,&cart->scale,sizeof(double));
+   h=cache_hash(h,&cart->where.height,sizeof(double));
+   h=cache_hash(h,&cart->beamwidth,sizeof(double));
+   for(iS=0;iS<cart->scans;iS++)
+   {
+      geom[0]=cart->scan[iS].elangle;
+      geom[1]=cart->scan[iS].rstart;
+      geom[2]=cart->scan[iS].rscale;
+      geom[3]=(double)cart->scan[iS].nbins;
+      h=cache_hash(h,geom,sizeof(geom));
+   }
+   return(h);
+}
+
+/** \brief Thread computing the lookup table of rows row0...row1-1 */
+void *cart_table_rows(void *arg)
+{
+   CartJob *job=arg;
+   CartConfig *cart=job->cart;
+   CartTable *tab=job->tab;
+   double R=CART_EARTH_RADIUS*4.0/3.0+cart->where.height;
+   double half=0.5*cart->size,beam=0.5*cart->beamwidth*M_PI/180.0;
+   double cose[CART_MAX_SCANS],el[CART_MAX_SCANS];
+   long i,j,p;
+   int iS;
+
+   for(iS=0;iS<cart->scans;iS++)
+   {
+      el[iS]=cart->scan[iS].elangle*M_PI/180.0;
+      cose[iS]=cos(el[iS]);
+   }
+   for(j=job->row0;j<job->row1;j++) for(i=0;i<cart->size;i++)
+   {
+      double x=(i-half+0.5)*cart->scale,y=(half-j-0.5)*cart->scale;
+      double theta=hypot(x,y)/R,az=atan2(x,y)*180.0/M_PI,r=-1.0,bin;
+      int best=0;
+
+      p=j*cart->size+i;
+      if(az<0.0) az+=360.0;
+      tab->az[p]=(uint16_t)((long)(az*CART_AZ_CELLS/360.0)%CART_AZ_CELLS);
+      tab->bin[p]=-1;
+      tab->scan[p]=0;
+      if(cart->product==CART_PPI)
+      {
+         if(cos(theta+el[0])>0.0) r=R*sin(theta)/cos(theta+el[0]);
+      }
+      else
+      {
+         double dh=-1.0;
+
+         /* scan of the beam centre height nearest to the CAPPI height */
+         for(iS=0;iS<cart->scans;iS++)
+         {
+            double c=cos(theta+el[iS]),h,d;
+
+            if(c<=0.0) continue;
+            h=R*cose[iS]/c-R;
+            d=fabs(h-cart->prodpar);
+            if(dh<0.0 || d<dh) { dh=d; best=iS; r=R*sin(theta)/c; }
+         }
+         if(cart->product==CART_CAPPI && r>=0.0 && dh>r*beam) r=-1.0;
+      }
+      if(r<0.0) continue;
+      bin=(r-1000.0*cart->scan[best].rstart)/cart->scan[best].rscale;
+      if(bin<0.0 || bin>=(double)cart->scan[best].nbins) continue;
+      tab->bin[p]=(int32_t)bin;
+      tab->scan[p]=(uint8_t)best;
+   }
+   return(NULL);
+}
+
+/** \brief Thread projecting quantity <I>q</I> to rows row0...row1-1 of the image */
+void *cart_project_rows(void *arg)
+{
+   CartJob *job=arg;
+   CartConfig *cart=job->cart;
+   CartTable *tab=job->tab;
+   long p;
+
+   for(p=job->row0*cart->size;p<job->row1*cart->size;p++)
+   {
+      CartScan *s=&cart->scan[tab->scan[p]];
+      int ray;
+
+      job->out[p]=cart->nodata;
+      if(tab->bin[p]<0 || !s->data[job->q]) continue;
+      ray=s->raymap[tab->az[p]];
+      if(ray>=0) job->out[p]=s->data[job->q][(long)ray*s->nbins+tab->bin[p]];
+   }
+   return(NULL);
+}
+
+/** \brief Runs <I>work</I> on the rows of the image split to the threads of the product */
+void cart_parallel(CartConfig *cart, CartTable *tab, int q, float *out, void *(*work)(void *))
+{
+   pthread_t thread[CART_MAX_THREADS];
+   CartJob job[CART_MAX_THREADS];
+   int started[CART_MAX_THREADS]={0};
+   int t,n=cart->threads;
+
+   if(n>cart->size) n=(int)cart->size;
+   for(t=0;t<n;t++)
+   {
+      job[t].cart=cart;
+      job[t].tab=tab;
+      job[t].q=q;
+      job[t].out=out;
+      job[t].row0=cart->size*t/n;
+      job[t].row1=cart->size*(t+1)/n;
+   }
+   for(t=1;t<n;t++) started[t]=!pthread_create(&thread[t],NULL,work,&job[t]);
+   work(&job[0]);
+   for(t=1;t<n;t++)
+   {
+      if(started[t]) pthread_join(thread[t],NULL);
+      else work(&job[t]);
+   }
+}
+
+/** \brief Gives the lookup table of the product, from ODIM_CART_CACHE_DIR if computed before.
+Returns 0 if ok. */
+int cart_table(CartConfig *cart, CartTable *tab)
+{
+   char path[1100],tmp[1200],magic[8];
+   char *dir=getenv("ODIM_CART_CACHE_DIR");
+   uint64_t key=cart_table_key(cart),fkey=0;
+   int64_t n=0;
+   FILE *F;
+
+   tab->n=cart->size*cart->size;
+   tab->bin=malloc(tab->n*sizeof(int32_t));
+   tab->az=malloc(tab->n*sizeof(uint16_t));
+   tab->scan=malloc(tab->n);
+   if(!tab->bin || !tab->az || !tab->scan) return(-1);
+
+   path[0]=0;
+   if(dir && dir[0]) snprintf(path,sizeof(path),"%s/cart_%016llx.tab",dir,(unsigned long long)key);
+   if(path[0] && (F=fopen(path,"r")))
+   {
+      int ok=fread(magic,8,1,F)==1 && !memcmp(magic,"ODIMCART",8) &&
+             fread(&fkey,sizeof(fkey),1,F)==1 && fkey==key &&
+             fread(&n,sizeof(n),1,F)==1 && n==tab->n &&
+             fread(tab->bin,sizeof(int32_t),n,F)==(size_t)n &&
+             fread(tab->az,sizeof(uint16_t),n,F)==(size_t)n &&
+             fread(tab->scan,1,n,F)==(size_t)n;
+
+      fclose(F);
+      if(ok) { log_msg(LOG_INFO,"Cartesian lookup table %s\n",path); return(0); }
+   }
+
+   cart_parallel(cart,tab,0,NULL,cart_table_rows);
+   if(path[0])
+   {
+      /* written to a temporary file and renamed, concurrent encoders see it complete or not at all */
+      snprintf(tmp,sizeof(tmp),"%s.%ld.tmp",path,(long)getpid());
+      if((F=fopen(tmp,"w")))
+      {
+         int ok;
+
+         n=tab->n;
+         ok=fwrite("ODIMCART",8,1,F)==1 && fwrite(&key,sizeof(key),1,F)==1 && fwrite(&n,sizeof(n),1,F)==1 &&
+            fwrite(tab->bin,sizeof(int32_t),n,F)==(size_t)n && fwrite(tab->az,sizeof(uint16_t),n,F)==(size_t)n &&
+            fwrite(tab->scan,1,n,F)==(size_t)n;
+         if(fclose(F) || !ok || rename(tmp,path)) unlink(tmp);
+      }
+   }
+   return(0);
+}
+
+/** \brief Longitude and latitude of the point <I>x</I>, <I>y</I> [m] of the grid */
+void cart_lonlat(CartConfig *cart, double x, double y, double *lon, double *lat)
+{
+   double d=hypot(x,y)/CART_EARTH_RADIUS,b=atan2(x,y);
+   double la0=cart->where.lat*M_PI/180.0,la;
+
+   la=asin(sin(la0)*cos(d)+cos(la0)*sin(d)*cos(b));
+   *lat=la*180.0/M_PI;
+   *lon=cart->where.lon+atan2(sin(b)*sin(d)*cos(la0),cos(d)-sin(la0)*sin(la))*180.0/M_PI;
+}
+
+/** \brief Projects the quantities and writes the product to file <I>path</I>, the datasets
+stored by the policy of the quantity at compression level <I>level</I>. Returns 0 if ok. */
+int cart_write(CartConfig *cart, char *path, int level)
+{
+   CartTable tab;
+   hid_t H5F,G;
+   hsize_t dims[2];
+   float *image;
+   char projdef[300],group[100];
+   double half=0.5*cart->size*cart->scale,lon,lat,gain=1.0,offset=0.0,nodata,undetect,angles[CART_MAX_SCANS];
+   int64_t xsize=cart->size;
+   int q,eQ=0,iS,first=-1,last=-1;
+
+   for(iS=0;iS<cart->scans;iS++) for(q=0;q<cart->quantities;q++) if(cart->scan[iS].data[q])
+   {
+      if(first<0 || strcmp(cart->scan[iS].what.startdate,cart->scan[first].what.startdate)<0 ||
+         (!strcmp(cart->scan[iS].what.startdate,cart->scan[first].what.startdate) &&
+          strcmp(cart->scan[iS].what.starttime,cart->scan[first].what.starttime)<0)) first=iS;
+      if(last<0 || strcmp(cart->scan[iS].what.enddate,cart->scan[last].what.enddate)>0 ||
+         (!strcmp(cart->scan[iS].what.enddate,cart->scan[last].what.enddate) &&
+          strcmp(cart->scan[iS].what.endtime,cart->scan[last].what.endtime)>0)) last=iS;
+   }
+   if(first<0) { log_msg(LOG_WARN,"No data for the Cartesian product\n"); return(-1); }
+   if(cart_table(cart,&tab)) return(-1);
+   image=malloc(tab.n*sizeof(float));
+
+   cache_unshare(path);
+   H5F=H5Fcreate(path,H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
+   if(H5F<0 || !image) { free(image); free(tab.bin); free(tab.az); free(tab.scan); return(-1); }
+   H5LTset_attribute_string(H5F,"/","Conventions",getenv("ODIM_Conventions"));
+
+   G=H5Gcreate2(H5F,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   H5LTset_attribute_string(H5F,"what","object","IMAGE");
+   H5LTset_attribute_string(H5F,"what","version",getenv("ODIM_what_version"));
+   H5LTset_attribute_string(H5F,"what","date",cart->what.date);
+   H5LTset_attribute_string(H5F,"what","time",cart->what.time);
+   H5LTset_attribute_string(H5F,"what","source",cart->what.source);
+   H5Gclose(G);
+
+   G=H5Gcreate2(H5F,"where",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   snprintf(projdef,sizeof(projdef),"+proj=aeqd +lat_0=%.6f +lon_0=%.6f +R=%.0f +units=m +no_defs",
+            cart->where.lat,cart->where.lon,CART_EARTH_RADIUS);
+   H5LTset_attribute_string(H5F,"where","projdef",projdef);
+   add_attr_numeric_to_group(G,"xsize",&xsize,H5T_NATIVE_LLONG);
+   add_attr_numeric_to_group(G,"ysize",&xsize,H5T_NATIVE_LLONG);
+   add_attr_numeric_to_group(G,"xscale",&cart->scale,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G,"yscale",&cart->scale,H5T_NATIVE_DOUBLE);
+   cart_lonlat(cart,-half,-half,&lon,&lat);
+   add_attr_numeric_to_group(G,"LL_lon",&lon,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G,"LL_lat",&lat,H5T_NATIVE_DOUBLE);
+   cart_lonlat(cart,-half,half,&lon,&lat);
+   add_attr_numeric_to_group(G,"UL_lon",&lon,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G,"UL_lat",&lat,H5T_NATIVE_DOUBLE);
+   cart_lonlat(cart,half,half,&lon,&lat);
+   add_attr_numeric_to_group(G,"UR_lon",&lon,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G,"UR_lat",&lat,H5T_NATIVE_DOUBLE);
+   cart_lonlat(cart,half,-half,&lon,&lat);
+   add_attr_numeric_to_group(G,"LR_lon",&lon,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G,"LR_lat",&lat,H5T_NATIVE_DOUBLE);
+   H5Gclose(G);
+
+   G=H5Gcreate2(H5F,"how",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   H5LTset_attribute_string(H5F,"how","camethod","NEAREST");
+   for(iS=0;iS<cart->scans;iS++) angles[iS]=cart->scan[iS].elangle;
+   H5LTset_attribute_double(H5F,"how","angles",angles,cart->scans);
+   H5Gclose(G);
+
+   G=H5Gcreate2(H5F,"dataset1",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   H5Gclose(H5Gcreate2(G,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT));
+   H5LTset_attribute_string(G,"what","product",cart_product_name[cart->product]);
+   H5LTset_attribute_double(G,"what","prodpar",(cart->product==CART_PPI) ? &cart->scan[0].elangle : &cart->prodpar,1);
+   H5LTset_attribute_string(G,"what","startdate",cart->scan[first].what.startdate);
+   H5LTset_attribute_string(G,"what","starttime",cart->scan[first].what.starttime);
+   H5LTset_attribute_string(G,"what","enddate",cart->scan[last].what.enddate);
+   H5LTset_attribute_string(G,"what","endtime",cart->scan[last].what.endtime);
+
+   dims[0]=dims[1]=(hsize_t)cart->size;
+   nodata=cart->nodata;
+   undetect=cart->undetect;
+   for(q=0;q<cart->quantities;q++)
+   {
+      StoragePolicy storage=get_storage_policy(getenv("ODIM_STORAGE"),cart->quantity[q],cart->quantity[q],level);
+      hid_t D,G_data,G_what;
+
+      for(iS=0;iS<cart->scans && !cart->scan[iS].data[q];iS++);
+      if(iS==cart->scans) continue;
+      cart_parallel(cart,&tab,q,image,cart_project_rows);
+
+      sprintf(group,"data%d",++eQ);
+      G_data=H5Gcreate2(G,group,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+      D=create_dataset_by_policy(G_data,"data",&storage,sizeof(float),2,dims,dims,image);
+      write_dataset_rows(D,sizeof(float),0,dims[0],dims[1],image);
+      H5Dclose(D);
+      G_what=H5Gcreate2(G_data,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+      H5LTset_attribute_string(G_data,"what","quantity",cart->quantity[q]);
+      add_attr_numeric_to_group(G_what,"gain",&gain,H5T_NATIVE_DOUBLE);
+      add_attr_numeric_to_group(G_what,"offset",&offset,H5T_NATIVE_DOUBLE);
+      add_attr_numeric_to_group(G_what,"nodata",&nodata,H5T_NATIVE_DOUBLE);
+      add_attr_numeric_to_group(G_what,"undetect",&undetect,H5T_NATIVE_DOUBLE);
+      H5Gclose(G_what);
+      H5Gclose(G_data);
+   }
+   H5Gclose(G);
+   H5Fclose(H5F);
+   free(image);
+   free(tab.bin);
+   free(tab.az);
+   free(tab.scan);
+   return(0);
+}
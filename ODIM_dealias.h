@@ -0,0 +1,192 @@
+/*! \file ODIM_dealias.h
+\brief Dual-PRF velocity correction of <I>ODIM_encoder.c</I>: the velocities of a dual-PRF
+scan (lowprf != highprf, e.g. IRIS PRF_2_3, PRF_3_4 and PRF_4_5) are corrected while the
+scan is in memory and written as quantity VRADDH next to VRADH.
+
+The correction is made if ODIM_DEALIAS gives the output quantity:<BR>
+<B>ODIM_DEALIAS</B> : VRADDH (8-bit) or VRADDH2 (16-bit) <BR>
+<B>ODIM_DEALIAS_WINDOW</B> : half widths of the neighbourhood in rays and bins, default "1 2"
+(3 rays x 5 bins), at most DEALIAS_MAX_HALF <BR>
+<B>ODIM_DEALIAS_THREADS</B> : threads, default the number of online processors <BR>
+
+The velocity of a ray of a dual-PRF scan is unambiguous within the extended Nyquist
+interval NI, but a wrong unfolding of the ray adds an error of 2*n*Va of the PRF of the ray,
+Va being wavelength*PRF/4 of the low or of the high PRF. Which PRF a ray has is not known, so
+both are tried: the velocity is compared to the median of the valid bins of its
+neighbourhood, and if it differs by more than Va of the low PRF, the multiple of 2*Va of
+either PRF bringing it nearest to the median is added. A velocity then still differing by
+more than half of that Va is an outlier and is replaced by the median. Bins having fewer
+valid neighbours than half of the neighbourhood are not changed. The neighbourhood uses the
+uncorrected velocities, so the rays are corrected in parallel in blocks of rays, one block
+per thread.
+Rays wrap around in a full scan.<BR>
+Velocities are float [m/s], NaN being nodata and infinity undetect; these are kept.
+Include after ODIM_struct.h, link with -pthread.
+*/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+# define DEALIAS_MAX_THREADS 64 /**<\brief correction threads */
+# define DEALIAS_MAX_HALF 3     /**<\brief half width of the neighbourhood, rays and bins */
+
+/*!\struct DealiasConfig
+\brief Dual-PRF correction configuration */
+typedef struct {
+                  short quantity;    /*!< OQ_VRADDH or OQ_VRADDH2, 0 if no correction */
+                  int rays,bins;     /*!< half widths of the neighbourhood */
+                  int threads;
+               } DealiasConfig;
+
+/*!\struct DealiasJob
+\brief Rays corrected by one thread */
+typedef struct {
+                  DealiasConfig *cfg;
+                  const float *in;
+                  float *out;
+                  long nrays,nbins,ray0,ray1;
+                  double vlow,vhigh; /*!< unambiguous velocities of the low and high PRF [m/s] */
+                  int wrap;          /*!< rays wrap around */
+                  long corrected,replaced;
+               } DealiasJob;
+
+/** \brief Reads the configuration of the correction to <I>*cfg</I>. Returns 1 if it is made. */
+int dealias_init(DealiasConfig *cfg)
+{
+   char *envp;
+
+   memset(cfg,0,sizeof(DealiasConfig));
+   if((envp=getenv("ODIM_DEALIAS")))
+   {
+      if(!strcmp(envp,"VRADDH")) cfg->quantity=OQ_VRADDH;
+      if(!strcmp(envp,"VRADDH2")) cfg->quantity=OQ_VRADDH2;
+   }
+   cfg->rays=1;
+   cfg->bins=2;
+   if((envp=getenv("ODIM_DEALIAS_WINDOW"))) sscanf(envp,"%d %d",&cfg->rays,&cfg->bins);
+   if(cfg->rays<0 || cfg->rays>DEALIAS_MAX_HALF) cfg->rays=1;
+   if(cfg->bins<0 || cfg->bins>DEALIAS_MAX_HALF) cfg->bins=2;
+   cfg->threads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+   if((envp=getenv("ODIM_DEALIAS_THREADS"))) cfg->threads=atoi(envp);
+   if(cfg->threads<1) cfg->threads=1;
+   if(cfg->threads>DEALIAS_MAX_THREADS) cfg->threads=DEALIAS_MAX_THREADS;
+   return(cfg->quantity!=0);
+}
+
+/** \brief Median of <I>n</I> values, sorting them */
+static float dealias_median(float *v, int n)
+{
+   int i,j;
+
+   for(i=1;i<n;i++)
+   {
+      float x=v[i];
+
+      for(j=i;j>0 && v[j-1]>x;j--) v[j]=v[j-1];
+      v[j]=x;
+   }
+   return((n&1) ? v[n/2] : 0.5f*(v[n/2-1]+v[n/2]));
+}
+
+/** \brief Thread correcting rays ray0...ray1-1 */
+void *dealias_rays(void *arg)
+{
+   DealiasJob *job=arg;
+   int R=job->cfg->rays,B=job->cfg->bins;
+   int need=((2*R+1)*(2*B+1)-1)/2;
+   float nb[(2*DEALIAS_MAX_HALF+1)*(2*DEALIAS_MAX_HALF+1)];
+   double va[2]={job->vlow,job->vhigh};
+   long r,b,rr,bb;
+
+   if(need<1) need=1;
+   for(r=job->ray0;r<job->ray1;r++) for(b=0;b<job->nbins;b++)
+   {
+      float v=job->in[r*job->nbins+b],ref;
+      double best,cand;
+      int n=0,i,k;
+
+      job->out[r*job->nbins+b]=v;
+      if(!isfinite(v)) continue;
+      for(rr=r-R;rr<=r+R;rr++)
+      {
+         long ray=rr;
+
+         if(ray<0 || ray>=job->nrays)
+         {
+            if(!job->wrap) continue;
+            ray=(ray+job->nrays)%job->nrays;
+         }
+         for(bb=b-B;bb<=b+B;bb++)
+         {
+            float x;
+
+            if(bb<0 || bb>=job->nbins || (rr==r && bb==b)) continue;
+            x=job->in[ray*job->nbins+bb];
+            if(isfinite(x)) nb[n++]=x;
+         }
+      }
+      if(n<need) continue;
+      ref=dealias_median(nb,n);
+      if(fabs(v-ref)<=job->vlow) continue;
+
+      /* the multiple of 2*Va of the low or high PRF nearest to the median */
+      best=v;
+      for(i=0;i<2;i++)
+      {
+         k=(int)lround((ref-v)/(2.0*va[i]));
+         cand=v+2.0*k*va[i];
+         if(fabs(cand-ref)<fabs(best-ref)) best=cand;
+      }
+      if(fabs(best-ref)>0.5*job->vlow) { best=ref; job->replaced++; }
+      else job->corrected++;
+      job->out[r*job->nbins+b]=(float)best;
+   }
+   return(NULL);
+}
+
+/** \brief Corrects the velocities <I>in</I> of a dual-PRF scan of <I>nrays</I> x <I>nbins</I>
+to <I>out</I>, <I>vlow</I> and <I>vhigh</I> being the unambiguous velocities of the PRFs.
+<I>wrap</I> is set if the scan is a full circle. Returns the bins changed. */
+long dealias_scan(DealiasConfig *cfg, const float *in, float *out, long nrays, long nbins,
+                  double vlow, double vhigh, int wrap)
+{
+   pthread_t thread[DEALIAS_MAX_THREADS];
+   DealiasJob job[DEALIAS_MAX_THREADS];
+   int started[DEALIAS_MAX_THREADS]={0};
+   int t,n=cfg->threads;
+   long corrected=0,replaced=0;
+
+   if(n>nrays) n=(int)nrays;
+   if(n<1) return(0);
+   for(t=0;t<n;t++)
+   {
+      job[t].cfg=cfg;
+      job[t].in=in;
+      job[t].out=out;
+      job[t].nrays=nrays;
+      job[t].nbins=nbins;
+      job[t].ray0=nrays*t/n;
+      job[t].ray1=nrays*(t+1)/n;
+      job[t].vlow=vlow;
+      job[t].vhigh=vhigh;
+      job[t].wrap=wrap;
+      job[t].corrected=job[t].replaced=0;
+   }
+   for(t=1;t<n;t++) started[t]=!pthread_create(&thread[t],NULL,dealias_rays,&job[t]);
+   dealias_rays(&job[0]);
+   for(t=1;t<n;t++)
+   {
+      if(started[t]) pthread_join(thread[t],NULL);
+      else dealias_rays(&job[t]);
+   }
+   for(t=0;t<n;t++)
+   {
+      corrected+=job[t].corrected;
+      replaced+=job[t].replaced;
+   }
+   log_msg(LOG_INFO,"Dual-PRF correction: %ld bins unfolded, %ld outliers replaced\n",corrected,replaced);
+   return(corrected+replaced);
+}
@@ -13,15 +13,58 @@ as ODIM_OUTPUT_FILE variable. In both cases the ODIM style filename is written t
 file specified as ODIM_OUTPUT_DIR/ODIM_NAME_FILE. If user don't set the ODIM_NAME_FILE
 environment variable, the default filename is ODIM_filename.txt. All other
 input needed are also given as environment variables (see test.sh).
+
+With ODIM_PROFILES several outputs are made of the same input in one run, each profile in a
+process of its own with its own quantity selection, bit depths, compression and output file
+(see encode_profiles()). The input files are read once, before the processes are started, and
+the processes share that copy of them.
+
+ODIM_PHYSICAL=add adds to each data group a float32 dataset "physical" of the physical values
+gain*data+offset, ODIM_PHYSICAL=only stores them as "data" instead (see phys_8_to_f32()).
+
+ODIM_CROP_RANGE and ODIM_CROP_SECTOR crop the scans to a range window and an azimuth sector
+before they are converted and compressed (see crop_dataset()). ODIM_AVERAGE="N M" averages
+blocks of N bins and M rays of the converted data (see average_8()).
+
+With ODIM_STATISTICS=True the histogram, coverage and missing rays of each data are computed
+while it is converted and written as how attributes, so that quality control reads them
+instead of the data (see stats_8()).
+
+ODIM_EMPTY_DATA=minimal stores data of undetect or nodata only, found by a fast scan of the
+input (see uniform_8()), as the fill value of the dataset without compressing anything, and
+ODIM_EMPTY_DATA=skip leaves such data out.
+
+With ODIM_DEALIAS the velocities of dual-PRF scans are corrected after they are converted and
+written also as VRADDH (see ODIM_dealias.h).
+
+With ODIM_CART_FILE a Cartesian PPI or CAPPI of the volume is written also, projected from the
+scans while they are converted (see ODIM_cart.h).
 */
 
+/* 64-bit file offsets also in 32-bit builds */
+#define _FILE_OFFSET_BITS 64
+
 #include <hdf5.h>
 #include <hdf5_hl.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "ODIM_struct.h"
+#include "ODIM_io.h"
+#include "ODIM_timing.h"
+#include "ODIM_log.h"
+#include "ODIM_kernels.h"
+#include "ODIM_hdf5.h"
+#include "ODIM_quantities.h"
+#include "ODIM_cache.h"
+#include "ODIM_cart.h"
+#include "ODIM_dealias.h"
 
 # define uchar unsigned char
 # define FALSE 0
@@ -29,28 +72,324 @@ input needed are also given as environment variables (see test.sh).
 
 hid_t H5out;
 char groupattr[2000],A1,A2,outname[200],*origcenter,timestamp[100];
-QuantCfg QCF[OQ_QUANTS_TOTAL];
-uchar POL_H,POL_V,POL_HV,ALL_QUANTS=0;
-short wanted_scanquants[MAX_SCANS][MAX_QUANTS]={{0}};
+uchar POL_H,POL_V,POL_HV;
 short VERB=FALSE,QUIET=FALSE;
 size_t fres;
 char boolstr[2][6]={"False","True"};
 char flagname[2][16][50]={{{0}}};
 char *envp;
+char *PROFILE=NULL; /* output profile encoded by this process (ODIM_PROFILES), NULL if none */
+unsigned char **INPUT_DATA=NULL; /* input files by argument index, read before the profiles are started */
+size_t *INPUT_SIZE=NULL;
+double ENCODE_DEADLINE=0; /* target encoding time of the product [s] (ODIM_ENCODE_DEADLINE), 0 if none */
+double deadline_left=0; /* input bytes of the datasets not yet encoded */
+int PHYSICAL=0; /* float32 datasets of physical values (ODIM_PHYSICAL): 0 none, 1 added as "physical", 2 instead of "data" */
+float phys_nodata,phys_undetect; /* physical values of nodata and undetect bins (default NaN) */
+CartConfig CART; /* Cartesian product (ODIM_CART_FILE), see ODIM_cart.h */
+int CROP=0; /* scans cropped (ODIM_CROP_RANGE, ODIM_CROP_SECTOR), see crop_dataset() */
+double CROP_RANGE[2]={0,0},CROP_SECTOR[2]={0,0}; /* range window [km] and sector [deg] */
+int AVG_BINS=1,AVG_RAYS=1; /* bins and rays averaged (ODIM_AVERAGE), see average_8() */
+int STATISTICS=0; /* statistics of the data as how attributes (ODIM_STATISTICS), see stats_8() */
+int EMPTY_DATA=0; /* data of undetect or nodata only (ODIM_EMPTY_DATA): 0 written, 1 minimal, 2 skipped */
+# define UNIFORM_RAYS 64 /* rays read at a time by the fast scan of ODIM_EMPTY_DATA */
+DealiasConfig DEALIAS; /* dual-PRF velocity correction (ODIM_DEALIAS), see ODIM_dealias.h */
+
+extern char **environ;
+
+/** \brief Value of variable ODIM_<I>X</I> in profile <I>name</I>, NULL if not set */
+char *profile_env(const char *name, const char *X)
+{
+   char var[300],*value;
+
+   snprintf(var,sizeof(var),"ODIM_PROFILE_%s_%s",name,X);
+   if((value=getenv(var))) return(value);
+   snprintf(var,sizeof(var),"ODIM_%s",X);
+   return(getenv(var));
+}
+
+/** \brief Reads the input files, arguments of <I>argv</I> not being options, to INPUT_DATA.
+Nothing is read if they are over ODIM_MEMORY_BUDGET, the profiles then read the files. */
+void read_inputs(int argc, char *argv[])
+{
+   struct stat st;
+   long long total=0,budget=memory_budget();
+   int i;
+
+   for(i=1;i<argc;i++) if(argv[i][0]!='-' && !stat(argv[i],&st)) total+=st.st_size;
+   if(budget && total>budget) return;
+   INPUT_DATA=calloc(argc,sizeof(unsigned char *));
+   INPUT_SIZE=calloc(argc,sizeof(size_t));
+   for(i=1;i<argc;i++)
+   {
+      FILE *F;
+
+      if(argv[i][0]=='-' || stat(argv[i],&st) || st.st_size<=0 || !(F=fopen(argv[i],"r"))) continue;
+      INPUT_DATA[i]=malloc(st.st_size);
+      if(INPUT_DATA[i] && fread(INPUT_DATA[i],st.st_size,1,F)==1) INPUT_SIZE[i]=st.st_size;
+      else { free(INPUT_DATA[i]); INPUT_DATA[i]=NULL; }
+      fclose(F);
+   }
+}
+
+/** \brief Opens input file \#<I>fI</I> of the arguments, <I>path</I>, from INPUT_DATA if read
+there */
+FILE *open_input(int fI, const char *path)
+{
+   if(INPUT_DATA && INPUT_DATA[fI]) return(fmemopen(INPUT_DATA[fI],INPUT_SIZE[fI],"r"));
+   return(fopen(path,"r"));
+}
+
+/** \brief Continues hash <I>*h</I> with input file \#<I>fI</I> of the arguments, <I>path</I>,
+as cache_hash_file(). Returns 0 if ok. */
+int hash_input(int fI, const char *path, uint64_t *h)
+{
+   size_t i,n;
+
+   if(!INPUT_DATA || !INPUT_DATA[fI]) return(cache_hash_file(path,h));
+   for(i=0;i<INPUT_SIZE[fI];i+=n)
+   {
+      n=INPUT_SIZE[fI]-i;
+      if(n>(1<<20)) n=1<<20; /* the blocks of cache_hash_file() */
+      *h=cache_hash(*h,INPUT_DATA[fI]+i,n);
+   }
+   return(0);
+}
+
+/** \brief Encodes each output profile of the space or comma separated list <I>profiles</I>
+in a child process of its own. Variables ODIM_PROFILE_<I>name</I>_<I>X</I> of a profile
+replace ODIM_<I>X</I> in its child (e.g. OUTPUT_FILE, OUTPUT_DIR, NAME_FILE, COMPRESSION_LEVEL),
+ODIM_PROFILE_<I>name</I>_quantities replaces ODIM_<I>SITE</I>_quantities. Profiles writing the
+same output file (or Cartesian file) are rejected. The input files are read before the children
+are started (read_inputs()), they share the copy. Returns -1 in the children, in the parent 0
+if all profiles were encoded, otherwise 1. */
+int encode_profiles(char *profiles, int argc, char *argv[])
+{
+   char *list=strdup(profiles),*name,*save=NULL,**outputs;
+   int children=0,status=0,n=0,i;
+
+   /* output paths of the profiles, the ODIM named file being "*" */
+   outputs=calloc(2*strlen(profiles)+2,sizeof(char *));
+   for(name=strtok_r(list," ,",&save);name;name=strtok_r(NULL," ,",&save))
+   {
+      char *dir=profile_env(name,"OUTPUT_DIR"),*file=profile_env(name,"OUTPUT_FILE"),
+           *cart=profile_env(name,"CART_FILE"),path[2100];
+
+      if(!dir) dir=".";
+      snprintf(path,sizeof(path),"%s/%s",dir,file ? file : "*");
+      outputs[n++]=strdup(path);
+      if(cart)
+      {
+         snprintf(path,sizeof(path),"%s/%s",dir,cart);
+         outputs[n++]=strdup(path);
+      }
+   }
+   for(i=0;i<n;i++)
+   {
+      int j;
+
+      for(j=0;j<i;j++) if(!strcmp(outputs[i],outputs[j]))
+      {
+         fprintf(stderr,"Profiles of %s write the same output %s, give them their own OUTPUT_FILE or OUTPUT_DIR\n",
+                 profiles,outputs[i]);
+         status=1;
+      }
+   }
+   for(i=0;i<n;i++) free(outputs[i]);
+   free(outputs);
+   if(status) { free(list); return(status); }
+
+   read_inputs(argc,argv);
+   strcpy(list,profiles);
+   for(name=strtok_r(list," ,",&save);name;name=strtok_r(NULL," ,",&save))
+   {
+      pid_t pid=fork();
+
+      if(pid<0) { fprintf(stderr,"Cannot start encoder of profile %s\n",name); status=1; continue; }
+      if(pid==0)
+      {
+         char prefix[300],**env;
+         size_t len,n=0,i;
+
+         /* the variables of the profile are set, those of all profiles removed */
+         snprintf(prefix,sizeof(prefix),"ODIM_PROFILE_%s_",name);
+         len=strlen(prefix);
+         for(i=0;environ[i];i++) n++;
+         env=calloc(n+1,sizeof(char *));
+         for(n=i=0;environ[i];i++) if(!strncmp(environ[i],"ODIM_PROFILE",12)) env[n++]=strdup(environ[i]);
+         for(i=0;i<n;i++)
+         {
+            char *eq=strchr(env[i],'=');
+
+            *eq=0;
+            if(!strncmp(env[i],prefix,len) && strcmp(env[i]+len,"quantities"))
+            {
+               char var[300];
+
+               snprintf(var,sizeof(var),"ODIM_%s",env[i]+len);
+               setenv(var,eq+1,1);
+            }
+            if(strncmp(env[i],prefix,len) || strcmp(env[i]+len,"quantities")) unsetenv(env[i]);
+            free(env[i]);
+         }
+         free(env);
+         PROFILE=strdup(name);
+         free(list);
+         return(-1);
+      }
+      children++;
+   }
+   free(list);
+   while(children)
+   {
+      int st;
+
+      if(wait(&st)<0) break;
+      children--;
+      if(!WIFEXITED(st) || WEXITSTATUS(st)) status=1;
+   }
+   return(status);
+}
+
+/** \brief Seconds of the monotonic clock */
+double now_secs(void)
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC,&t);
+   return((double)t.tv_sec+1.0e-9*(double)t.tv_nsec);
+}
+
+/** \brief Compression level of the next dataset under ODIM_ENCODE_DEADLINE. <I>level</I> is
+lowered by one if the input rate of the last dataset (<I>last_bytes</I> in <I>last_secs</I>)
+does not encode the remaining deadline_left bytes in the time left after <I>elapsed</I>
+seconds, to 0 if the deadline has passed. The level is never raised within a product. */
+int deadline_level(int level, double elapsed, double last_bytes, double last_secs)
+{
+   double left=ENCODE_DEADLINE-elapsed;
+
+   if(left<=0) return(0);
+   if(last_secs<=0 || level<=1) return(level);
+   if(last_bytes/last_secs*left < deadline_left) level--;
+   return(level);
+}
+
+/** \brief Writes statistics <I>*st</I> of data of <I>nrays</I> x <I>nbins</I> <I>bytes</I> byte
+bins, gain <I>gain</I> and offset <I>offset</I>, as attributes of group <I>G_datahow</I> (ODIM_STATISTICS) */
+void write_stats(hid_t G_datahow, ScanStats *st, long nrays, long nbins, int bytes, double gain, double offset)
+{
+   /* class k of the histogram has codes k*step ... (k+1)*step-1 (step 1 or 256), that is
+      physical values from histogram_start+k*histogram_width */
+   int64_t missing=(int64_t)st->missing_rays;
+   double coverage=(nrays*nbins>0) ? 1.0-(double)(st->nodata+st->undetect)/((double)nrays*nbins) : 0;
+   double width=gain*((bytes==1) ? 1 : 256);
+   long long hist[256];
+   int c;
+
+   for(c=0;c<256;c++) hist[c]=(long long)st->hist[c];
+   add_attr_numeric_to_group(G_datahow,"coverage",&coverage,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G_datahow,"missing_rays",&missing,H5T_NATIVE_LLONG);
+   H5LTset_attribute_long_long(G_datahow,".","histogram",hist,256);
+   add_attr_numeric_to_group(G_datahow,"histogram_start",&offset,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G_datahow,"histogram_width",&width,H5T_NATIVE_DOUBLE);
+}
+
+/** \brief Corrects velocities <I>vel</I> [m/s] of a dual-PRF scan of <I>dims</I> (ODIM_DEALIAS)
+and writes them as the next data group of dataset group <I>setgroup</I> of file <I>H5F</I>, <I>*eQ</I>
+being the last data group. <I>vlow</I> and <I>vhigh</I> are the unambiguous velocities of the PRFs. The
+datasets are stored in chunks of <I>chunk</I> by the storage policy of VRADDH at compression
+level <I>level</I>, and the physical values kept for the Cartesian product in scan
+<I>cartslot</I>. <I>wrap</I> is set if the scan is a full circle, its first and last rays being
+neighbours. Returns the missing rays of the data, -1 if ODIM_STATISTICS is not set. */
+int64_t write_dealiased(hid_t H5F, char *setgroup, short *eQ, float *vel, double vlow, double vhigh, hsize_t *dims,
+                        hsize_t *chunk, int level, int cartslot, int wrap)
+{
+   QuantCfg q=QCF[DEALIAS.quantity];
+   long nrays=dims[0],nbins=dims[1],n=nrays*nbins,i;
+   int bytes=(DEALIAS.quantity==OQ_VRADDH) ? 1 : 2;
+   int cartq=(cartslot>=0) ? cart_quantity(&CART,q.quantity) : -1;
+   double gain=q.gain,offset=q.offset,nodata=q.nodata,undetect=q.undetect;
+   float *out=malloc(n*sizeof(float));
+   uint8_t *codes=malloc(n*bytes);
+   char datagroup[250];
+   StoragePolicy storage;
+   ScanStats stats;
+   hid_t G_data,G_datawhat,G_datahow,D;
+
+   timing_start(T_DEALIAS);
+   dealias_scan(&DEALIAS,vel,out,nrays,nbins,vlow,vhigh,wrap);
+   f32_to_code(out,n,bytes,gain,offset,(uint16_t)q.nodata,(uint16_t)q.undetect,codes);
+   memset(&stats,0,sizeof(stats));
+   if(STATISTICS && bytes==1) stats_8(codes,nrays,nbins,(uchar)q.nodata,(uchar)q.undetect,&stats);
+   if(STATISTICS && bytes==2) stats_16(codes,nrays,nbins,(uint16_t)q.nodata,(uint16_t)q.undetect,&stats);
+   /* physical values of the output */
+   for(i=0;i<n;i++) out[i]=isnan(out[i]) ? phys_nodata : (isinf(out[i]) ? phys_undetect : out[i]);
+   if(cartq>=0) memcpy(cart_scan_buffer(&CART,cartslot,cartq),out,n*sizeof(float));
+   timing_stop(T_DEALIAS);
+
+   (*eQ)++;
+   sprintf(datagroup,"%s/data%d",setgroup,*eQ);
+   log_msg(LOG_INFO,"\nWRITING %s, dual-PRF corrected VRADH\nDATAGROUP %s\n",q.in_quantity,datagroup);
+   G_data=H5Gcreate2(H5F,datagroup,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   storage=get_storage_policy(getenv("ODIM_STORAGE"),q.quantity,q.in_quantity,level);
+   timing_start(T_DEFLATE);
+   if(PHYSICAL!=2)
+   {
+      D=create_dataset_by_policy(G_data,"data",&storage,bytes,2,dims,chunk,codes);
+      write_dataset_rows(D,bytes,0,nrays,nbins,codes);
+      H5Dclose(D);
+   }
+   if(PHYSICAL)
+   {
+      D=create_dataset_by_policy(G_data,(PHYSICAL==2) ? "data" : "physical",&storage,sizeof(float),2,dims,chunk,out);
+      write_dataset_rows(D,sizeof(float),0,nrays,nbins,out);
+      H5Dclose(D);
+   }
+   timing_stop(T_DEFLATE);
+   timing_count(0,(uint64_t)n*bytes,n);
+
+   timing_start(T_ATTRS);
+   if(bytes==1 && PHYSICAL!=2)
+   {
+      H5LTset_attribute_string(G_data,"data","CLASS","IMAGE");
+      H5LTset_attribute_string(G_data,"data","IMAGE_VERSION","1.2");
+   }
+   G_datawhat=H5Gcreate2(G_data,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   G_datahow=H5Gcreate2(G_data,"how",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
+   if(PHYSICAL==1)
+   {
+      double nd=phys_nodata,ud=phys_undetect;
 
-/*-----------------------------------------------------------------------------------------*/
-/** \brief Adds any HDF5 scalar numeric attribute named <I>*attr</I> to group named <I>*group</I> and sets it to value <I>val</I>, with wanted type */
-int  add_attr_numeric_to_group(hid_t group, char *attr, void *val, hid_t type);
-/** \brief Adds dataset to group */
-hid_t add_dataset_to_group(hid_t group, char *name, int compress_level,int bytes, int rank, hsize_t *dims, void *data);
-/** \brief Gives quantity code of ODIM quantity name <I>*Qstr</I> */
-short getQuantityCode(char *Qstr);
-/** \brief sets parameters (gain, offset, nodata, undetect) of all quantities */
-void SetQuantityParams();
-/** \brief Parses wanted quantities for encoding from ODIM_</I>SITE</I>_quantities environment
-variable.<BR> <I>SITE</I> is the IRIS radar site code.<BR> The codes of quantities found are
-put to <I>wanted_scanquants[scan index][quantity index]</I> table. */ 
-void get_wanted_quantities(char *Qstr);
+      H5LTset_attribute_double(G_data,"physical","nodata",&nd,1);
+      H5LTset_attribute_double(G_data,"physical","undetect",&ud,1);
+   }
+   if(STATISTICS) write_stats(G_datahow,&stats,nrays,nbins,bytes,gain,offset);
+   if(PHYSICAL==2)
+   {
+      gain=1.0;
+      offset=0.0;
+      nodata=phys_nodata;
+      undetect=phys_undetect;
+   }
+   add_attr_numeric_to_group(G_datawhat,"gain",&gain,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G_datawhat,"nodata",&nodata,H5T_NATIVE_DOUBLE);
+   add_attr_numeric_to_group(G_datawhat,"offset",&offset,H5T_NATIVE_DOUBLE);
+   H5LTset_attribute_string(G_data,"what","quantity",q.quantity);
+   add_attr_numeric_to_group(G_datawhat,"undetect",&undetect,H5T_NATIVE_DOUBLE);
+   H5LTset_attribute_string(G_data,"how","dealiased","True");
+   if(ENCODE_DEADLINE>0)
+   {
+      int64_t clevel=storage.contiguous ? 0 : storage.level;
+
+      add_attr_numeric_to_group(G_datahow,"compression_level",&clevel,H5T_NATIVE_LLONG);
+   }
+   H5Gclose(G_datawhat);
+   H5Gclose(G_datahow);
+   H5Gclose(G_data);
+   timing_stop(T_ATTRS);
+   free(out);
+   free(codes);
+   return(STATISTICS ? (int64_t)stats.missing_rays : -1);
+}
 
 int main(int argc, char** argv)
 {
@@ -61,9 +400,11 @@ int main(int argc, char** argv)
   /*  unsigned char strattr[1000]; */
   char *outdir=NULL,*outfile=NULL,*odimname=NULL,*compress_str=NULL;
   int compresslevel;
+  double deadline_start,last_bytes=0,last_secs=0;
   char ODIM_namestr[200];
+  static char cachefile[1100],cachename[1100],cachecart[1100],cartname[1100];
   char def_outdir[2]=".";
-  char datagroup[200],
+  char datagroup[250],
        setgroup[200];
 
   short argF,last_Q=0,radnum=0;
@@ -71,6 +412,7 @@ int main(int argc, char** argv)
   FILE *METAF;
   char envname[1000]={0},sitecode[4]={0};
   MetaData *meta;
+  long metasize;
 
   RootWhat in_what;
   RootWhere in_where;
@@ -81,7 +423,14 @@ int main(int argc, char** argv)
 
   /*-----------------------------------------------------------------------------------------*/
 
-  setbuf(stdout,NULL);
+  /* several outputs of the input, each encoded by a child of its own */
+  if(getenv("ODIM_PROFILES"))
+  {
+     int status=encode_profiles(getenv("ODIM_PROFILES"),argc,argv);
+
+     if(status>=0) return(status);
+  }
+
   SetQuantityParams();
   origcenter=getenv("ODIM_ORIGCENTER");
   outdir=getenv("ODIM_OUTPUT_DIR");
@@ -91,6 +440,30 @@ int main(int argc, char** argv)
   compress_str=getenv("ODIM_COMPRESSION_LEVEL");
   if(compress_str==NULL) compresslevel=6; else compresslevel=atoi(compress_str);
   if(compresslevel < 0 || compresslevel > 9) compresslevel=6;
+  if(getenv("ODIM_ENCODE_DEADLINE")) ENCODE_DEADLINE=atof(getenv("ODIM_ENCODE_DEADLINE"));
+  if(ENCODE_DEADLINE<0) ENCODE_DEADLINE=0;
+  deadline_start=now_secs();
+  if((envp=getenv("ODIM_PHYSICAL")))
+  {
+     if(!strcmp(envp,"add")) PHYSICAL=1;
+     if(!strcmp(envp,"only")) PHYSICAL=2;
+  }
+  phys_nodata=phys_undetect=NAN;
+  if(getenv("ODIM_PHYSICAL_NODATA")) phys_nodata=atof(getenv("ODIM_PHYSICAL_NODATA"));
+  if(getenv("ODIM_PHYSICAL_UNDETECT")) phys_undetect=atof(getenv("ODIM_PHYSICAL_UNDETECT"));
+  if(cart_init(&CART,phys_nodata,phys_undetect)) sprintf(cartname,"%s/%s",outdir,CART.file);
+  if((envp=getenv("ODIM_CROP_RANGE")) && sscanf(envp,"%lf %lf",&CROP_RANGE[0],&CROP_RANGE[1])==2) CROP=1;
+  if((envp=getenv("ODIM_CROP_SECTOR")) && sscanf(envp,"%lf %lf",&CROP_SECTOR[0],&CROP_SECTOR[1])==2) CROP=1;
+  if((envp=getenv("ODIM_AVERAGE"))) sscanf(envp,"%d %d",&AVG_BINS,&AVG_RAYS);
+  if(AVG_BINS<1 || AVG_BINS>256) AVG_BINS=1;
+  if(AVG_RAYS<1 || AVG_RAYS>256) AVG_RAYS=1;
+  dealias_init(&DEALIAS);
+  if((envp=getenv("ODIM_EMPTY_DATA")))
+  {
+     if(!strcmp(envp,"minimal")) EMPTY_DATA=1;
+     if(!strcmp(envp,"skip")) EMPTY_DATA=2;
+  }
+  if((envp=getenv("ODIM_STATISTICS"))) STATISTICS=(!strcasecmp(envp,"true") || !strcmp(envp,"1"));
 
   argF=1;
   {
@@ -103,6 +476,45 @@ int main(int argc, char** argv)
        argF++;
     }
   }
+  log_open("ODIM_encoder",VERB ? LOG_INFO : LOG_OUT);
+  if(argF<argc) log_product(argv[argF]);
+  timing_init("ODIM_encoder",argF<argc ? argv[argF] : NULL);
+
+  /* a volume encoded before from the same intermediate files and configuration is taken
+     from the cache, the entry .name has its ODIM filename */
+  if(getenv("ODIM_CACHE_DIR") && argF<argc)
+  {
+     uint64_t key=0,config=cache_config_hash("ODIM_encoder",NULL);
+
+     timing_start(T_READ);
+     for(fI=argF; fI < argc && !hash_input(fI,argv[fI],&key); fI++);
+     timing_stop(T_READ);
+     if(fI==argc)
+     {
+        cache_entry(cachefile,sizeof(cachefile),key,config,".h5");
+        cache_entry(cachename,sizeof(cachename),key,config,".name");
+        cache_entry(cachecart,sizeof(cachecart),key,config,".cart.h5");
+     }
+     if(!cache_fetch_string(cachename,ODIM_namestr,sizeof(ODIM_namestr)))
+     {
+        int len=snprintf(outname,sizeof(outname),"%s/%s",outdir,outfile ? outfile : ODIM_namestr);
+
+        if(len<0 || len>=(int)sizeof(outname)) log_msg(LOG_WARN,"Output path too long, cache not used\n");
+        else if(!cache_fetch(cachefile,outname) && (!CART.file || !cache_fetch(cachecart,cartname)))
+        {
+           log_msg(LOG_INFO,"%s from cache %s\n",outname,cachefile);
+           if(outfile==NULL && odimname)
+           {
+              FILE *ODIM_NAME=fopen(odimname,"w");
+
+              if(ODIM_NAME) { fprintf(ODIM_NAME,"%s/%s",outdir,ODIM_namestr); fclose(ODIM_NAME); }
+           }
+           if(!QUIET) log_msg(LOG_OUT,"%s\n",outname);
+           timing_report();
+           return(0);
+        }
+     }
+  }
 
   /* set the names of IRIS flag attributes */
   sprintf(flagname[0][0],"f_speckle_Z");
@@ -131,18 +543,30 @@ int main(int argc, char** argv)
   {
 
     /* argv[1] is the volume HDF5 file, all others are IRIS metadata/data files */
-     METAF=fopen(argv[fI],"r");
-     fres=fread(&meta[0],1,sizeof(MetaData),METAF);
+     METAF=open_input(fI,argv[fI]);
+     free_metadata(meta);
+     timing_start(T_READ);
+     metasize=METAF ? read_metadata(METAF,meta) : -1;
+     timing_stop(T_READ);
+     if(metasize<0)
+     {
+        log_msg(LOG_ERR,"Cannot read intermediate file %s, skipping it\n",argv[fI]);
+        if(METAF) fclose(METAF);
+        continue;
+     }
+     timing_count(metasize,0,0);
      scans=meta->scans;
-     if(VERB) printf("\n=========================================================================================\n");
-     if(VERB) printf("\nFile %s, having %ld scans \n",argv[fI],(long)scans);
+     for(iS=0;iS<scans;iS++) for(iQ=0;iQ<meta->dataset[iS].quantities;iQ++)
+        deadline_left+=(double)meta->dataset[iS].where.nrays*meta->dataset[iS].where.nbins*meta->dataset[iS].data[iQ].what.bytes;
+     log_msg(LOG_INFO,"\n=========================================================================================\n");
+     log_msg(LOG_INFO,"\nFile %s, having %ld scans \n",argv[fI],(long)scans);
 
      in_what=meta->what;
      in_where=meta->where;
      in_how=meta->how;
 
      sprintf(sitecode,"%.3s",in_where.sitecode);
-     /*    if(VERB) printf("SITECODE %s\n",sitecode); */
+     /*    log_msg(LOG_INFO,"SITECODE %s\n",sitecode); */
 
      if(!scans_total) /* common metadata for whole volume is taken from the first scan or subvolume */
      {
@@ -150,16 +574,25 @@ int main(int argc, char** argv)
          /* reading wanted quantities */
          char *Wstr=NULL;
 
-         sprintf(envname,"ODIM_%s_quantities",sitecode);
-         Wstr=getenv(envname);
+         if(PROFILE)
+         {
+            sprintf(envname,"ODIM_PROFILE_%s_quantities",PROFILE);
+            Wstr=getenv(envname);
+         }
+         if(!Wstr)
+         {
+            sprintf(envname,"ODIM_%s_quantities",sitecode);
+            Wstr=getenv(envname);
+         }
          get_wanted_quantities(Wstr);
        }
-       /*       for(S=0;S<wanted_quants;S++)if(VERB) printf("%s\n",wanted_quantarr[S]); */
+       /*       for(S=0;S<wanted_quants;S++)log_msg(LOG_INFO,"%s\n",wanted_quantarr[S]); */
 
         sprintf(timestamp,"%s%s",meta->dataset[0].what.startdate,meta->dataset[0].what.starttime);
         sprintf(envname,"ODIM_%s_source",sitecode);
         sprintf(in_what.source,"%s",getenv(envname));
         radnum=atoi(strstr(in_what.source,"RAD:")+6);
+        cart_volume(&CART,&in_what,&in_where,&in_how);
 
        /* !!! outname pitää olla tmpname, koska lopullista tiedostonimeä ei voi
           luoda, ennen kuin kaikki PPI:t on käyty läpi, eli A1 ja A2 on generoitu !!! 
@@ -174,6 +607,8 @@ int main(int argc, char** argv)
           sprintf(outname,"%s/%s",outdir,ODIM_namestr);
        }
 
+       timing_start(T_ATTRS);
+       cache_unshare(outname);
        H5out=H5Fcreate(outname,H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT);
        H5LTset_attribute_string(H5out,"/","Conventions",getenv("ODIM_Conventions"));
        G_root_what=H5Gcreate2(H5out,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
@@ -244,7 +679,7 @@ int main(int argc, char** argv)
         /* add_attr_numeric_to_group(G_root_how,"NI",&in_how.NI,H5T_NATIVE_DOUBLE); per scan */
         /* add_attr_numeric_to_group(G_root_how,"Vsamples",&in_how.Vsamples,H5T_NATIVE_LLONG); per scan */
         /* add_attr_numeric_to_group(G_root_how,"radhoriz",&in_how.radhoriz,H5T_NATIVE_DOUBLE); per scan */
-
+        timing_stop(T_ATTRS);
      }
 
   /*------------------ looping thru scans ----------------------------------------------*/
@@ -254,41 +689,86 @@ int main(int argc, char** argv)
         SetWhat in_setwhat;    
         SetWhere in_setwhere;    
         How in_sethow; 
-        long nbins,nrays,quantities;
-        ulong insize,outsize;
+        long nbins,nrays,quantities,in_nbins,in_nrays,ray0=0,bin0=0,crop_nbins,crop_nrays;
+        uint64_t insize,outsize;
         short DPOL,eQ=0,acc_quants,wanted_quants_in_scan;
-        short outbytes,AQ,WQ,aq,wq; 
-        double relangle;
+        short outbytes,AQ,WQ,aq,wq,*wanted; 
+        double relangle,scanbytes;
         hid_t G_dataset,G_dataset_what,G_dataset_where,G_dataset_how;
+        int cartslot;
+        int64_t sweep_missing=-1; /* missing rays of the scan (ODIM_STATISTICS), most of a quantity */
+        int in_vraddh=0; /* VRADDH of the input is written, ODIM_DEALIAS does not add one */
 
         iS=S-1; /* scan index of read data array */
         tS=S+scans_total; /* dataset index */ 
+        /* a sweep file of the decoder (ODIM_SWEEP_FILE) has its index in the volume */
+        if(scans==1 && in_how.scan_count>1 && meta->dataset[iS].how.scan_index>0) tS=meta->dataset[iS].how.scan_index;
 
         in_setwhat=meta->dataset[iS].what;
         in_setwhere=meta->dataset[iS].where;
         in_sethow=meta->dataset[iS].how;
 
-        wanted_quants_in_scan = wanted_scanquants[tS][0];
+        wanted = wanted_quants_of_scan(tS);
+        wanted_quants_in_scan = wanted[0];
 
-        if(!wanted_quants_in_scan) continue;
+        scanbytes=0;
+        for(iQ=0;iQ<meta->dataset[iS].quantities;iQ++)
+           scanbytes+=(double)in_setwhere.nrays*in_setwhere.nbins*meta->dataset[iS].data[iQ].what.bytes;
+        if(!wanted_quants_in_scan) { deadline_left-=scanbytes; fseeko(METAF,(off_t)scanbytes,SEEK_CUR); continue; }
         acc_quants=0;
-        for(wq=0;wq<MAX_QUANTS;wq++)
+        for(wq=0;;wq++)
         {
-          WQ=wanted_scanquants[tS][wq];
+          WQ=wanted[wq];
           if(!WQ) break;
           if(WQ<0) { acc_quants++; break; }
-          for(aq=0;aq<MAX_QUANTS;aq++)
+          for(aq=0;aq<meta->dataset[iS].quantities;aq++)
           {
              AQ=meta->dataset[iS].data[aq].what.QuantIdx;
-             /*if(VERB) printf("AQ %d WQ %d\n",AQ,WQ); */
+             /*log_msg(LOG_INFO,"AQ %d WQ %d\n",AQ,WQ); */
              if((WQ == AQ) || (WQ == AQ+TWOB) || (AQ == WQ+TWOB)) { acc_quants++; break; }
              if(!AQ) break;
           }
         } 
-        if(!acc_quants) continue;
+        if(!acc_quants) { deadline_left-=scanbytes; fseeko(METAF,(off_t)scanbytes,SEEK_CUR); continue; }
+        for(aq=0;DEALIAS.quantity && aq<meta->dataset[iS].quantities;aq++)
+        {
+           AQ=meta->dataset[iS].data[aq].what.QuantIdx;
+           if(AQ!=OQ_VRADDH && AQ!=OQ_VRADDH2) continue;
+           if(ALL_QUANTS) in_vraddh=1;
+           for(wq=0;!in_vraddh && wanted[wq];wq++)
+           {
+              WQ=wanted[wq];
+              if(WQ<0 || WQ==AQ || WQ==AQ+TWOB || AQ==WQ+TWOB) in_vraddh=1;
+           }
+        }
+
+        /* the scan is cropped to the range window and sector before any conversion */
+        in_nrays=in_setwhere.nrays;
+        in_nbins=in_setwhere.nbins;
+        if(CROP)
+        {
+           if(!crop_dataset(&meta->dataset[iS],CROP_RANGE[0],CROP_RANGE[1],CROP_SECTOR[0],CROP_SECTOR[1],&ray0,&bin0))
+           {
+              log_msg(LOG_INFO,"Scan %d is outside the crop, skipping it\n",tS);
+              deadline_left-=scanbytes;
+              fseeko(METAF,(off_t)scanbytes,SEEK_CUR);
+              continue;
+           }
+           in_setwhere=meta->dataset[iS].where;
+        }
+        /* and averaged after the conversion */
+        crop_nrays=in_setwhere.nrays;
+        crop_nbins=in_setwhere.nbins;
+        if(AVG_BINS>1 || AVG_RAYS>1)
+        {
+           average_dataset(&meta->dataset[iS],AVG_BINS,AVG_RAYS);
+           in_setwhere=meta->dataset[iS].where;
+           in_sethow=meta->dataset[iS].how;
+        }
 
         vol_scan_number++;
-	if(VERB) printf("\n\nENCODING SCAN #%d\n=====================================================\n",(int)vol_scan_number);
+        cartslot=CART.file ? cart_begin_scan(&CART,&meta->dataset[iS]) : -1;
+	log_msg(LOG_INFO,"\n\nENCODING SCAN #%d\n=====================================================\n",(int)vol_scan_number);
 
         POL_H=in_sethow.POL_H;
         POL_V=in_sethow.POL_V;
@@ -298,6 +778,7 @@ int main(int argc, char** argv)
            strchr(in_sethow.polarization,'V')) DPOL=1;
   
         /* DATASETs */
+        timing_start(T_ATTRS);
         sprintf(setgroup,"/dataset%d",(int)vol_scan_number);
         G_dataset=H5Gcreate2(H5out,setgroup,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
         G_dataset_what=H5Gcreate2(G_dataset,"what",H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
@@ -319,6 +800,11 @@ int main(int argc, char** argv)
         add_attr_numeric_to_group(G_dataset_where,"rscale",&in_setwhere.rscale,H5T_NATIVE_DOUBLE);
         add_attr_numeric_to_group(G_dataset_where,"nrays",&in_setwhere.nrays,H5T_NATIVE_LLONG);
         add_attr_numeric_to_group(G_dataset_where,"a1gate",&in_setwhere.a1gate,H5T_NATIVE_LLONG);
+        if(in_setwhere.startaz!=in_setwhere.stopaz) /* sector of a sweep (ODIM_SECTOR_WIDTH) */
+        {
+           add_attr_numeric_to_group(G_dataset_where,"startaz",&in_setwhere.startaz,H5T_NATIVE_DOUBLE);
+           add_attr_numeric_to_group(G_dataset_where,"stopaz",&in_setwhere.stopaz,H5T_NATIVE_DOUBLE);
+        }
 
         /* /datasetS/how attributes */
         add_attr_numeric_to_group(G_dataset_how,"scan_index",&vol_scan_number,H5T_NATIVE_LLONG);  
@@ -346,9 +832,10 @@ int main(int argc, char** argv)
         if(POL_H | POL_HV) add_attr_numeric_to_group(G_dataset_how,"radconstH",&in_sethow.radconstH,H5T_NATIVE_DOUBLE);  
         add_attr_numeric_to_group(G_dataset_how,"binmethod_avg",&in_sethow.binmethod_avg,H5T_NATIVE_LLONG);  
         H5LTset_attribute_string(G_dataset,"how","binmethod",in_sethow.binmethod);  
+        if(AVG_RAYS>1) H5LTset_attribute_string(G_dataset,"how","azmethod","AVERAGE");
 
-        H5LTset_attribute_double(G_dataset,"how","startazA",in_sethow.startazA,in_setwhere.nrays);  
-        H5LTset_attribute_double(G_dataset,"how","stopazA",in_sethow.stopazA,in_setwhere.nrays);
+        H5LTset_attribute_double(G_dataset,"how","startazA",meta->dataset[iS].startazA,in_setwhere.nrays);  
+        H5LTset_attribute_double(G_dataset,"how","stopazA",meta->dataset[iS].stopazA,in_setwhere.nrays);
 
         H5LTset_attribute_string(G_dataset,"how","polmode",in_sethow.polmode); /* V23 */
         if(POL_H | POL_HV) /* MDSH/V not in spec yet */
@@ -402,6 +889,7 @@ int main(int argc, char** argv)
         H5Gclose(G_dataset_what);
         H5Gclose(G_dataset_where);
         H5Gclose(G_dataset_how);
+        timing_stop(T_ATTRS);
 
         nrays=in_setwhere.nrays;
         nbins=in_setwhere.nbins;
@@ -415,10 +903,7 @@ int main(int argc, char** argv)
            DataHow in_datahow;
            int binbytes,iW;
            short Encode=0;
-           ulong iN,oN;
-           ushort W;
-           unsigned char B;
-           double c_offset,c_gain,eps=1.0e-6,fB;
+           double c_offset=0.0,c_gain=1.0,eps=1.0e-6;
            double wanted_gain,wanted_offset,avail_gain,avail_offset;
            short avail_Q,wanted_Q,wanted_quants;
 
@@ -427,23 +912,21 @@ int main(int argc, char** argv)
            in_datawhat=meta->dataset[iS].data[iQ].what;
            in_datahow=meta->dataset[iS].data[iQ].how;
            binbytes=in_datawhat.bytes;
-           /* if(VERB) printf("%s %d\n",QCF[in_datawhat.QuantIdx].in_quantity,binbytes); */
-           insize=nrays*nbins*binbytes;
-           in_scandata=malloc(insize);
-           fres=fread(in_scandata,insize,1,METAF);
+           /* log_msg(LOG_INFO,"%s %d\n",QCF[in_datawhat.QuantIdx].in_quantity,binbytes); */
+           insize=(uint64_t)in_nrays*in_nbins*binbytes;
            /* compare in_datawhat.quantity and wanted quantities */
 
-           if(ALL_QUANTS) wanted_quants=1; else wanted_quants=MAX_QUANTS;
+           if(ALL_QUANTS) wanted_quants=1; else for(wanted_quants=0;wanted[wanted_quants];wanted_quants++);
            for(iW=0;iW<wanted_quants;iW++)
            {
 
              avail_Q=in_datawhat.QuantIdx;
-             /*     if(VERB) printf("Available %s\n",
+             /*     log_msg(LOG_INFO,"Available %s\n",
                      QCF[avail_Q].in_quantity);  */
-             if(ALL_QUANTS) wanted_Q=avail_Q; else wanted_Q=wanted_scanquants[tS][iW]; 
+             if(ALL_QUANTS) wanted_Q=avail_Q; else wanted_Q=wanted[iW]; 
              if(!wanted_Q) break;
              if(wanted_Q<0) { wanted_Q=avail_Q; iW=wanted_quants; }
-             /*if(VERB) printf("Q PAIR:  Available %s, wanted %d:%s\n",
+             /*log_msg(LOG_INFO,"Q PAIR:  Available %s, wanted %d:%s\n",
                 QCF[avail_Q].in_quantity,iW,QCF[wanted_Q].in_quantity); */
 
              if((wanted_Q==OQ_SQIH && avail_Q==OQ_SQIH2) ||
@@ -451,7 +934,7 @@ int main(int argc, char** argv)
                 (wanted_Q==OQ_CCOR && avail_Q==OQ_CCOR2) ||
                 (wanted_Q==OQ_RHOHV && avail_Q==OQ_RHOHV2))
                 { 
-                   if(VERB) printf("\nNOTICE: linear conversion to 8-bit %s not possible,\nusing forced 16-bit output\n",
+                   log_msg(LOG_INFO,"\nNOTICE: linear conversion to 8-bit %s not possible,\nusing forced 16-bit output\n",
                             QCF[wanted_Q].quantity);
                     wanted_Q+=TWOB;
                 }
@@ -476,7 +959,7 @@ int main(int argc, char** argv)
                 break;  
              }
            }
-           outsize=nbins*nrays*outbytes;
+           outsize=(uint64_t)nbins*nrays*outbytes;
 
            if(Encode)
            {
@@ -484,27 +967,32 @@ int main(int argc, char** argv)
                 wanted_gain=QCF[wanted_Q].gain;
                 avail_offset=QCF[avail_Q].offset;
                 wanted_offset=QCF[wanted_Q].offset;
-                /*    if(VERB) printf("%s: wG = %f, wF = %f\n",QCF[wanted_Q].in_quantity,wanted_gain,wanted_offset); */
-           } else { if(VERB) printf("SKIPPING %s\n---------------------\n",QCF[avail_Q].in_quantity); continue; }
+                /*    log_msg(LOG_INFO,"%s: wG = %f, wF = %f\n",QCF[wanted_Q].in_quantity,wanted_gain,wanted_offset); */
+           } else 
+           { 
+              log_msg(LOG_INFO,"SKIPPING %s\n---------------------\n",QCF[avail_Q].in_quantity); 
+              fseeko(METAF,(off_t)insize,SEEK_CUR);
+              deadline_left-=insize;
+              continue; 
+           }
 
 
            /* If conversion between 8/16 bit data is requested, the new gain and offset are calculated */
            if(Encode>1)
            { 
-                outdata=malloc(outsize); 
 
                 if(wanted_Q == OQ_VRADH2)
                 {
                   avail_gain *= in_sethow.NI;
                   avail_offset *= in_sethow.NI;
-                  /* if(VERB) printf("Nyq = %f, wG = %f, wF = %f\n",in_sethow.NEW_NyqVel,wanted_gain,wanted_offset);
+                  /* log_msg(LOG_INFO,"Nyq = %f, wG = %f, wF = %f\n",in_sethow.NEW_NyqVel,wanted_gain,wanted_offset);
                    */
                 }
                 if(wanted_Q == OQ_VRADH)
                 {
                   avail_gain /= in_sethow.NI;
                   avail_offset /= in_sethow.NI;
-                  /* if(VERB) printf("Nyq = %f, wG = %f, wF = %f\n",in_sethow.NEW_NyqVel,wanted_gain,wanted_offset);
+                  /* log_msg(LOG_INFO,"Nyq = %f, wG = %f, wF = %f\n",in_sethow.NEW_NyqVel,wanted_gain,wanted_offset);
                    */
                 }
 
@@ -533,13 +1021,12 @@ int main(int argc, char** argv)
                   wanted_offset *= in_sethow.NyqWidth;
                 }
 
-               if(VERB) printf("\nWRITING %d-bit %s, conversion from %s\n",Encode,QCF[wanted_Q].in_quantity,QCF[avail_Q].in_quantity); 
+               log_msg(LOG_INFO,"\nWRITING %d-bit %s, conversion from %s\n",Encode,QCF[wanted_Q].in_quantity,QCF[avail_Q].in_quantity); 
                /* printf("%f %f\n",c_gain,c_offset); */
            }
 
            if(Encode==1)
            { 
-              outdata=in_scandata;
               if(binbytes==1)
 	      {
 	         if(avail_Q==OQ_VRADH)
@@ -555,69 +1042,227 @@ int main(int argc, char** argv)
 	         }
 	      }
               /*  memcpy(&outdata[0],&in_scandata[0],outsize); */ 
-             if(VERB) printf("\nWRITING %s\n",QCF[wanted_Q].in_quantity);
+             log_msg(LOG_INFO,"\nWRITING %s\n",QCF[wanted_Q].in_quantity);
            } 
 
-           /* If conversion between 8/16 bit data is requested, new output quantity values are calculated */
-           if(Encode==8)
-           {
-             oN=0;
-             for(iN=0;iN<insize;iN+=binbytes)
-             {
-                memcpy(&W,in_scandata+iN,2);
-                while(1)
-                {                
-                  if(W == (ushort)QCF[avail_Q].nodata)   { B = (uchar)QCF[wanted_Q].nodata;   break; }
-                  if(W == (ushort)QCF[avail_Q].undetect) { B = (uchar)QCF[wanted_Q].undetect; break; }
-                  fB=c_gain*(double)W+c_offset;
-                  if(fB<0) { B=0; break; }
-                  if(fB>254) { B=254; break; }
-                  B=(uchar)fB;
-                  break;
-                }
-                outdata[oN]=B;
-                oN++;
-             }
-           }     
-
-           if(Encode==16)
-           {
-	     /*printf("%d %d\n",(ushort)QCF[wanted_Q].nodata,(ushort)QCF[wanted_Q].undetect);
-	       printf("%f %f\n",c_gain,c_offset); */
-             oN=0;
-             for(iN=0;iN<insize;iN+=binbytes)
-             {
-                B=in_scandata[iN];
-                while(1)
-                {                
-                  if(B == (uchar)QCF[avail_Q].undetect) { W = (ushort)QCF[wanted_Q].undetect; break; }
-                  if(B == (uchar)QCF[avail_Q].nodata)   { W = (ushort)QCF[wanted_Q].nodata;   break; }
-                  W=(ushort)(c_gain*(double)B+c_offset);
-                  break;
-                }
-                memcpy(outdata+oN,&W,2);
-                oN+=2;
-             }
-           }     
-
            if(Encode)
            { 
 	       hid_t G_data,D_data,G_datawhat,G_datahow; /* ,G_datawhere; */
 
                QuantCfg out_datawhat = QCF[wanted_Q];
-               double wanted_nodata,wanted_undetect;
+               double wanted_nodata,wanted_undetect,code_gain,code_offset;
+               long block,row0,rows,in_row0,in_rows;
+               uint32_t *avgwork=NULL;
+               int classes;
+               off_t data0=ftello(METAF);
+               StoragePolicy storage,physstorage;
+               float *physdata=NULL,*cartdata=NULL;
+               int cartq;
+               hid_t D_phys=-1;
+               hsize_t chunk[2];
+               ScanStats stats;
+               int uniform=0; /* data of undetect (1) or nodata (2) only, see ODIM_EMPTY_DATA */
+               float *veldata=NULL; /* velocities of a dual-PRF scan for ODIM_DEALIAS */
+               float vel_nodata;
+
+               /* The scan is read, converted and written in blocks of rays fitting the input and
+                  output buffers and the compression of a chunk in memory budget (see ODIM_io.h).
+                  A block is a chunk of the dataset, without a budget the whole scan. */
+               block=budget_rays(nrays,AVG_RAYS*(in_nbins*binbytes+crop_nbins*2*outbytes)+
+                                       nbins*(PHYSICAL ? 2*sizeof(float) : 0));
+               chunk[0]=(hsize_t)block;
+               chunk[1]=(hsize_t)nbins;
+               in_scandata=malloc(block*AVG_RAYS*in_nbins*binbytes);
+               cartq=(cartslot>=0) ? cart_quantity(&CART,out_datawhat.quantity) : -1;
+               if(cartq>=0) cartdata=cart_scan_buffer(&CART,cartslot,cartq);
+
+               /* Fast scan of the input for undetect or nodata only, ending at the first other
+                  value. Both are mapped to the same of the output by the conversions. A code
+                  shared by them (8-bit VRADH) is tested once, as undetect. */
+               if(EMPTY_DATA)
+               {
+                  timing_start(T_READ);
+                  uniform=(QCF[avail_Q].nodata==QCF[avail_Q].undetect) ? 1 : 3;
+                  for(in_row0=0;uniform && in_row0<crop_nrays;in_row0+=in_rows)
+                  {
+                     in_rows=(crop_nrays-in_row0 < UNIFORM_RAYS) ? crop_nrays-in_row0 : UNIFORM_RAYS;
+                     if(in_rows>block*AVG_RAYS) in_rows=block*AVG_RAYS;
+                     if(CROP) fres=read_rays(METAF,data0,in_nrays,in_nbins,binbytes,ray0,bin0,in_row0,in_rows,crop_nbins,in_scandata);
+                     else fres=fread(in_scandata,1,in_rows*crop_nbins*binbytes,METAF);
+                     if(binbytes==1)
+                     {
+                        if((uniform&1) && !uniform_8(in_scandata,in_rows*crop_nbins,(uchar)QCF[avail_Q].undetect)) uniform&=~1;
+                        if((uniform&2) && !uniform_8(in_scandata,in_rows*crop_nbins,(uchar)QCF[avail_Q].nodata)) uniform&=~2;
+                     } else
+                     {
+                        if((uniform&1) && !uniform_16(in_scandata,in_rows*crop_nbins,(ushort)QCF[avail_Q].undetect)) uniform&=~1;
+                        if((uniform&2) && !uniform_16(in_scandata,in_rows*crop_nbins,(ushort)QCF[avail_Q].nodata)) uniform&=~2;
+                     }
+                  }
+                  if(crop_nrays<1 || crop_nbins<1) uniform=0; /* no bins */
+                  timing_stop(T_READ);
+                  if(uniform && cartdata)
+                  {
+                     float v=(uniform==1) ? phys_undetect : phys_nodata;
+                     long i;
+
+                     for(i=0;i<nrays*nbins;i++) cartdata[i]=v;
+                  }
+                  fseeko(METAF,uniform ? data0+(off_t)insize : data0,SEEK_SET);
+               }
+               if(uniform && EMPTY_DATA==2)
+               {
+                  log_msg(LOG_INFO,"SKIPPING %s, %s only\n---------------------\n",QCF[wanted_Q].in_quantity,
+                          (uniform==1) ? "undetect" : "nodata");
+                  free(in_scandata);
+                  deadline_left-=insize;
+                  continue;
+               }
+
+               /* velocities of dual-PRF scans are kept for the correction */
+               if(DEALIAS.quantity && !uniform && !strcmp(out_datawhat.quantity,"VRADH") &&
+                  in_sethow.lowprf>0 && in_sethow.lowprf!=in_sethow.highprf)
+               {
+                  if(in_vraddh) log_msg(LOG_INFO,"VRADDH of the input written, no dual-PRF correction\n");
+                  else veldata=malloc((size_t)nrays*nbins*sizeof(float));
+               }
+               /* nodata is undetect if they have the same code (8-bit VRADH) */
+               vel_nodata=(out_datawhat.nodata==out_datawhat.undetect) ? INFINITY : NAN;
 
                eQ++;
                last_Q=wanted_Q;
-               sprintf(datagroup,"%s/data%d",setgroup,eQ);
-               if(VERB) printf("DATAGROUP %s\n",datagroup);
-               if(VERB) printf("___________________________________\n");
+               snprintf(datagroup,sizeof(datagroup),"%s/data%d",setgroup,eQ);
+               log_msg(LOG_INFO,"DATAGROUP %s\n",datagroup);
+               log_msg(LOG_INFO,"___________________________________\n");
 
                G_data=H5Gcreate2(H5out,datagroup,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT);
-               D_data=add_dataset_to_group(G_data,"data",compresslevel,outbytes,2,scandims,outdata);
+
+               if(Encode>1) outdata=malloc(block*AVG_RAYS*crop_nbins*outbytes); else outdata=in_scandata;
+               if(AVG_BINS>1 || AVG_RAYS>1) avgwork=malloc(3*nbins*sizeof(uint32_t));
+               /* classes are not averaged, the centre bin is taken */
+               classes=!strcmp(out_datawhat.quantity,"HCLASS");
+               if(PHYSICAL) physdata=malloc(block*nbins*sizeof(float));
+               if(ENCODE_DEADLINE>0)
+               {
+                  double t0=now_secs();
+                  int level=deadline_level(compresslevel,t0-deadline_start,last_bytes,last_secs);
+
+                  if(level!=compresslevel)
+                     log_msg(LOG_INFO,"Compression level %d -> %d, %.2f s of %.2f s used\n",compresslevel,level,
+                             t0-deadline_start,ENCODE_DEADLINE);
+                  compresslevel=level;
+                  last_secs=-t0;
+               }
+               storage=get_storage_policy(getenv("ODIM_STORAGE"),out_datawhat.quantity,out_datawhat.in_quantity,
+                                          compresslevel);
+               physstorage=storage;
+               D_data=-1;
+               memset(&stats,0,sizeof(stats));
+               if(uniform)
+               {
+                  /* stored as the fill value of the datasets, nothing is compressed */
+                  uchar code8=(uniform==1) ? out_datawhat.undetect : out_datawhat.nodata;
+                  ushort code16=(uniform==1) ? out_datawhat.undetect : out_datawhat.nodata;
+                  float v=(uniform==1) ? phys_undetect : phys_nodata;
+
+                  log_msg(LOG_INFO,"%s only\n",(uniform==1) ? "undetect" : "nodata");
+                  timing_start(T_DEFLATE);
+                  if(PHYSICAL!=2) D_data=create_uniform_dataset(G_data,"data",outbytes,2,scandims,chunk,
+                                                                (outbytes==1) ? (void *)&code8 : (void *)&code16);
+                  if(PHYSICAL) D_phys=create_uniform_dataset(G_data,(PHYSICAL==2) ? "data" : "physical",
+                                                             sizeof(float),2,scandims,chunk,&v);
+                  timing_stop(T_DEFLATE);
+                  if(uniform==1) stats.undetect=(uint64_t)nrays*nbins;
+                  else { stats.nodata=(uint64_t)nrays*nbins; stats.missing_rays=nrays; }
+               }
+               /* physical values of the scan are kept for the Cartesian product (cartdata) */
+               for(row0=0;row0<nrays && !uniform;row0+=rows)
+               {
+                  rows=(nrays-row0 < block) ? nrays-row0 : block;
+                  /* input rays of the output rays */
+                  in_row0=row0*AVG_RAYS;
+                  in_rows=(row0+rows)*AVG_RAYS;
+                  if(in_rows>crop_nrays) in_rows=crop_nrays;
+                  in_rows-=in_row0;
+                  timing_start(T_READ);
+                  if(CROP) fres=read_rays(METAF,data0,in_nrays,in_nbins,binbytes,ray0,bin0,in_row0,in_rows,crop_nbins,in_scandata);
+                  else fres=fread(in_scandata,1,in_rows*crop_nbins*binbytes,METAF);
+                  timing_stop(T_READ);
+                  timing_count(fres,0,0);
+
+                  /* If conversion between 8/16 bit data is requested, new output quantity values are calculated */
+                  timing_start(T_REQUANT);
+                  if(Encode==8)
+                    requant_16_to_8(in_scandata,in_rows*crop_nbins,(ushort)QCF[avail_Q].nodata,(ushort)QCF[avail_Q].undetect,
+                                    (uchar)QCF[wanted_Q].nodata,(uchar)QCF[wanted_Q].undetect,c_gain,c_offset,outdata);
+
+                  if(Encode==16)
+                    requant_8_to_16(in_scandata,in_rows*crop_nbins,(uchar)QCF[avail_Q].nodata,(uchar)QCF[avail_Q].undetect,
+                                    (ushort)QCF[wanted_Q].nodata,(ushort)QCF[wanted_Q].undetect,c_gain,c_offset,outdata);
+
+                  /* blocks of bins and rays averaged (ODIM_AVERAGE) */
+                  if(avgwork && classes) decimate_bins(outdata,in_rows,crop_nbins,AVG_BINS,AVG_RAYS,outbytes,outdata);
+                  else if(avgwork && outbytes==1)
+                    average_8(outdata,in_rows,crop_nbins,AVG_BINS,AVG_RAYS,(uchar)out_datawhat.nodata,
+                              (uchar)out_datawhat.undetect,outdata,avgwork);
+                  else if(avgwork)
+                    average_16(outdata,in_rows,crop_nbins,AVG_BINS,AVG_RAYS,(ushort)out_datawhat.nodata,
+                               (ushort)out_datawhat.undetect,outdata,avgwork);
+
+                  /* physical values of the output bins, by the gain and offset of the output */
+                  if(PHYSICAL && outbytes==1)
+                    phys_8_to_f32(outdata,rows*nbins,(uchar)out_datawhat.nodata,(uchar)out_datawhat.undetect,
+                                  (float)wanted_gain,(float)wanted_offset,phys_nodata,phys_undetect,physdata);
+                  if(PHYSICAL && outbytes==2)
+                    phys_16_to_f32(outdata,rows*nbins,(ushort)out_datawhat.nodata,(ushort)out_datawhat.undetect,
+                                   (float)wanted_gain,(float)wanted_offset,phys_nodata,phys_undetect,physdata);
+                  if(cartdata && outbytes==1)
+                    phys_8_to_f32(outdata,rows*nbins,(uchar)out_datawhat.nodata,(uchar)out_datawhat.undetect,
+                                  (float)wanted_gain,(float)wanted_offset,phys_nodata,phys_undetect,cartdata+row0*nbins);
+                  if(cartdata && outbytes==2)
+                    phys_16_to_f32(outdata,rows*nbins,(ushort)out_datawhat.nodata,(ushort)out_datawhat.undetect,
+                                   (float)wanted_gain,(float)wanted_offset,phys_nodata,phys_undetect,cartdata+row0*nbins);
+                  if(veldata && outbytes==1)
+                    phys_8_to_f32(outdata,rows*nbins,(uchar)out_datawhat.nodata,(uchar)out_datawhat.undetect,
+                                  (float)wanted_gain,(float)wanted_offset,vel_nodata,INFINITY,veldata+row0*nbins);
+                  if(veldata && outbytes==2)
+                    phys_16_to_f32(outdata,rows*nbins,(ushort)out_datawhat.nodata,(ushort)out_datawhat.undetect,
+                                   (float)wanted_gain,(float)wanted_offset,vel_nodata,INFINITY,veldata+row0*nbins);
+                  /* statistics of the output bins, while they are in cache */
+                  if(STATISTICS && outbytes==1)
+                    stats_8(outdata,rows,nbins,(uchar)out_datawhat.nodata,(uchar)out_datawhat.undetect,&stats);
+                  if(STATISTICS && outbytes==2)
+                    stats_16(outdata,rows,nbins,(ushort)out_datawhat.nodata,(ushort)out_datawhat.undetect,&stats);
+                  timing_stop(T_REQUANT);
+
+                  timing_start(T_DEFLATE);
+                  /* created with the first block, for the compression test of the policy */
+                  if(row0==0 && PHYSICAL!=2) D_data=create_dataset_by_policy(G_data,"data",&storage,outbytes,2,scandims,chunk,outdata);
+                  if(row0==0 && PHYSICAL)
+                     D_phys=create_dataset_by_policy(G_data,(PHYSICAL==2) ? "data" : "physical",&physstorage,
+                                                     sizeof(float),2,scandims,chunk,physdata);
+                  if(PHYSICAL!=2) write_dataset_rows(D_data,outbytes,row0,rows,nbins,outdata);
+                  if(PHYSICAL) write_dataset_rows(D_phys,sizeof(float),row0,rows,nbins,physdata);
+                  timing_stop(T_DEFLATE);
+               }
+               if(CROP && !uniform) fseeko(METAF,data0+(off_t)insize,SEEK_SET); /* to the next dataset */
+               timing_start(T_DEFLATE);
+               if(PHYSICAL!=2) H5Dclose(D_data); /* chunk is compressed and flushed here */
+               if(PHYSICAL) H5Dclose(D_phys);
+               timing_stop(T_DEFLATE);
+               free(physdata);
+               free(avgwork);
+               timing_count(0,outsize,nrays*nbins);
+               if(ENCODE_DEADLINE>0)
+               {
+                  last_secs+=now_secs();
+                  last_bytes=insize;
+               }
+               deadline_left-=insize;
+               timing_start(T_ATTRS);
 
                /* /datasetS/dataQ/data attributes */   
-               if(outbytes==1)
+               if(outbytes==1 && PHYSICAL!=2)
                {
 		  H5LTset_attribute_string(G_data,"data","CLASS","IMAGE");  
 		  H5LTset_attribute_string(G_data,"data","IMAGE_VERSION","1.2");  
@@ -628,6 +1273,22 @@ int main(int argc, char** argv)
  
                wanted_nodata=(double)out_datawhat.nodata;
                wanted_undetect=(double)out_datawhat.undetect;
+               code_gain=wanted_gain;
+               code_offset=wanted_offset;
+               if(PHYSICAL==1)
+               {
+                  double nd=phys_nodata,ud=phys_undetect;
+
+                  H5LTset_attribute_double(G_data,"physical","nodata",&nd,1);
+                  H5LTset_attribute_double(G_data,"physical","undetect",&ud,1);
+               }
+               if(PHYSICAL==2) /* data is physical values */
+               {
+                  wanted_gain=1.0;
+                  wanted_offset=0.0;
+                  wanted_nodata=phys_nodata;
+                  wanted_undetect=phys_undetect;
+               }
 
                add_attr_numeric_to_group(G_datawhat,"gain",&wanted_gain,H5T_NATIVE_DOUBLE);
                add_attr_numeric_to_group(G_datawhat,"nodata",&wanted_nodata,H5T_NATIVE_DOUBLE);
@@ -640,18 +1301,45 @@ int main(int argc, char** argv)
                if(in_datahow.LOG>0)  add_attr_numeric_to_group(G_datahow,"LOG",&in_datahow.LOG,H5T_NATIVE_DOUBLE);  
                if(in_datahow.SNRT>0)  add_attr_numeric_to_group(G_datahow,"SNRT",&in_datahow.SNRT,H5T_NATIVE_DOUBLE);  
                if(in_datahow.PMI>0)  add_attr_numeric_to_group(G_datahow,"PMI",&in_datahow.PMI,H5T_NATIVE_DOUBLE);  
+               if(ENCODE_DEADLINE>0)
+               {
+                  int64_t level=storage.contiguous ? 0 : storage.level;
+
+                  add_attr_numeric_to_group(G_datahow,"compression_level",&level,H5T_NATIVE_LLONG);
+               }
+               if(STATISTICS)
+               {
+                  write_stats(G_datahow,&stats,nrays,nbins,outbytes,code_gain,code_offset);
+                  if((int64_t)stats.missing_rays>sweep_missing) sweep_missing=(int64_t)stats.missing_rays;
+               }
 
 
-               H5Dclose(D_data);
                H5Gclose(G_datawhat);
                H5Gclose(G_datahow);
                H5Gclose(G_data);
+               timing_stop(T_ATTRS);
 
+               if(veldata)
+               {
+                  int64_t missing=write_dealiased(H5out,setgroup,&eQ,veldata,0.0025*in_how.wavelength*in_sethow.lowprf,
+                                                  0.0025*in_how.wavelength*in_sethow.highprf,scandims,chunk,
+                                                  compresslevel,cartslot,in_setwhere.startaz==in_setwhere.stopaz);
+
+                  if(missing>sweep_missing) sweep_missing=missing;
+                  free(veldata);
+               }
                if(Encode>1) free(outdata);
           }
           free(in_scandata);
         }
 
+        if(sweep_missing>=0)
+        {
+           char sethow[220];
+
+           sprintf(sethow,"%s/how",setgroup);
+           H5LTset_attribute_long_long(H5out,sethow,"missing_rays",(long long *)&sweep_missing,1);
+        }
         if(eQ>1) A1='Z';
           else
           {
@@ -676,11 +1364,13 @@ int main(int argc, char** argv)
           }
      }
      scans_total+=scans;
-     if(VERB) printf("%d scans total done\n",(int)scans_total);
+     fclose(METAF);
+     log_msg(LOG_INFO,"%d scans total done\n",(int)scans_total);
   }
 
   if(!vol_scan_number) goto fail;
 
+  timing_start(T_ATTRS);
   add_attr_numeric_to_group(G_root_how,"scan_count",&scans_total,H5T_NATIVE_LLONG); /* scans total V23 */
 
   if(vol_scan_number>1)
@@ -696,7 +1386,7 @@ int main(int argc, char** argv)
 
    
 
-  if(VERB)  printf("\n======================== HDF5 CREATED ==============================\n");
+  log_msg(LOG_INFO,"\n======================== HDF5 CREATED ==============================\n");
 
   /* construct the final Odyssey filename */
   if(outfile==NULL)
@@ -718,6 +1408,7 @@ int main(int argc, char** argv)
   H5Gclose(G_root_where);
   H5Gclose(G_root_how);
   H5Fclose(H5out);
+  timing_stop(T_ATTRS);
 
   /* rename the h5 file if ODIM name convention is used */
   if(outfile==NULL) 
@@ -726,485 +1417,30 @@ int main(int argc, char** argv)
 
      sprintf(finalname,"%s/%s",outdir,ODIM_namestr);
      rename(outname,finalname);
-     if(!QUIET) printf("%s\n",finalname);
+     sprintf(outname,"%s",finalname);
   } 
-  else if(!QUIET) printf("%s\n",outname);
+  if(!QUIET) log_msg(LOG_OUT,"%s\n",outname);
 
-  return(0);
- fail:
-  if(VERB) printf("\n!!!!!!!!!!!!!!!!!  NO SUITABLE DATA FOR ENCODING !!!!!!!!!!!!!!!!!\n\n");
-  return(1);
-}
-
-/*=============================================================================*/
-
-int  add_attr_numeric_to_group(hid_t group, char *attr, void *val, hid_t type)
-{
-   hid_t Attr,space;
-   int ret;
-
-   space  = H5Screate(H5S_SCALAR);
-   Attr = H5Acreate2(group, attr, type, space, H5P_DEFAULT, H5P_DEFAULT);
-   ret = H5Awrite(Attr, type, val);
-   H5Sclose(space);
-   H5Aclose(Attr);
-   return(ret);
-}
-
-
-hid_t add_dataset_to_group(hid_t group, char *name, int compress_level,int bytes, int rank, hsize_t *dims, void *data)
-{
-     hid_t dataspace,plist,dset,dtype=0;
-
-     if(bytes==1) dtype=H5Tcopy(H5T_NATIVE_UCHAR);
-     if(bytes==2) dtype=H5Tcopy(H5T_NATIVE_USHORT);
-
-     dataspace=H5Screate_simple(rank, dims, NULL);
-     plist = H5Pcreate(H5P_DATASET_CREATE);
-     H5Pset_chunk(plist, rank, dims);
-     H5Pset_deflate( plist, compress_level);
-     dset = H5Dcreate2(group, name, dtype, dataspace,
-            H5P_DEFAULT, plist, H5P_DEFAULT);
-     H5Dwrite(dset, dtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
-     H5Pclose(plist);
-     H5Sclose(dataspace);
-
-     return(dset);
+  /* Cartesian product of the scans kept */
+  if(CART.file)
+  {
+     timing_start(T_PROJECT);
+     if(cart_write(&CART,cartname,compresslevel)) { log_msg(LOG_ERR,"Cannot write %s\n",cartname); cachecart[0]=0; }
+     else log_msg(LOG_INFO,"Cartesian %s %s\n",cart_product_name[CART.product],cartname);
+     timing_stop(T_PROJECT);
   }
-
-short getQuantityCode(char *Qstr)
-{
-   short Qi;
-
-   for(Qi=0; Qi<OQ_QUANTS_TOTAL; Qi++)
-   {
-     if(strcmp(Qstr,QCF[Qi].in_quantity)==0) return(Qi);
-   }
-   return(0);
-}
-
-void SetQuantityParams()
-{
-
-  short i;
- 
-  for(i=0;i<OQ_QUANTS_TOTAL;i++)
+  if(cachefile[0])
   {
-    memset( &QCF[i],0,sizeof(QuantCfg));
-    QCF[i].in_quantity[0]=' ';
-  }    
-
-  sprintf(QCF[OQ_TH].in_quantity,"TH");
-  sprintf(QCF[OQ_TH].quantity,"TH");
-  QCF[OQ_TH].gain=0.5;
-  QCF[OQ_TH].offset=-32;
-  QCF[OQ_TH].nodata=255;
-  QCF[OQ_TH].undetect=0;
-
-  sprintf(QCF[OQ_TV].in_quantity,"TV");
-  sprintf(QCF[OQ_TV].quantity,"TV");
-  QCF[OQ_TV].gain=0.5;
-  QCF[OQ_TV].offset=-32;
-  QCF[OQ_TV].nodata=255;
-  QCF[OQ_TV].undetect=0;
-
-  sprintf(QCF[OQ_TX].in_quantity,"TX");
-  sprintf(QCF[OQ_TX].quantity,"TX");
-  QCF[OQ_TX].gain=0.5;
-  QCF[OQ_TX].offset=-32;
-  QCF[OQ_TX].nodata=255;
-  QCF[OQ_TX].undetect=0;
-
-  sprintf(QCF[OQ_DBZH].in_quantity,"DBZH");
-  sprintf(QCF[OQ_DBZH].quantity,"DBZH");
-  QCF[OQ_DBZH].gain=0.5;
-  QCF[OQ_DBZH].offset=-32.0;
-  QCF[OQ_DBZH].nodata=255;
-  QCF[OQ_DBZH].undetect=0;
-
-  sprintf(QCF[OQ_DBZV].in_quantity,"DBZV");
-  sprintf(QCF[OQ_DBZV].quantity,"DBZV");
-  QCF[OQ_DBZV].gain=0.5;
-  QCF[OQ_DBZV].offset=-32.0;
-  QCF[OQ_DBZV].nodata=255;
-  QCF[OQ_DBZV].undetect=0;
-
-  sprintf(QCF[OQ_DBZX].in_quantity,"DBZX");
-  sprintf(QCF[OQ_DBZX].quantity,"DBZX");
-  QCF[OQ_DBZX].gain=0.5;
-  QCF[OQ_DBZX].offset=-32.0;
-  QCF[OQ_DBZX].nodata=255;
-  QCF[OQ_DBZX].undetect=0;
-
-  sprintf(QCF[OQ_SNR].in_quantity,"SNR");
-  sprintf(QCF[OQ_SNR].quantity,"SNR");
-  QCF[OQ_SNR].gain=0.5;
-  QCF[OQ_SNR].offset=-32.0;
-  QCF[OQ_SNR].nodata=255;
-  QCF[OQ_SNR].undetect=0;
-
-  sprintf(QCF[OQ_LOG].in_quantity,"LOG");
-  sprintf(QCF[OQ_LOG].quantity,"LOG");
-  QCF[OQ_LOG].gain=0.5;
-  QCF[OQ_LOG].offset=-32.0;
-  QCF[OQ_LOG].nodata=255;
-  QCF[OQ_LOG].undetect=0;
-
-  sprintf(QCF[OQ_CSP].in_quantity,"CSP");
-  sprintf(QCF[OQ_CSP].quantity,"CSP");
-  QCF[OQ_CSP].gain=0.5;
-  QCF[OQ_CSP].offset=-32.0;
-  QCF[OQ_CSP].nodata=255;
-  QCF[OQ_CSP].undetect=0;
-
-  sprintf(QCF[OQ_ATTV].in_quantity,"ATTV");
-  sprintf(QCF[OQ_ATTV].quantity,"ATTV");
-  QCF[OQ_ATTV].gain=0.5;
-  QCF[OQ_ATTV].offset=-32.0;
-  QCF[OQ_ATTV].nodata=255;
-  QCF[OQ_ATTV].undetect=0;
-
-  sprintf(QCF[OQ_PIA].in_quantity,"PIA");
-  sprintf(QCF[OQ_PIA].quantity,"PIA");
-  QCF[OQ_PIA].gain=0.5;
-  QCF[OQ_PIA].offset=-32.0;
-  QCF[OQ_PIA].nodata=255;
-  QCF[OQ_PIA].undetect=0;
-
-  sprintf(QCF[OQ_ATTZDR].in_quantity,"ATTZDR");
-  sprintf(QCF[OQ_ATTZDR].quantity,"ATTZDR");
-  QCF[OQ_ATTZDR].gain=0.5;
-  QCF[OQ_ATTZDR].offset=-32.0;
-  QCF[OQ_ATTZDR].nodata=255;
-  QCF[OQ_ATTZDR].undetect=0;
-
-  sprintf(QCF[OQ_DBZHC].in_quantity,"DBZHC");
-  sprintf(QCF[OQ_DBZHC].quantity,"DBZHC");
-  QCF[OQ_DBZHC].gain=0.5;
-  QCF[OQ_DBZHC].offset=-32.0;
-  QCF[OQ_DBZHC].nodata=255;
-  QCF[OQ_DBZHC].undetect=0;
-
-  sprintf(QCF[OQ_VRADH].in_quantity,"VRADH");
-  sprintf(QCF[OQ_VRADH].quantity,"VRADH");
-  QCF[OQ_VRADH].gain=1.0/127.0;
-  QCF[OQ_VRADH].offset=-128.0/127.0;
-  QCF[OQ_VRADH].nodata=0;
-  QCF[OQ_VRADH].undetect=0;
-
-  sprintf(QCF[OQ_VRADH2].in_quantity,"VRADH2");
-  sprintf(QCF[OQ_VRADH2].quantity,"VRADH");
-  QCF[OQ_VRADH2].gain=0.01;
-  QCF[OQ_VRADH2].offset=-327.68;
-  QCF[OQ_VRADH2].nodata=65535;
-  QCF[OQ_VRADH2].undetect=0;
-
-  sprintf(QCF[OQ_VRADDH].in_quantity,"VRADDH");
-  sprintf(QCF[OQ_VRADDH].quantity,"VRADDH");
-  QCF[OQ_VRADDH].gain=75.0/127.0;
-  QCF[OQ_VRADDH].offset=-(150.0/127.0+74.4);
-  QCF[OQ_VRADDH].nodata=255;
-  QCF[OQ_VRADDH].undetect=0;
-
-  sprintf(QCF[OQ_VRADDH2].in_quantity,"VRADDH2");
-  sprintf(QCF[OQ_VRADDH2].quantity,"VRADDH");
-  QCF[OQ_VRADDH2].gain=0.01;
-  QCF[OQ_VRADDH2].offset=-327.68;
-  QCF[OQ_VRADDH2].nodata=65535;
-  QCF[OQ_VRADDH2].undetect=0;
-
-  sprintf(QCF[OQ_WRADH].in_quantity,"WRADH");
-  sprintf(QCF[OQ_WRADH].quantity,"WRADH");
-  QCF[OQ_WRADH].gain=1.0/256.0; 
-  QCF[OQ_WRADH].offset=0;
-  QCF[OQ_WRADH].nodata=255;
-  QCF[OQ_WRADH].undetect=0;
-
-  sprintf(QCF[OQ_WRADH2].in_quantity,"WRADH2");
-  sprintf(QCF[OQ_WRADH2].quantity,"WRADH");
-  QCF[OQ_WRADH2].gain=0.01;
-  QCF[OQ_WRADH2].offset=0;
-  QCF[OQ_WRADH2].nodata=65535;
-  QCF[OQ_WRADH2].undetect=0;
-
-  sprintf(QCF[OQ_ZDR].in_quantity,"ZDR");
-  sprintf(QCF[OQ_ZDR].quantity,"ZDR");
-  QCF[OQ_ZDR].gain=1.0/16.0;
-  QCF[OQ_ZDR].offset=128.0/16.0;
-  QCF[OQ_ZDR].nodata=255;
-  QCF[OQ_ZDR].undetect=0;
-
-  sprintf(QCF[OQ_ZDRC].in_quantity,"ZDRC");
-  sprintf(QCF[OQ_ZDRC].quantity,"ZDRC");
-  QCF[OQ_ZDRC].gain=1.0/16.0;
-  QCF[OQ_ZDRC].offset=128.0/16.0;
-  QCF[OQ_ZDRC].nodata=255;
-  QCF[OQ_ZDRC].undetect=0;
-
-  sprintf(QCF[OQ_TH2].in_quantity,"TH2");
-  sprintf(QCF[OQ_TH2].quantity,"TH");
-  QCF[OQ_TH2].gain=0.01;
-  QCF[OQ_TH2].offset=-327.68;
-  QCF[OQ_TH2].nodata=65535;
-  QCF[OQ_TH2].undetect=0;
-
-  sprintf(QCF[OQ_TV2].in_quantity,"TV2");
-  sprintf(QCF[OQ_TV2].quantity,"TV");
-  QCF[OQ_TV2].gain=0.01;
-  QCF[OQ_TV2].offset=-327.68;
-  QCF[OQ_TV2].nodata=65535;
-  QCF[OQ_TV2].undetect=0;
-
-  sprintf(QCF[OQ_TX2].in_quantity,"TX2");
-  sprintf(QCF[OQ_TX2].quantity,"TX");
-  QCF[OQ_TX2].gain=0.01;
-  QCF[OQ_TX2].offset=-327.68;
-  QCF[OQ_TX2].nodata=65535;
-  QCF[OQ_TX2].undetect=0;
-
-  sprintf(QCF[OQ_DBZH2].in_quantity,"DBZH2");
-  sprintf(QCF[OQ_DBZH2].quantity,"DBZH");
-  QCF[OQ_DBZH2].gain=0.01;
-  QCF[OQ_DBZH2].offset=-327.68;
-  QCF[OQ_DBZH2].nodata=65535;
-  QCF[OQ_DBZH2].undetect=0;
-
-  sprintf(QCF[OQ_DBZV2].in_quantity,"DBZV2");
-  sprintf(QCF[OQ_DBZV2].quantity,"DBZV");
-  QCF[OQ_DBZV2].gain=0.01;
-  QCF[OQ_DBZV2].offset=-327.68;
-  QCF[OQ_DBZV2].nodata=65535;
-  QCF[OQ_DBZV2].undetect=0;
-
-  sprintf(QCF[OQ_DBZX2].in_quantity,"DBZX2");
-  sprintf(QCF[OQ_DBZX2].quantity,"DBZX");
-  QCF[OQ_DBZX2].gain=0.01;
-  QCF[OQ_DBZX2].offset=-327.68;
-  QCF[OQ_DBZX2].nodata=65535;
-  QCF[OQ_DBZX2].undetect=0;
-
-  sprintf(QCF[OQ_SNR2].in_quantity,"SNR2");
-  sprintf(QCF[OQ_SNR2].quantity,"SNR");
-  QCF[OQ_SNR2].gain=0.01;
-  QCF[OQ_SNR2].offset=-327.68;
-  QCF[OQ_SNR2].nodata=65535;
-  QCF[OQ_SNR2].undetect=0;
-
-  sprintf(QCF[OQ_LOG2].in_quantity,"LOG2");
-  sprintf(QCF[OQ_LOG2].quantity,"LOG");
-  QCF[OQ_LOG2].gain=0.01;
-  QCF[OQ_LOG2].offset=-327.68;
-  QCF[OQ_LOG2].nodata=65535;
-  QCF[OQ_LOG2].undetect=0;
-
-  sprintf(QCF[OQ_CSP2].in_quantity,"CSP2");
-  sprintf(QCF[OQ_CSP2].quantity,"CSP");
-  QCF[OQ_CSP2].gain=0.01;
-  QCF[OQ_CSP2].offset=-327.68;
-  QCF[OQ_CSP2].nodata=65535;
-  QCF[OQ_CSP2].undetect=0;
-
-  sprintf(QCF[OQ_ATTV2].in_quantity,"ATTV2");
-  sprintf(QCF[OQ_ATTV2].quantity,"ATTV");
-  QCF[OQ_ATTV2].gain=0.01;
-  QCF[OQ_ATTV2].offset=-327.68;
-  QCF[OQ_ATTV2].nodata=65535;
-  QCF[OQ_ATTV2].undetect=0;
-
-  sprintf(QCF[OQ_PIA2].in_quantity,"PIA2");
-  sprintf(QCF[OQ_PIA2].quantity,"PIA");
-  QCF[OQ_PIA2].gain=0.01;
-  QCF[OQ_PIA2].offset=-327.68;
-  QCF[OQ_PIA2].nodata=65535;
-  QCF[OQ_PIA2].undetect=0;
-
-  sprintf(QCF[OQ_ATTZDR2].in_quantity,"ATTZDR2");
-  sprintf(QCF[OQ_ATTZDR2].quantity,"ATTZDR");
-  QCF[OQ_ATTZDR2].gain=0.01;
-  QCF[OQ_ATTZDR2].offset=-327.68;
-  QCF[OQ_ATTZDR2].nodata=65535;
-  QCF[OQ_ATTZDR2].undetect=0;
-
-  sprintf(QCF[OQ_DBZHC2].in_quantity,"DBZHC2");
-  sprintf(QCF[OQ_DBZHC2].quantity,"DBZHC");
-  QCF[OQ_DBZHC2].gain=0.01;
-  QCF[OQ_DBZHC2].offset=-327.68;
-  QCF[OQ_DBZHC2].nodata=65535;
-  QCF[OQ_DBZHC2].undetect=0;
-
-  sprintf(QCF[OQ_ZDR2].in_quantity,"ZDR2");
-  sprintf(QCF[OQ_ZDR2].quantity,"ZDR");
-  QCF[OQ_ZDR2].gain=0.01;
-  QCF[OQ_ZDR2].offset=-327.68;
-  QCF[OQ_ZDR2].nodata=65535;
-  QCF[OQ_ZDR2].undetect=0;
-
-  sprintf(QCF[OQ_ZDRC2].in_quantity,"ZDRC2");
-  sprintf(QCF[OQ_ZDRC2].quantity,"ZDRC");
-  QCF[OQ_ZDRC2].gain=0.01;
-  QCF[OQ_ZDRC2].offset=-327.68;
-  QCF[OQ_ZDRC2].nodata=65535;
-  QCF[OQ_ZDRC2].undetect=0;
-
-  sprintf(QCF[OQ_KDP2].in_quantity,"KDP2");
-  sprintf(QCF[OQ_KDP2].quantity,"KDP");
-  QCF[OQ_KDP2].gain=0.01;
-  QCF[OQ_KDP2].offset=-327.68;
-  QCF[OQ_KDP2].nodata=65535;
-  QCF[OQ_KDP2].undetect=0;
-
-  sprintf(QCF[OQ_PHIDP].in_quantity,"PHIDP");
-  sprintf(QCF[OQ_PHIDP].quantity,"PHIDP");
-  QCF[OQ_PHIDP].gain=180.0/254.0;
-  QCF[OQ_PHIDP].offset=-QCF[OQ_PHIDP].gain;
-  QCF[OQ_PHIDP].nodata=255;
-  QCF[OQ_PHIDP].undetect=0;
-
-  sprintf(QCF[OQ_SQIH2].in_quantity,"SQIH2");
-  sprintf(QCF[OQ_SQIH2].quantity,"SQIH");
-  QCF[OQ_SQIH2].gain=1.0/65533.0;
-  QCF[OQ_SQIH2].offset=-QCF[OQ_SQIH2].gain;
-  QCF[OQ_SQIH2].nodata=65535;
-  QCF[OQ_SQIH2].undetect=0;
-
-  sprintf(QCF[OQ_PMI2].in_quantity,"PMI2");
-  sprintf(QCF[OQ_PMI2].quantity,"PMI");
-  QCF[OQ_PMI2].gain=1.0/65533.0;
-  QCF[OQ_PMI2].offset=-QCF[OQ_PMI2].gain;
-  QCF[OQ_PMI2].nodata=65535;
-  QCF[OQ_PMI2].undetect=0;
-
-  sprintf(QCF[OQ_CCOR2].in_quantity,"CCOR2");
-  sprintf(QCF[OQ_CCOR2].quantity,"CCOR");
-  QCF[OQ_CCOR2].gain=1.0/65533.0;
-  QCF[OQ_CCOR2].offset=-QCF[OQ_CCOR2].gain;
-  QCF[OQ_CCOR2].nodata=65535;
-  QCF[OQ_CCOR2].undetect=0;
-
-  sprintf(QCF[OQ_RHOHV2].in_quantity,"RHOHV2");
-  sprintf(QCF[OQ_RHOHV2].quantity,"RHOHV");
-  QCF[OQ_RHOHV2].gain=1.0/65533.0;
-  QCF[OQ_RHOHV2].offset=-QCF[OQ_RHOHV2].gain;
-  QCF[OQ_RHOHV2].nodata=65535;
-  QCF[OQ_RHOHV2].undetect=0;
-
-  sprintf(QCF[OQ_RHOHV].in_quantity,"RHOHV");
-  sprintf(QCF[OQ_RHOHV].quantity,"RHOHV");
-  QCF[OQ_RHOHV].gain=1.0/65533.0;
-  QCF[OQ_RHOHV].offset=-QCF[OQ_RHOHV].gain;
-  QCF[OQ_RHOHV].nodata=65535;
-  QCF[OQ_RHOHV].undetect=0;
-
-  sprintf(QCF[OQ_PHIDP2].in_quantity,"PHIDP2");
-  sprintf(QCF[OQ_PHIDP2].quantity,"PHIDP");
-  QCF[OQ_PHIDP2].gain=360.0/65534.0;
-  QCF[OQ_PHIDP2].offset=-QCF[OQ_PHIDP2].gain;
-  QCF[OQ_PHIDP2].nodata=65535;
-  QCF[OQ_PHIDP2].undetect=0;
-
-  sprintf(QCF[OQ_LDR].in_quantity,"LDR");
-  sprintf(QCF[OQ_LDR].quantity,"LDR");
-  QCF[OQ_LDR].gain=0.2;
-  QCF[OQ_LDR].offset=-QCF[OQ_LDR].gain-45.0;
-  QCF[OQ_LDR].nodata=255;
-  QCF[OQ_LDR].undetect=0;
-
-  sprintf(QCF[OQ_LDR2].in_quantity,"LDR2");
-  sprintf(QCF[OQ_LDR2].quantity,"LDR");
-  QCF[OQ_LDR2].gain=0.01;
-  QCF[OQ_LDR2].offset=-327.68;
-  QCF[OQ_LDR2].nodata=65535;
-  QCF[OQ_LDR2].undetect=0;
-
-  sprintf(QCF[OQ_LDRV].in_quantity,"LDRV");
-  sprintf(QCF[OQ_LDRV].quantity,"LDRV");
-  QCF[OQ_LDRV].gain=0.2;
-  QCF[OQ_LDRV].offset=-QCF[OQ_LDRV].gain-45.0;
-  QCF[OQ_LDRV].nodata=255;
-  QCF[OQ_LDRV].undetect=0;
-
-  sprintf(QCF[OQ_LDRV2].in_quantity,"LDRV2");
-  sprintf(QCF[OQ_LDRV2].quantity,"LDRV");
-  QCF[OQ_LDRV2].gain=0.01;
-  QCF[OQ_LDRV2].offset=-327.68;
-  QCF[OQ_LDRV2].nodata=65535;
-  QCF[OQ_LDRV2].undetect=0;
-
-  sprintf(QCF[OQ_HCLASS].in_quantity,"HCLASS");
-  sprintf(QCF[OQ_HCLASS].quantity,"HCLASS");
-  QCF[OQ_HCLASS].gain=1.0;
-  QCF[OQ_HCLASS].offset=0.0;
-  QCF[OQ_HCLASS].nodata=255;
-  QCF[OQ_HCLASS].undetect=0;
-
-  sprintf(QCF[OQ_HCLASS2].in_quantity,"HCLASS2");
-  sprintf(QCF[OQ_HCLASS2].quantity,"HCLASS");
-  QCF[OQ_HCLASS2].gain=1.0;
-  QCF[OQ_HCLASS2].offset=0.0;
-  QCF[OQ_HCLASS2].nodata=65535;
-  QCF[OQ_HCLASS2].undetect=0;
-
+     if(outfile!=NULL) sprintf(ODIM_namestr,"T_PA%c%c%02d_C_%s_%s.h5",A1,A2,radnum,origcenter,timestamp);
+     cache_store_string(cachename,ODIM_namestr);
+     cache_store(outname,cachefile);
+     if(CART.file) cache_store(cartname,cachecart);
+  }
 
+  timing_report();
+  return(0);
+ fail:
+  log_msg(LOG_INFO,"\n!!!!!!!!!!!!!!!!!  NO SUITABLE DATA FOR ENCODING !!!!!!!!!!!!!!!!!\n\n");
+  timing_report();
+  return(1);
 }
-
-
-void get_wanted_quantities(char *Qstr)
-{
-         /* reading wanted quantities */
-          char *votoken, *swtoken, *qutoken, *vostr, *swstr, *qustr;
-          char *vo_saveptr, *sw_saveptr, *qu_saveptr; 
-          char volim[2]=" ",swlim[2]=":",qulim[2]="," ;
-          short Qcode,vo,sw,qu,swcount,swI,swlist[MAX_SCANS]={0};
-          /*      char qulist[MAX_SCANS][MAX_QUANTS][20]={{{0}}}; */
-
-          if(!Qstr || strcmp(Qstr,"ALL")==0 || strcmp(Qstr,"*")==0   || strcmp(Qstr,"*:*")==0) 
-          {
-            ALL_QUANTS=1;
-            for(sw=1;sw<MAX_SCANS;sw++) wanted_scanquants[sw][0]=-1;
-           if(VERB) printf("\nAll found quantities will be encoded\n\n");
-            return;
-          } else if(VERB) printf("\nSEARCHING: %s\n\n",Qstr);
-
-          for(vo=1,vostr=&Qstr[0];;vo++,vostr=NULL)
-          {
-               swcount=0;
-               votoken=strtok_r(vostr,volim,&vo_saveptr);
-               if(votoken == NULL) break;
-               for(sw=1,swstr=votoken;;sw++,swstr=NULL)
-               {
-                  swtoken=strtok_r(swstr,swlim,&sw_saveptr);
-                  if(swtoken == NULL) break;
-                  for(qu=1,qustr=swtoken;;qu++,qustr=NULL)
-                  {
-                    qutoken=strtok_r(qustr,qulim,&qu_saveptr);
-                    if(qutoken==NULL) break;
-                    if(sw==1) 
-                    { 
-                      if(qutoken[0]=='*')
-                      { 
-                         swcount=MAX_SCANS;
-                         for(swI=0;swI<swcount;swI++) swlist[swI]=swI;
-                      }
-                      else
-                      {
-                        swlist[swcount]=atoi(qutoken);
-                        swcount++;
-                      }
-                    } else for(swI=0;swI<swcount;swI++)
-                             { 
-                               if(qutoken[0]=='*') Qcode=-1; else
-                                  Qcode=getQuantityCode(qutoken);
-                               wanted_scanquants[swlist[swI]][qu-1]=Qcode;
-                             }
-                  }
-               }
-          }
-          /*
-          for(sw=1;sw<MAX_SCANS;sw++) for(qu=0;qu<MAX_QUANTS;qu++)
-          {
-            if(wanted_scanquants[sw][qu-1]) 
-             if(VERB) printf("SCAN %d %d %d %s\n",sw,qu,wanted_scanquants[sw][qu-1],QCF[wanted_scanquants[sw][qu-1]].in_quantity);
-          }
-          */
- }
-
@@ -0,0 +1,200 @@
+/*! \file ODIM_hdf5.h
+\brief HDF5 attribute and dataset writers of <I>ODIM_encoder.c</I>, shared with
+<I>ODIM_bench.c</I>.
+
+The storage of the datasets of each quantity is given by ODIM_STORAGE, a list of
+<I>QUANTITY</I>=<I>policy</I> separated by spaces or commas, * for the other quantities, e.g.
+'HCLASS=9 DBZH=shuffle/6 PHIDP=auto1.2 VRADH=contiguous'. A policy has words separated by '/':<BR>
+<B>contiguous</B> : no chunks, no compression <BR>
+<B>0</B>...<B>9</B> : chunks compressed at this level (default ODIM_COMPRESSION_LEVEL) <BR>
+<B>shuffle</B> : byte shuffle before deflate (16-bit and float data) <BR>
+<B>auto</B><I>X</I> : the first rays of the first chunk (at most AUTO_SAMPLE_BYTES) are compressed
+in memory, and the dataset is stored contiguous if the compression ratio is below <I>X</I> <BR>
+Level 0 is stored contiguous. A level given in a policy is used as is: it overrides
+ODIM_COMPRESSION_LEVEL and also the level lowered by ODIM_ENCODE_DEADLINE, which applies only
+to the quantities without one. Link with -lz (zlib) if h5cc does not.<BR>
+A dataset of one value only can be stored as its fill value (create_uniform_dataset()).
+*/
+
+#include <hdf5.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+/* Largest sample of the first chunk compressed by the auto test, whole rows, at least one */
+#define AUTO_SAMPLE_BYTES 65536
+
+/*!\struct StoragePolicy
+\brief Storage of a dataset */
+typedef struct {
+                  int contiguous; /*!< no chunks nor filters */
+                  int level;      /*!< deflate level */
+                  int shuffle;    /*!< shuffle filter before deflate */
+                  double min_ratio; /*!< stored contiguous if the first chunk compresses less, 0 if no test */
+               } StoragePolicy;
+
+/** \brief Gives the storage policy of quantity <I>quantity</I> (or <I>alias</I>, e.g. DBZH2) from
+<I>spec</I> (ODIM_STORAGE, may be NULL), <I>level</I> being the default compression level */
+StoragePolicy get_storage_policy(const char *spec, const char *quantity, const char *alias, int level)
+{
+   StoragePolicy pol={0,level,0,0.0};
+   const char *p=spec,*match=NULL;
+
+   /* the item of the quantity, else of its alias, else the * item */
+   while(p && *p)
+   {
+      size_t len=strcspn(p,"=, ");
+
+      if(p[len]=='=')
+      {
+         if((len==strlen(quantity) && !strncmp(p,quantity,len)) ||
+            (alias && len==strlen(alias) && !strncmp(p,alias,len) && (!match || *match=='*'))) match=p;
+         else if(len==1 && *p=='*' && !match) match=p;
+      }
+      p+=len;
+      p+=strcspn(p,", ");
+      p+=strspn(p,", ");
+   }
+   if(match)
+   {
+      const char *w=match+strcspn(match,"=")+1;
+
+      while(*w && *w!=',' && *w!=' ')
+      {
+         size_t len=strcspn(w,"/, ");
+
+         if(!strncmp(w,"contiguous",len) && len==10) pol.contiguous=1;
+         else if(!strncmp(w,"shuffle",len) && len==7) pol.shuffle=1;
+         else if(!strncmp(w,"auto",4)) pol.min_ratio=atof(w+4);
+         else if(*w>='0' && *w<='9') pol.level=atoi(w);
+         w+=len;
+         if(*w=='/') w++;
+      }
+   }
+   if(pol.level<0 || pol.level>9) pol.level=level;
+   if(pol.level==0) pol.contiguous=1;
+   return(pol);
+}
+
+/** \brief Compression ratio (bytes / deflated bytes) of <I>n</I> bytes at <I>data</I> at deflate
+<I>level</I>, the way HDF5 compresses a chunk. Shuffles 16-bit data first if <I>shuffle</I> */
+double deflate_ratio(const void *data, size_t n, int bytes, int level, int shuffle)
+{
+   uLongf outlen=compressBound(n);
+   unsigned char *out=malloc(outlen),*in=(unsigned char *)data,*sh=NULL;
+   double ratio=1.0;
+
+   if(shuffle && bytes>1)
+   {
+      size_t i,m=n/bytes;
+      int b;
+
+      sh=malloc(n);
+      for(b=0;b<bytes;b++) for(i=0;i<m;i++) sh[b*m+i]=in[i*bytes+b];
+      in=sh;
+   }
+   if(out && compress2(out,&outlen,in,n,level)==Z_OK && outlen) ratio=(double)n/(double)outlen;
+   free(out);
+   free(sh);
+   return(ratio);
+}
+
+/** \brief Adds any HDF5 scalar numeric attribute named <I>*attr</I> to group named <I>*group</I> and sets it to value <I>val</I>, with wanted type */
+int  add_attr_numeric_to_group(hid_t group, char *attr, void *val, hid_t type)
+{
+   hid_t Attr,space;
+   int ret;
+
+   space  = H5Screate(H5S_SCALAR);
+   Attr = H5Acreate2(group, attr, type, space, H5P_DEFAULT, H5P_DEFAULT);
+   ret = H5Awrite(Attr, type, val);
+   H5Sclose(space);
+   H5Aclose(Attr);
+   return(ret);
+}
+
+
+/** \brief Creates dataset to group stored by <I>*pol</I>, in chunks of <I>*chunk</I> if not contiguous.
+With a ratio test <I>first</I> is the data of the first chunk, and <I>pol</I> is set contiguous if its
+first rows (AUTO_SAMPLE_BYTES) do not compress enough. */
+hid_t create_dataset_by_policy(hid_t group, char *name, StoragePolicy *pol, int bytes, int rank, hsize_t *dims,
+                               hsize_t *chunk, const void *first)
+{
+     hid_t dataspace,plist,dset,dtype=0;
+     int i;
+     size_t n=bytes,rows;
+
+     if(!pol->contiguous && pol->min_ratio>0 && first)
+     {
+        /* a sample is enough for the ratio, the whole chunk would be deflated twice */
+        for(i=1;i<rank;i++) n*=chunk[i];
+        rows=AUTO_SAMPLE_BYTES/n;
+        if(rows<1) rows=1;
+        if(rows>chunk[0]) rows=chunk[0];
+        if(deflate_ratio(first,rows*n,bytes,pol->level,pol->shuffle) < pol->min_ratio) pol->contiguous=1;
+     }
+
+     if(bytes==1) dtype=H5Tcopy(H5T_NATIVE_UCHAR);
+     if(bytes==2) dtype=H5Tcopy(H5T_NATIVE_USHORT);
+     if(bytes==4) dtype=H5Tcopy(H5T_NATIVE_FLOAT);
+
+     dataspace=H5Screate_simple(rank, dims, NULL);
+     plist = H5Pcreate(H5P_DATASET_CREATE);
+     if(!pol->contiguous)
+     {
+        H5Pset_chunk(plist, rank, chunk);
+        if(pol->shuffle) H5Pset_shuffle(plist);
+        H5Pset_deflate(plist, pol->level);
+     }
+     dset = H5Dcreate2(group, name, dtype, dataspace,
+            H5P_DEFAULT, plist, H5P_DEFAULT);
+     H5Pclose(plist);
+     H5Sclose(dataspace);
+     H5Tclose(dtype);
+
+     return(dset);
+}
+
+/** \brief Creates dataset to group having all values <I>*value</I> (<I>bytes</I> bytes, 4 being float)
+as its fill value, in chunks of <I>*chunk</I>. No chunk is written, so the dataset takes no space
+in the file and is read as <I>*value</I>. */
+hid_t create_uniform_dataset(hid_t group, char *name, int bytes, int rank, hsize_t *dims, hsize_t *chunk,
+                             const void *value)
+{
+     hid_t dataspace,plist,dset,dtype=0;
+
+     if(bytes==1) dtype=H5Tcopy(H5T_NATIVE_UCHAR);
+     if(bytes==2) dtype=H5Tcopy(H5T_NATIVE_USHORT);
+     if(bytes==4) dtype=H5Tcopy(H5T_NATIVE_FLOAT);
+
+     dataspace=H5Screate_simple(rank, dims, NULL);
+     plist = H5Pcreate(H5P_DATASET_CREATE);
+     H5Pset_chunk(plist, rank, chunk);
+     H5Pset_fill_value(plist, dtype, value);
+     H5Pset_alloc_time(plist, H5D_ALLOC_TIME_INCR);
+     dset = H5Dcreate2(group, name, dtype, dataspace,
+            H5P_DEFAULT, plist, H5P_DEFAULT);
+     H5Pclose(plist);
+     H5Sclose(dataspace);
+     H5Tclose(dtype);
+
+     return(dset);
+}
+
+/** \brief Writes rows <I>row0</I> ... <I>row0+rows-1</I> of 2-D dataset having <I>cols</I> columns,
+4-byte data being float */
+herr_t write_dataset_rows(hid_t dset, int bytes, hsize_t row0, hsize_t rows, hsize_t cols, void *data)
+{
+     hid_t memspace,filespace;
+     hsize_t start[2]={row0,0},count[2]={rows,cols};
+     herr_t ret;
+
+     memspace=H5Screate_simple(2, count, NULL);
+     filespace=H5Dget_space(dset);
+     H5Sselect_hyperslab(filespace, H5S_SELECT_SET, start, NULL, count, NULL);
+     ret=H5Dwrite(dset, (bytes==1) ? H5T_NATIVE_UCHAR : (bytes==2) ? H5T_NATIVE_USHORT : H5T_NATIVE_FLOAT,
+                  memspace, filespace, H5P_DEFAULT, data);
+     H5Sclose(filespace);
+     H5Sclose(memspace);
+     return(ret);
+}
@@ -0,0 +1,367 @@
+/*! \file ODIM_io.h
+\brief Intermediate data/metadata file of <I>IRIS_decoder.c</I> and <I>ODIM_encoder.c</I>.
+
+The file starts with the metadata:<BR>
+ODIM_DAT_MAGIC, scans (int64_t), RootWhat, RootWhere, How<BR>
+and for each scan<BR>
+quantities (short), SetWhat, SetWhere, How, QuantitySet x quantities,
+startazA, stopazA, startelA, stopelA, startT, stopT (double x nrays each).<BR>
+The data follows scan by scan and quantity by quantity, nrays x nbins x bytes each.
+The structures are packed (see ODIM_struct.h) and numbers are little-endian as on the
+IRIS hosts, so 32- and 64-bit builds write the same file. Files are read and written with
+64-bit offsets.
+
+Files of older decoders, a dump of a fixed size MetaData of LEGACY_MAX_SCANS scans,
+LEGACY_MAX_QUANTS quantities and LEGACY_MAX_AZIMS rays, are read also.
+
+Both programs process a scan in blocks of rays so that the buffers of a block fit in the
+memory budget given in bytes (suffix k, M or G) by the environment variable
+ODIM_MEMORY_BUDGET, e.g. 64M. Without a budget a block is the whole scan.
+
+The encoder crops the scans to the range window ODIM_CROP_RANGE ("start end" in km) and to
+the azimuth sector ODIM_CROP_SECTOR ("start stop" in degrees clockwise) with crop_dataset()
+and read_rays(), before any conversion. ODIM_AVERAGE ("N M") then averages N bins and M rays
+(see average_dataset()).
+Include after ODIM_struct.h.
+*/
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/*!\def ODIM_DAT_MAGIC
+\brief First 8 bytes of an intermediate file
+*/
+# define ODIM_DAT_MAGIC "ODIMDAT2"
+
+/* Sizes of the fixed MetaData of the old intermediate files */
+# define LEGACY_MAX_SCANS 50
+# define LEGACY_MAX_QUANTS 128
+# define LEGACY_MAX_AZIMS 3600
+/* the per ray lists were in How, between ZDR_bias and malfunc */
+# define LEGACY_RAYLISTS (6*LEGACY_MAX_AZIMS*sizeof(double))
+
+/** \brief Gives ODIM_MEMORY_BUDGET in bytes, 0 if there is no budget. Read at each call, as
+output profiles set their own. */
+long long memory_budget(void)
+{
+   char *envp=getenv("ODIM_MEMORY_BUDGET"),*unit=NULL;
+   long long budget=0;
+
+   if(envp)
+   {
+      budget=strtoll(envp,&unit,10);
+      if(*unit=='k' || *unit=='K') budget<<=10;
+      if(*unit=='m' || *unit=='M') budget<<=20;
+      if(*unit=='g' || *unit=='G') budget<<=30;
+      if(budget<0) budget=0;
+   }
+   return(budget);
+}
+
+/** \brief Gives the rays of a block of a scan of <I>nrays</I> rays, when buffers of
+<I>raybytes</I> bytes per ray are needed. At least one ray. */
+long budget_rays(long nrays, long raybytes)
+{
+   long long budget=memory_budget();
+   long rays;
+
+   if(!budget || raybytes<=0 || (long long)nrays*raybytes <= budget) return(nrays);
+   rays=budget/raybytes;
+   return(rays<1 ? 1 : rays);
+}
+
+/** \brief Allocates the quantities and the per ray lists of a dataset. Returns 0 if out of memory. */
+int alloc_dataset(DataSet *set, int quantities, long nrays)
+{
+   double *lists;
+
+   set->quantities=quantities;
+   set->where.nrays=nrays;
+   set->data=calloc(quantities ? quantities : 1,sizeof(QuantitySet));
+   lists=calloc(nrays ? 6*nrays : 1,sizeof(double));
+   set->startazA=lists;
+   set->stopazA=lists+nrays;
+   set->startelA=lists+2*nrays;
+   set->stopelA=lists+3*nrays;
+   set->startT=lists+4*nrays;
+   set->stopT=lists+5*nrays;
+   return(set->data && lists);
+}
+
+/** \brief Frees the datasets of <I>*meta</I> and their contents */
+void free_metadata(MetaData *meta)
+{
+   int64_t iS;
+
+   if(meta->dataset)
+   {
+      for(iS=0;iS<meta->scans;iS++)
+      {
+         free(meta->dataset[iS].data);
+         free(meta->dataset[iS].startazA);
+      }
+   }
+   free(meta->dataset);
+   meta->dataset=NULL;
+   meta->scans=0;
+}
+
+/** \brief Writes the metadata part of the intermediate file. Returns bytes written, -1 if failed. */
+long write_metadata(FILE *F, MetaData *meta)
+{
+   long bytes=0;
+   int64_t iS;
+   int ok=1;
+
+   ok &= fwrite(ODIM_DAT_MAGIC,8,1,F);
+   ok &= fwrite(&meta->scans,sizeof(int64_t),1,F);
+   ok &= fwrite(&meta->what,sizeof(RootWhat),1,F);
+   ok &= fwrite(&meta->where,sizeof(RootWhere),1,F);
+   ok &= fwrite(&meta->how,sizeof(How),1,F);
+   bytes += 8+sizeof(int64_t)+sizeof(RootWhat)+sizeof(RootWhere)+sizeof(How);
+   for(iS=0;iS<meta->scans;iS++)
+   {
+      DataSet *set=&meta->dataset[iS];
+      long nrays=set->where.nrays;
+
+      ok &= fwrite(&set->quantities,sizeof(short),1,F);
+      ok &= fwrite(&set->what,sizeof(SetWhat),1,F);
+      ok &= fwrite(&set->where,sizeof(SetWhere),1,F);
+      ok &= fwrite(&set->how,sizeof(How),1,F);
+      if(set->quantities) ok &= fwrite(set->data,sizeof(QuantitySet),set->quantities,F)==(size_t)set->quantities;
+      if(nrays) ok &= fwrite(set->startazA,6*sizeof(double),nrays,F)==(size_t)nrays;
+      bytes += sizeof(short)+sizeof(SetWhat)+sizeof(SetWhere)+sizeof(How)+
+               set->quantities*sizeof(QuantitySet)+nrays*6*sizeof(double);
+   }
+   return(ok ? bytes : -1);
+}
+
+/** \brief Converts How of an old file at <I>*p</I>, and its per ray lists to <I>*set</I> if not NULL */
+void legacy_how(const unsigned char *p, How *how, DataSet *set)
+{
+   size_t head=offsetof(How,malfunc);
+
+   memcpy(how,p,head);
+   memcpy((unsigned char *)how+head,p+head+LEGACY_RAYLISTS,sizeof(How)-head);
+   if(set)
+   {
+      long nrays=set->where.nrays,k;
+
+      if(nrays>LEGACY_MAX_AZIMS) nrays=LEGACY_MAX_AZIMS;
+      for(k=0;k<6;k++) memcpy(set->startazA+k*set->where.nrays,p+head+k*LEGACY_MAX_AZIMS*sizeof(double),
+                              nrays*sizeof(double));
+   }
+}
+
+/** \brief Reads the metadata of an old intermediate file, <I>*magic</I> being its first 8 bytes */
+long read_legacy_metadata(FILE *F, MetaData *meta, const unsigned char *magic)
+{
+   /* leading members of the old MetaData and DataSet, How being the last one */
+#pragma pack(push,4)
+   typedef struct { int64_t scans; RootWhat what; RootWhere where; How how; } LegacyMetaHead;
+   typedef struct { short quantities; QuantitySet data[LEGACY_MAX_QUANTS]; SetWhat what; SetWhere where; How how; } LegacySetHead;
+#pragma pack(pop)
+   size_t setsize=offsetof(LegacySetHead,how)+sizeof(How)+LEGACY_RAYLISTS;
+   size_t setoffset=offsetof(LegacyMetaHead,how)+sizeof(How)+LEGACY_RAYLISTS;
+   size_t total=setoffset+LEGACY_MAX_SCANS*setsize;
+   unsigned char *buf=malloc(total);
+   LegacyMetaHead head;
+   int64_t iS;
+
+   if(!buf) return(-1);
+   memcpy(buf,magic,8);
+   if(fread(buf+8,total-8,1,F)!=1) { free(buf); return(-1); }
+   memcpy(&head,buf,offsetof(LegacyMetaHead,how));
+   if(head.scans<0 || head.scans>LEGACY_MAX_SCANS) { free(buf); return(-1); }
+
+   meta->scans=head.scans;
+   meta->what=head.what;
+   meta->where=head.where;
+   legacy_how(buf+offsetof(LegacyMetaHead,how),&meta->how,NULL);
+   meta->dataset=calloc(meta->scans ? meta->scans : 1,sizeof(DataSet));
+   for(iS=0;iS<meta->scans;iS++)
+   {
+      unsigned char *p=buf+setoffset+iS*setsize;
+      DataSet *set=&meta->dataset[iS];
+      short quantities;
+      SetWhere where;
+
+      memcpy(&quantities,p+offsetof(LegacySetHead,quantities),sizeof(short));
+      memcpy(&where,p+offsetof(LegacySetHead,where),sizeof(SetWhere));
+      if(quantities<0 || quantities>LEGACY_MAX_QUANTS) quantities=0;
+      if(where.nrays<0) where.nrays=0;
+      if(!alloc_dataset(set,quantities,where.nrays)) { free(buf); return(-1); }
+      memcpy(set->data,p+offsetof(LegacySetHead,data),quantities*sizeof(QuantitySet));
+      memcpy(&set->what,p+offsetof(LegacySetHead,what),sizeof(SetWhat));
+      set->where=where;
+      legacy_how(p+offsetof(LegacySetHead,how),&set->how,set);
+   }
+   free(buf);
+   return((long)total);
+}
+
+/** \brief Reads the metadata part of the intermediate file to <I>*meta</I>, allocating the
+datasets. Returns bytes read, -1 if the file is not an intermediate file or is truncated. */
+long read_metadata(FILE *F, MetaData *meta)
+{
+   unsigned char magic[8];
+   long bytes;
+   int64_t iS;
+
+   memset(meta,0,sizeof(MetaData));
+   if(fread(magic,8,1,F)!=1) return(-1);
+   if(memcmp(magic,ODIM_DAT_MAGIC,8)) return(read_legacy_metadata(F,meta,magic));
+
+   if(fread(&meta->scans,sizeof(int64_t),1,F)!=1 ||
+      fread(&meta->what,sizeof(RootWhat),1,F)!=1 ||
+      fread(&meta->where,sizeof(RootWhere),1,F)!=1 ||
+      fread(&meta->how,sizeof(How),1,F)!=1) return(-1);
+   bytes = 8+sizeof(int64_t)+sizeof(RootWhat)+sizeof(RootWhere)+sizeof(How);
+   if(meta->scans<0 || meta->scans>INT16_MAX) { meta->scans=0; return(-1); }
+
+   meta->dataset=calloc(meta->scans ? meta->scans : 1,sizeof(DataSet));
+   if(!meta->dataset) { meta->scans=0; return(-1); }
+   for(iS=0;iS<meta->scans;iS++)
+   {
+      DataSet *set=&meta->dataset[iS];
+      short quantities;
+      SetWhat what;
+      SetWhere where;
+      How how;
+      long nrays;
+
+      if(fread(&quantities,sizeof(short),1,F)!=1 ||
+         fread(&what,sizeof(SetWhat),1,F)!=1 ||
+         fread(&where,sizeof(SetWhere),1,F)!=1 ||
+         fread(&how,sizeof(How),1,F)!=1 ||
+         quantities<0 || where.nrays<0 || where.nrays>INT32_MAX) { meta->scans=iS; return(-1); }
+      nrays=where.nrays;
+      if(!alloc_dataset(set,quantities,nrays)) { meta->scans=iS+1; return(-1); }
+      set->what=what;
+      set->where=where;
+      set->how=how;
+      if((quantities && fread(set->data,sizeof(QuantitySet),quantities,F)!=(size_t)quantities) ||
+         (nrays && fread(set->startazA,6*sizeof(double),nrays,F)!=(size_t)nrays)) { meta->scans=iS+1; return(-1); }
+      bytes += sizeof(short)+sizeof(SetWhat)+sizeof(SetWhere)+sizeof(How)+
+               quantities*sizeof(QuantitySet)+nrays*6*sizeof(double);
+   }
+   return(bytes);
+}
+
+/** \brief Crops dataset <I>*set</I> to the bins within range <I>r0</I>...<I>r1</I> [km] and to the
+rays centred in sector <I>az0</I>...<I>az1</I> [deg] clockwise (az0==az1 for all rays), adjusting
+where (nbins, rstart, nrays, a1gate, startaz, stopaz) and the per ray lists.
+A sector starting inside the rays rotates them, the first ray being its first one.
+Gives in <I>*ray0</I> and <I>*bin0</I> the first input ray and bin. Returns 0 if nothing is left. */
+int crop_dataset(DataSet *set, double r0, double r1, double az0, double az1, long *ray0, long *bin0)
+{
+   SetWhere *w=&set->where;
+   long n=w->nrays,bin1=w->nbins,rays=n,k,j;
+   double width=fmod(az1-az0+720.0,360.0);
+
+   *ray0=0;
+   *bin0=0;
+   if(r1>r0 && w->rscale>0.0)
+   {
+      double b0=ceil((r0-w->rstart)*1000.0/w->rscale-1.0e-6),b1=floor((r1-w->rstart)*1000.0/w->rscale+1.0e-6);
+
+      if(b0>0.0) *bin0=(long)b0;
+      if(b1<(double)bin1) bin1=(b1>0.0) ? (long)b1 : 0;
+      if(bin1<*bin0) bin1=*bin0;
+      w->rstart+=*bin0*w->rscale/1000.0;
+      w->nbins=bin1-*bin0;
+   }
+   if(width>0.0 && n>0)
+   {
+      char *in=malloc(n);
+      double *lists=malloc(6*n*sizeof(double)),*dst[6];
+
+      /* rays centred in the sector, the first one after a ray outside */
+      for(k=0;k<n;k++)
+      {
+         double a=set->startazA[k],b=set->stopazA[k];
+
+         if(b<a) b+=360.0;
+         in[k]=(fmod(0.5*(a+b)-az0+720.0,360.0)<=width);
+      }
+      for(k=0;k<n && !(in[k] && !in[(k+n-1)%n]);k++);
+      if(k<n)
+      {
+         *ray0=k;
+         for(rays=0;rays<n && in[(k+rays)%n];rays++);
+      }
+      else if(!in[0]) rays=0;
+      free(in);
+
+      dst[0]=set->startazA; dst[1]=set->stopazA; dst[2]=set->startelA;
+      dst[3]=set->stopelA; dst[4]=set->startT; dst[5]=set->stopT;
+      for(j=0;j<6;j++) memcpy(lists+j*n,dst[j],n*sizeof(double));
+      for(j=0;j<6;j++) for(k=0;k<rays;k++) dst[j][k]=lists[j*n+(*ray0+k)%n];
+      free(lists);
+      w->nrays=rays;
+      w->a1gate=(w->a1gate-*ray0+n)%n;
+      if(w->a1gate>=rays) w->a1gate=0;
+      if(rays>0 && rays<n)
+      {
+         w->startaz=set->startazA[0];
+         w->stopaz=set->stopazA[rays-1];
+      }
+   }
+   return(w->nrays>0 && w->nbins>0);
+}
+
+/** \brief Reads rays <I>row0</I>...<I>row0+rows-1</I> of a dataset cropped by crop_dataset() to
+<I>buf</I> (<I>rows</I> x <I>in_nbins</I> x <I>bytes</I>), leaving the <I>nbins</I> bins from
+<I>bin0</I> of each. The data of the input dataset of <I>in_nrays</I> x <I>in_nbins</I> bins
+starts at offset <I>data0</I>. Returns bytes read. */
+size_t read_rays(FILE *F, off_t data0, long in_nrays, long in_nbins, int bytes, long ray0, long bin0,
+                 long row0, long rows, long nbins, unsigned char *buf)
+{
+   size_t got=0,raybytes=(size_t)in_nbins*bytes;
+   long r=0,ray,piece;
+
+   while(r<rows)
+   {
+      ray=(ray0+row0+r)%in_nrays;
+      piece=in_nrays-ray;
+      if(piece>rows-r) piece=rows-r;
+      if(fseeko(F,data0+(off_t)ray*raybytes,SEEK_SET)) break;
+      got+=fread(buf+r*raybytes,1,piece*raybytes,F);
+      r+=piece;
+   }
+   if(nbins!=in_nbins)
+      for(r=0;r<rows;r++) memmove(buf+r*nbins*bytes,buf+r*raybytes+bin0*bytes,nbins*bytes);
+   return(got);
+}
+
+/** \brief Sets dataset <I>*set</I> to blocks of <I>N</I> bins and <I>M</I> rays averaged by the
+encoder (average_8()): rscale, nbins, nrays, a1gate, binmethod and the per ray lists, a ray
+starting at the start of its first ray and stopping at the stop of its last one. */
+void average_dataset(DataSet *set, int N, int M)
+{
+   SetWhere *w=&set->where;
+   long n=w->nrays,j,last;
+
+   w->rscale*=N;
+   w->nbins=(w->nbins+N-1)/N;
+   set->how.binmethod_avg*=N;
+   if(N>1) sprintf(set->how.binmethod,"AVERAGE");
+   if(M<=1) return;
+   w->nrays=(n+M-1)/M;
+   w->a1gate/=M;
+   for(j=0;j<w->nrays;j++)
+   {
+      last=(j*M+M-1<n) ? j*M+M-1 : n-1;
+      set->startazA[j]=set->startazA[j*M];
+      set->stopazA[j]=set->stopazA[last];
+      set->startelA[j]=set->startelA[j*M];
+      set->stopelA[j]=set->stopelA[last];
+      set->startT[j]=set->startT[j*M];
+      set->stopT[j]=set->stopT[last];
+   }
+}
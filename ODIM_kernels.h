@@ -0,0 +1,377 @@
+/*! \file ODIM_kernels.h
+\brief Bin conversion loops of <I>IRIS_decoder.c</I> and <I>ODIM_encoder.c</I>, kept apart
+so that <I>IRIS_bench.c</I> and <I>ODIM_bench.c</I> measure the same code the programs run.
+
+Output bins are written with memcpy, so the output buffers need no alignment.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/** \brief Decoder: 8-bit RHOHV type (RHOHV, SQI, CCOR8, PMI8, sqrt((N-1)/253)) of <I>n</I> bins
+to 16-bit linear (N-1)/65533. 0 (nodata) and 255 (undetect) are kept as 0 and 65535. */
+static inline void rhohv_8_to_16(const uint8_t *in, long n, uint8_t *out)
+{
+  long bI;
+  uint16_t newBinVal;
+  const uint8_t *pBinVal = in;
+
+  for(bI=0 ; bI < n; bI++,pBinVal++)
+  {
+    while(1)
+    {
+      if(*pBinVal==255) { newBinVal=65535; break; }
+      if(*pBinVal==0) { newBinVal=0; break; }
+      newBinVal=(uint16_t)(1.0000001+65533.0*sqrt(((double)*pBinVal-1.0)/253.0));
+      break;
+    }
+    memcpy(&out[bI*2],&newBinVal,2);
+  }
+}
+
+/** \brief Decoder: 8-bit KDP of <I>n</I> bins to 16-bit. NOT IMPLEMENTED: the logarithmic
+8-bit scale is not converted, the input is ignored and all bins are set to 1 (placeholder of
+the original decoder). Not benchmarked. */
+static inline void kdp_8_to_16(const uint8_t *in, long n, uint8_t *out)
+{
+  long bI;
+  uint16_t newBinVal;
+
+  (void)in; /* unused until the relation is added */
+  newBinVal=1;
+  for(bI=0 ; bI < n; bI++)
+  {
+    memcpy(&out[bI*2],&newBinVal,2); /* ADD CORRECT RELATION HERE */
+  }
+}
+
+/** \brief Encoder: requantizes <I>n</I> 16-bit bins to 8-bit, B = c_gain*W + c_offset
+limited to 0...254. Nodata and undetect values are mapped to the ones of the output. */
+static inline void requant_16_to_8(const uint8_t *in, unsigned long n, uint16_t in_nodata, uint16_t in_undetect,
+                                   uint8_t out_nodata, uint8_t out_undetect, double c_gain, double c_offset,
+                                   uint8_t *out)
+{
+  unsigned long iN;
+  uint16_t W;
+  uint8_t B;
+  double fB;
+
+  for(iN=0;iN<n;iN++)
+  {
+     memcpy(&W,in+2*iN,2);
+     while(1)
+     {
+       if(W == in_nodata)   { B = out_nodata;   break; }
+       if(W == in_undetect) { B = out_undetect; break; }
+       fB=c_gain*(double)W+c_offset;
+       if(fB<0) { B=0; break; }
+       if(fB>254) { B=254; break; }
+       B=(uint8_t)fB;
+       break;
+     }
+     out[iN]=B;
+  }
+}
+
+/** \brief Encoder: requantizes <I>n</I> 8-bit bins to 16-bit, W = c_gain*B + c_offset.
+Undetect and nodata values are mapped to the ones of the output. */
+static inline void requant_8_to_16(const uint8_t *in, unsigned long n, uint8_t in_nodata, uint8_t in_undetect,
+                                   uint16_t out_nodata, uint16_t out_undetect, double c_gain, double c_offset,
+                                   uint8_t *out)
+{
+  unsigned long iN;
+  uint16_t W;
+  uint8_t B;
+
+  for(iN=0;iN<n;iN++)
+  {
+     B=in[iN];
+     while(1)
+     {
+       if(B == in_undetect) { W = out_undetect; break; }
+       if(B == in_nodata)   { W = out_nodata;   break; }
+       W=(uint16_t)(c_gain*(double)B+c_offset);
+       break;
+     }
+     memcpy(out+2*iN,&W,2);
+  }
+}
+
+/** \brief Encoder: physical values gain*B + offset of <I>n</I> 8-bit bins as float. Nodata and
+undetect bins are set to <I>f_nodata</I> and <I>f_undetect</I> (e.g. NaN). The loop has no
+branches, so the compiler vectorizes it. */
+static inline void phys_8_to_f32(const uint8_t *in, unsigned long n, uint8_t nodata, uint8_t undetect,
+                                 float gain, float offset, float f_nodata, float f_undetect, float *out)
+{
+  unsigned long iN;
+
+  for(iN=0;iN<n;iN++)
+  {
+     uint8_t B=in[iN];
+     float v=gain*(float)B+offset;
+
+     v=(B == undetect) ? f_undetect : v;
+     out[iN]=(B == nodata) ? f_nodata : v;
+  }
+}
+
+/** \brief Encoder: physical values gain*W + offset of <I>n</I> 16-bit bins as float, as
+phys_8_to_f32() */
+static inline void phys_16_to_f32(const uint8_t *in, unsigned long n, uint16_t nodata, uint16_t undetect,
+                                  float gain, float offset, float f_nodata, float f_undetect, float *out)
+{
+  unsigned long iN;
+
+  for(iN=0;iN<n;iN++)
+  {
+     uint16_t W;
+     float v;
+
+     memcpy(&W,in+2*iN,2);
+     v=gain*(float)W+offset;
+     v=(W == undetect) ? f_undetect : v;
+     out[iN]=(W == nodata) ? f_nodata : v;
+  }
+}
+
+/** \brief Encoder: averages blocks of <I>M</I> rays x <I>N</I> bins of <I>rows</I> x <I>nbins</I>
+8-bit bins to ceil(rows/M) x ceil(nbins/N) bins (ODIM_AVERAGE). The mean of the bins that are
+not nodata nor undetect is rounded to a bin value; as the scale is linear, it is the mean of
+the physical values. A block without such bins is undetect if it has an undetect bin,
+otherwise nodata. <I>out</I> may be <I>in</I>. <I>work</I> has 3*ceil(nbins/N) elements.
+The inner loop has no branches, so the compiler vectorizes it. */
+static inline void average_8(const uint8_t *in, long rows, long nbins, int N, int M, uint8_t nodata,
+                             uint8_t undetect, uint8_t *out, uint32_t *work)
+{
+  long onb=(nbins+N-1)/N,orows=(rows+M-1)/M,j,i,m,n,nI;
+  uint32_t *sum=work,*cnt=work+onb,*und=work+2*onb;
+
+  for(j=0;j<orows;j++)
+  {
+     memset(work,0,3*onb*sizeof(uint32_t));
+     for(m=0;m<M && j*M+m<rows;m++) for(n=0;n<N;n++)
+     {
+        const uint8_t *ray=in+(j*M+m)*nbins+n;
+
+        nI=(nbins-n+N-1)/N; /* blocks having bin n */
+        for(i=0;i<nI;i++)
+        {
+           uint32_t B=ray[i*N],valid=(B != nodata) & (B != undetect);
+
+           sum[i]+=valid*B;
+           cnt[i]+=valid;
+           und[i]+=(B == undetect);
+        }
+     }
+     for(i=0;i<onb;i++)
+     {
+        uint32_t c=cnt[i] ? cnt[i] : 1;
+
+        out[j*onb+i]=cnt[i] ? (uint8_t)((sum[i]+c/2)/c) : (und[i] ? undetect : nodata);
+     }
+  }
+}
+
+/** \brief Encoder: averages 16-bit bins as average_8() */
+static inline void average_16(const uint8_t *in, long rows, long nbins, int N, int M, uint16_t nodata,
+                              uint16_t undetect, uint8_t *out, uint32_t *work)
+{
+  long onb=(nbins+N-1)/N,orows=(rows+M-1)/M,j,i,m,n,nI;
+  uint32_t *sum=work,*cnt=work+onb,*und=work+2*onb;
+  uint16_t W;
+
+  for(j=0;j<orows;j++)
+  {
+     memset(work,0,3*onb*sizeof(uint32_t));
+     for(m=0;m<M && j*M+m<rows;m++) for(n=0;n<N;n++)
+     {
+        const uint8_t *ray=in+2*((j*M+m)*nbins+n);
+
+        nI=(nbins-n+N-1)/N;
+        for(i=0;i<nI;i++)
+        {
+           uint32_t valid;
+
+           memcpy(&W,ray+2*i*N,2);
+           valid=(W != nodata) & (W != undetect);
+           sum[i]+=valid*W;
+           cnt[i]+=valid;
+           und[i]+=(W == undetect);
+        }
+     }
+     for(i=0;i<onb;i++)
+     {
+        uint32_t c=cnt[i] ? cnt[i] : 1;
+
+        W=cnt[i] ? (uint16_t)((sum[i]+c/2)/c) : (und[i] ? undetect : nodata);
+        memcpy(out+2*(j*onb+i),&W,2);
+     }
+  }
+}
+
+/** \brief Encoder: takes the centre bin of blocks of <I>M</I> rays x <I>N</I> bins of
+<I>bytes</I> byte bins, for quantities that cannot be averaged (classes). <I>out</I> may be <I>in</I>. */
+static inline void decimate_bins(const uint8_t *in, long rows, long nbins, int N, int M, int bytes, uint8_t *out)
+{
+  long onb=(nbins+N-1)/N,orows=(rows+M-1)/M,j,i,r,b;
+
+  for(j=0;j<orows;j++)
+  {
+     r=j*M+M/2;
+     if(r>=rows) r=rows-1;
+     for(i=0;i<onb;i++)
+     {
+        b=i*N+N/2;
+        if(b>=nbins) b=nbins-1;
+        memmove(out+bytes*(j*onb+i),in+bytes*(r*nbins+b),bytes);
+     }
+  }
+}
+
+/** \brief Encoder: tests if all <I>n</I> 8-bit bins are <I>value</I> (ODIM_EMPTY_DATA). The bins are
+compared in blocks of 4096 without branches, so the compiler vectorizes it, and the test
+ends at the first block having another value. */
+static inline int uniform_8(const uint8_t *in, unsigned long n, uint8_t value)
+{
+  unsigned long i,j,end;
+  uint8_t diff=0;
+
+  for(i=0;i<n;i=end)
+  {
+     end=(n-i > 4096) ? i+4096 : n;
+     for(j=i;j<end;j++) diff|=in[j]^value;
+     if(diff) return(0);
+  }
+  return(1);
+}
+
+/** \brief Encoder: tests if all <I>n</I> 16-bit bins are <I>value</I> as uniform_8() */
+static inline int uniform_16(const uint8_t *in, unsigned long n, uint16_t value)
+{
+  unsigned long i,j,end;
+  uint16_t W,diff=0;
+
+  for(i=0;i<n;i=end)
+  {
+     end=(n-i > 4096) ? i+4096 : n;
+     for(j=i;j<end;j++)
+     {
+        memcpy(&W,in+2*j,2);
+        diff|=W^value;
+     }
+     if(diff) return(0);
+  }
+  return(1);
+}
+
+/*!\struct ScanStats
+\brief Statistics of the bins of a scan (ODIM_STATISTICS): counts of the 256 classes of the
+values, without nodata and undetect bins, and the counts of these and of rays of nodata only.
+If nodata and undetect are the same code (e.g. 8-bit VRADH) it is counted as undetect, and no
+ray is missing. */
+typedef struct {
+                  uint64_t hist[256]; /*!< 8-bit values, or 16-bit values >> 8 */
+                  uint64_t nodata;
+                  uint64_t undetect;
+                  uint64_t missing_rays; /*!< rays having only nodata bins */
+               } ScanStats;
+
+/** \brief Encoder: adds <I>rows</I> x <I>nbins</I> 8-bit bins to <I>*st</I>. The counts go to
+four histograms in turn, so that the increments of consecutive bins of the same value do not
+wait for each other, and the histograms are summed at the end. */
+static inline void stats_8(const uint8_t *in, long rows, long nbins, uint8_t nodata, uint8_t undetect, ScanStats *st)
+{
+  uint32_t h[4][256];
+  uint32_t nd=0,prev;
+  long r,i;
+  int c;
+
+  memset(h,0,sizeof(h));
+  for(r=0;r<rows;r++)
+  {
+     const uint8_t *ray=in+r*nbins;
+
+     prev=nd;
+     for(i=0;i+4<=nbins;i+=4)
+     {
+        h[0][ray[i]]++;
+        h[1][ray[i+1]]++;
+        h[2][ray[i+2]]++;
+        h[3][ray[i+3]]++;
+     }
+     for(;i<nbins;i++) h[0][ray[i]]++;
+     nd=h[0][nodata]+h[1][nodata]+h[2][nodata]+h[3][nodata];
+     st->missing_rays+=(nd-prev == (uint32_t)nbins && nodata != undetect);
+  }
+  for(c=0;c<256;c++) h[0][c]+=h[1][c]+h[2][c]+h[3][c];
+  if(nodata != undetect) st->nodata+=h[0][nodata];
+  st->undetect+=h[0][undetect];
+  h[0][nodata]=h[0][undetect]=0;
+  for(c=0;c<256;c++) st->hist[c]+=h[0][c];
+}
+
+/** \brief Encoder: adds 16-bit bins to <I>*st</I> as stats_8(), the classes being W >> 8 */
+static inline void stats_16(const uint8_t *in, long rows, long nbins, uint16_t nodata, uint16_t undetect, ScanStats *st)
+{
+  uint32_t h[4][256];
+  uint32_t nd=0,ud=0,raynd;
+  uint16_t W[4];
+  long r,i;
+  int c,k;
+
+  memset(h,0,sizeof(h));
+  for(r=0;r<rows;r++)
+  {
+     const uint8_t *ray=in+2*r*nbins;
+
+     raynd=0;
+     for(i=0;i+4<=nbins;i+=4)
+     {
+        memcpy(W,ray+2*i,8);
+        for(k=0;k<4;k++)
+        {
+           h[k][W[k]>>8]++;
+           raynd+=(W[k] == nodata);
+           ud+=(W[k] == undetect);
+        }
+     }
+     for(;i<nbins;i++)
+     {
+        memcpy(W,ray+2*i,2);
+        h[0][W[0]>>8]++;
+        raynd+=(W[0] == nodata);
+        ud+=(W[0] == undetect);
+     }
+     nd+=raynd;
+     st->missing_rays+=(raynd == (uint32_t)nbins && nodata != undetect);
+  }
+  if(nodata == undetect) nd=0; /* counted as undetect */
+  for(c=0;c<256;c++) h[0][c]+=h[1][c]+h[2][c]+h[3][c];
+  h[0][nodata>>8]-=nd;
+  h[0][undetect>>8]-=ud;
+  st->nodata+=nd;
+  st->undetect+=ud;
+  for(c=0;c<256;c++) st->hist[c]+=h[0][c];
+}
+
+/** \brief Encoder: codes (v - offset)/gain of <I>n</I> float physical values, rounded and limited
+to 1...254 (8-bit) or 1...65534 (16-bit). NaN is set to <I>nodata</I> and infinity to
+<I>undetect</I>. Output of the dual-PRF correction (ODIM_DEALIAS). */
+static inline void f32_to_code(const float *in, unsigned long n, int bytes, double gain, double offset,
+                               uint16_t nodata, uint16_t undetect, uint8_t *out)
+{
+  unsigned long iN;
+  double max=(bytes==1) ? 254.0 : 65534.0;
+
+  for(iN=0;iN<n;iN++)
+  {
+     double c=floor(((double)in[iN]-offset)/gain+0.5);
+     uint16_t W;
+
+     if(c<1.0) c=1.0;
+     if(c>max) c=max;
+     W=isnan(in[iN]) ? nodata : (isinf(in[iN]) ? undetect : (uint16_t)c);
+     if(bytes==1) out[iN]=(uint8_t)W; else memcpy(out+2*iN,&W,2);
+  }
+}
@@ -0,0 +1,201 @@
+/*! \file ODIM_log.h
+\brief Buffered logging for <I>IRIS_decoder.c</I> and <I>ODIM_encoder.c</I>.
+
+All program output goes thru log_msg(). Messages are formatted by the calling thread into a
+ring buffer of LOG_SLOTS records, and a background thread drains the ring every LOG_FLUSH_MS
+milliseconds (or when it is half full) and writes all pending records with one write per batch.
+The converting thread never waits for the output device unless the ring is full, so verbose
+output can be left on in production.<BR>
+Messages are never dropped: when the ring is full the caller waits for the drain thread.
+
+Levels: LOG_ERR, LOG_WARN and LOG_OUT are always written, LOG_INFO only with option -v.
+LOG_OUT records (program results, e.g. the output file name) always go to stdout, the other
+levels go to file ODIM_LOG_FILE (appended) if given, otherwise to stdout.<BR>
+ODIM_LOG_FORMAT=structured writes every record as one line
+"<I>UTC-time program product=name LEVEL message</I>". The default format <B>plain</B>
+writes the messages as such.
+
+Link with -pthread.
+*/
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+# define LOG_ERR   0 /**<\brief errors */
+# define LOG_WARN  1 /**<\brief warnings, e.g. missing rays */
+# define LOG_OUT   2 /**<\brief normal program output */
+# define LOG_INFO  3 /**<\brief verbose output (option -v) */
+
+# define LOG_SLOTS 2048 /**<\brief records in ring buffer */
+# define LOG_LINE  512  /**<\brief maximum length of one record, longer ones are truncated */
+# define LOG_FLUSH_MS 100 /**<\brief drain interval of the ring buffer */
+
+/*!\struct LogRecord
+\brief One formatted message in the ring buffer
+*/
+typedef struct {
+                  short level;
+                  short len;
+                  double epoch; /*!< UNIX seconds of the message */
+                  char text[LOG_LINE];
+               } LogRecord;
+
+static struct {
+                  int open;          /* drain thread running */
+                  int level;         /* highest level written */
+                  int structured;    /* ODIM_LOG_FORMAT=structured */
+                  const char *program;
+                  char product[200];
+                  FILE *LOGF;        /* sink of levels other than LOG_OUT */
+                  LogRecord *ring;
+                  unsigned long head,tail; /* head: next to write, tail: next to drain */
+                  int stop;
+                  pthread_t thread;
+                  pthread_mutex_t lock;
+                  pthread_cond_t filled,drained;
+               } LOG = { .level=LOG_OUT, .program="" }; /* others zero, lock and conditions set by log_open() */
+
+static const char *log_level_name[4] = {"ERROR","WARN","OUT","INFO"};
+
+/** \brief Writes one record to its sink. Called by drain thread only (or directly if log not open) */
+static void log_write_record(LogRecord *rec)
+{
+   FILE *OUTF = (rec->level==LOG_OUT || LOG.LOGF==NULL) ? stdout : LOG.LOGF;
+
+   if(LOG.structured)
+   {
+     char tstr[40],*p,*e;
+     time_t secs=(time_t)rec->epoch;
+     struct tm Sdd;
+
+     /* strip surrounding newlines, separator-only records are skipped */
+     for(p=rec->text;*p=='\n';p++);
+     for(e=rec->text+rec->len;e>p && e[-1]=='\n';e--);
+     if(e==p) return;
+     for(*e=0,e=p;*e;e++) if(*e=='\n') *e=' ';
+     gmtime_r(&secs,&Sdd);
+     strftime(tstr,sizeof(tstr),"%Y-%m-%dT%H:%M:%S",&Sdd);
+     fprintf(OUTF,"%s.%03dZ %s product=%s %s %s\n",tstr,(int)(1000.0*(rec->epoch-(double)secs)),
+             LOG.program,LOG.product,log_level_name[rec->level],p);
+   }
+   else fwrite(rec->text,1,rec->len,OUTF);
+}
+
+static void *log_drain(void *arg)
+{
+   LogRecord *batch=malloc(LOG_SLOTS*sizeof(LogRecord));
+   unsigned long n,i;
+
+   (void)arg;
+   while(1)
+   {
+      struct timespec due;
+
+      pthread_mutex_lock(&LOG.lock);
+      if(!LOG.stop && LOG.head-LOG.tail < LOG_SLOTS/2)
+      {
+         clock_gettime(CLOCK_REALTIME,&due);
+         due.tv_nsec+=LOG_FLUSH_MS*1000000L;
+         if(due.tv_nsec>=1000000000L) { due.tv_sec++; due.tv_nsec-=1000000000L; }
+         pthread_cond_timedwait(&LOG.filled,&LOG.lock,&due);
+      }
+      if(LOG.head==LOG.tail)
+      {
+         int stop=LOG.stop;
+
+         pthread_mutex_unlock(&LOG.lock);
+         if(stop) break; else continue;
+      }
+      for(n=0;LOG.tail!=LOG.head;n++,LOG.tail++) batch[n]=LOG.ring[LOG.tail%LOG_SLOTS];
+      pthread_cond_broadcast(&LOG.drained);
+      pthread_mutex_unlock(&LOG.lock);
+
+      for(i=0;i<n;i++) log_write_record(&batch[i]);
+      fflush(stdout);
+      if(LOG.LOGF) fflush(LOG.LOGF);
+   }
+   free(batch);
+   return(NULL);
+}
+
+/** \brief Drains all pending records and stops the drain thread. Registered with atexit(). */
+static void log_close(void)
+{
+   if(!LOG.open) return;
+   pthread_mutex_lock(&LOG.lock);
+   LOG.stop=1;
+   pthread_cond_signal(&LOG.filled);
+   pthread_mutex_unlock(&LOG.lock);
+   pthread_join(LOG.thread,NULL);
+   LOG.open=0;
+   if(LOG.LOGF) fclose(LOG.LOGF);
+   LOG.LOGF=NULL;
+   free(LOG.ring);
+   fflush(stdout);
+}
+
+/** \brief Starts the logging. Messages of <I>level</I> and lower are written. */
+static void log_open(const char *program, int level)
+{
+   char *envp;
+
+   LOG.program=program;
+   LOG.level=level;
+   envp=getenv("ODIM_LOG_FORMAT");
+   LOG.structured=(envp && strcmp(envp,"structured")==0);
+   envp=getenv("ODIM_LOG_FILE");
+   if(envp && (LOG.LOGF=fopen(envp,"a"))==NULL) fprintf(stderr,"Could not open log file %s\n",envp);
+
+   /* output is flushed once per drained batch */
+   setvbuf(stdout,NULL,_IOFBF,1<<16);
+   LOG.ring=malloc(LOG_SLOTS*sizeof(LogRecord));
+   pthread_mutex_init(&LOG.lock,NULL);
+   pthread_cond_init(&LOG.filled,NULL);
+   pthread_cond_init(&LOG.drained,NULL);
+   if(pthread_create(&LOG.thread,NULL,log_drain,NULL)==0)
+   {
+      LOG.open=1;
+      atexit(log_close);
+   }
+}
+
+/** \brief Sets the product name of structured records, e.g. input file name without path */
+static void log_product(const char *name)
+{
+   const char *p=strrchr(name,'/');
+
+   snprintf(LOG.product,sizeof(LOG.product),"%s",p ? p+1 : name);
+}
+
+/** \brief Formats a message to ring buffer. Returns immediately if <I>level</I> is not logged. */
+static void log_msg(int level, const char *fmt, ...)
+{
+   va_list ap;
+   LogRecord rec,*slot;
+   struct timespec now;
+   int len;
+
+   if(level > LOG.level) return;
+
+   va_start(ap,fmt);
+   len=vsnprintf(rec.text,LOG_LINE,fmt,ap);
+   va_end(ap);
+   if(len<0) return;
+   if(len>=LOG_LINE) len=LOG_LINE-1;
+   rec.len=len;
+   rec.level=level;
+   clock_gettime(CLOCK_REALTIME,&now);
+   rec.epoch=(double)now.tv_sec+1.0e-9*(double)now.tv_nsec;
+
+   if(!LOG.open) { log_write_record(&rec); return; }
+
+   pthread_mutex_lock(&LOG.lock);
+   while(LOG.head-LOG.tail >= LOG_SLOTS) pthread_cond_wait(&LOG.drained,&LOG.lock);
+   slot=&LOG.ring[LOG.head%LOG_SLOTS];
+   memcpy(slot,&rec,offsetof(LogRecord,text)+len+1);
+   LOG.head++;
+   /* drain thread is woken up early only when the ring gets half full */
+   if(LOG.head-LOG.tail == LOG_SLOTS/2) pthread_cond_signal(&LOG.filled);
+   pthread_mutex_unlock(&LOG.lock);
+}
@@ -0,0 +1,513 @@
+/*! \file ODIM_quantities.h
+\brief Quantity parameters and the wanted quantity selection of <I>ODIM_encoder.c</I> and
+<I>IRIS_decoder.c</I>.
+
+QCF has the output name, gain, offset, nodata and undetect of each quantity code (see
+ODIM_struct.h). The wanted quantities of each scan are parsed from the ODIM_<I>SITE</I>_quantities
+variable, e.g. '*:DBZH,VRADH 1,2:ZDR,RHOHV', by the same code in both programs, so the decoder
+can skip the quantities the encoder would not use.<BR>
+Include after ODIM_struct.h and ODIM_log.h.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+QuantCfg QCF[OQ_QUANTS_TOTAL]; /**< parameters of quantities by code, set by SetQuantityParams() */
+unsigned char ALL_QUANTS=0; /**< set if all quantities are wanted */
+short **wanted_scanquants=NULL; /**< wanted quantity codes of each scan, zero terminated */
+short *wanted_default=NULL; /**< wanted quantity codes of scans not in wanted_scanquants */
+int wanted_scans=0; /**< rows in wanted_scanquants */
+
+/** \brief Gives quantity code of ODIM quantity name <I>*Qstr</I> */
+short getQuantityCode(char *Qstr)
+{
+   short Qi;
+
+   for(Qi=0; Qi<OQ_QUANTS_TOTAL; Qi++)
+   {
+     if(strcmp(Qstr,QCF[Qi].in_quantity)==0) return(Qi);
+   }
+   return(0);
+}
+
+/** \brief sets parameters (gain, offset, nodata, undetect) of all quantities */
+void SetQuantityParams()
+{
+
+  short i;
+ 
+  for(i=0;i<OQ_QUANTS_TOTAL;i++)
+  {
+    memset( &QCF[i],0,sizeof(QuantCfg));
+    QCF[i].in_quantity[0]=' ';
+  }    
+
+  sprintf(QCF[OQ_TH].in_quantity,"TH");
+  sprintf(QCF[OQ_TH].quantity,"TH");
+  QCF[OQ_TH].gain=0.5;
+  QCF[OQ_TH].offset=-32;
+  QCF[OQ_TH].nodata=255;
+  QCF[OQ_TH].undetect=0;
+
+  sprintf(QCF[OQ_TV].in_quantity,"TV");
+  sprintf(QCF[OQ_TV].quantity,"TV");
+  QCF[OQ_TV].gain=0.5;
+  QCF[OQ_TV].offset=-32;
+  QCF[OQ_TV].nodata=255;
+  QCF[OQ_TV].undetect=0;
+
+  sprintf(QCF[OQ_TX].in_quantity,"TX");
+  sprintf(QCF[OQ_TX].quantity,"TX");
+  QCF[OQ_TX].gain=0.5;
+  QCF[OQ_TX].offset=-32;
+  QCF[OQ_TX].nodata=255;
+  QCF[OQ_TX].undetect=0;
+
+  sprintf(QCF[OQ_DBZH].in_quantity,"DBZH");
+  sprintf(QCF[OQ_DBZH].quantity,"DBZH");
+  QCF[OQ_DBZH].gain=0.5;
+  QCF[OQ_DBZH].offset=-32.0;
+  QCF[OQ_DBZH].nodata=255;
+  QCF[OQ_DBZH].undetect=0;
+
+  sprintf(QCF[OQ_DBZV].in_quantity,"DBZV");
+  sprintf(QCF[OQ_DBZV].quantity,"DBZV");
+  QCF[OQ_DBZV].gain=0.5;
+  QCF[OQ_DBZV].offset=-32.0;
+  QCF[OQ_DBZV].nodata=255;
+  QCF[OQ_DBZV].undetect=0;
+
+  sprintf(QCF[OQ_DBZX].in_quantity,"DBZX");
+  sprintf(QCF[OQ_DBZX].quantity,"DBZX");
+  QCF[OQ_DBZX].gain=0.5;
+  QCF[OQ_DBZX].offset=-32.0;
+  QCF[OQ_DBZX].nodata=255;
+  QCF[OQ_DBZX].undetect=0;
+
+  sprintf(QCF[OQ_SNR].in_quantity,"SNR");
+  sprintf(QCF[OQ_SNR].quantity,"SNR");
+  QCF[OQ_SNR].gain=0.5;
+  QCF[OQ_SNR].offset=-32.0;
+  QCF[OQ_SNR].nodata=255;
+  QCF[OQ_SNR].undetect=0;
+
+  sprintf(QCF[OQ_LOG].in_quantity,"LOG");
+  sprintf(QCF[OQ_LOG].quantity,"LOG");
+  QCF[OQ_LOG].gain=0.5;
+  QCF[OQ_LOG].offset=-32.0;
+  QCF[OQ_LOG].nodata=255;
+  QCF[OQ_LOG].undetect=0;
+
+  sprintf(QCF[OQ_CSP].in_quantity,"CSP");
+  sprintf(QCF[OQ_CSP].quantity,"CSP");
+  QCF[OQ_CSP].gain=0.5;
+  QCF[OQ_CSP].offset=-32.0;
+  QCF[OQ_CSP].nodata=255;
+  QCF[OQ_CSP].undetect=0;
+
+  sprintf(QCF[OQ_ATTV].in_quantity,"ATTV");
+  sprintf(QCF[OQ_ATTV].quantity,"ATTV");
+  QCF[OQ_ATTV].gain=0.5;
+  QCF[OQ_ATTV].offset=-32.0;
+  QCF[OQ_ATTV].nodata=255;
+  QCF[OQ_ATTV].undetect=0;
+
+  sprintf(QCF[OQ_PIA].in_quantity,"PIA");
+  sprintf(QCF[OQ_PIA].quantity,"PIA");
+  QCF[OQ_PIA].gain=0.5;
+  QCF[OQ_PIA].offset=-32.0;
+  QCF[OQ_PIA].nodata=255;
+  QCF[OQ_PIA].undetect=0;
+
+  sprintf(QCF[OQ_ATTZDR].in_quantity,"ATTZDR");
+  sprintf(QCF[OQ_ATTZDR].quantity,"ATTZDR");
+  QCF[OQ_ATTZDR].gain=0.5;
+  QCF[OQ_ATTZDR].offset=-32.0;
+  QCF[OQ_ATTZDR].nodata=255;
+  QCF[OQ_ATTZDR].undetect=0;
+
+  sprintf(QCF[OQ_DBZHC].in_quantity,"DBZHC");
+  sprintf(QCF[OQ_DBZHC].quantity,"DBZHC");
+  QCF[OQ_DBZHC].gain=0.5;
+  QCF[OQ_DBZHC].offset=-32.0;
+  QCF[OQ_DBZHC].nodata=255;
+  QCF[OQ_DBZHC].undetect=0;
+
+  sprintf(QCF[OQ_VRADH].in_quantity,"VRADH");
+  sprintf(QCF[OQ_VRADH].quantity,"VRADH");
+  QCF[OQ_VRADH].gain=1.0/127.0;
+  QCF[OQ_VRADH].offset=-128.0/127.0;
+  QCF[OQ_VRADH].nodata=0;
+  QCF[OQ_VRADH].undetect=0;
+
+  sprintf(QCF[OQ_VRADH2].in_quantity,"VRADH2");
+  sprintf(QCF[OQ_VRADH2].quantity,"VRADH");
+  QCF[OQ_VRADH2].gain=0.01;
+  QCF[OQ_VRADH2].offset=-327.68;
+  QCF[OQ_VRADH2].nodata=65535;
+  QCF[OQ_VRADH2].undetect=0;
+
+  sprintf(QCF[OQ_VRADDH].in_quantity,"VRADDH");
+  sprintf(QCF[OQ_VRADDH].quantity,"VRADDH");
+  QCF[OQ_VRADDH].gain=75.0/127.0;
+  QCF[OQ_VRADDH].offset=-(150.0/127.0+74.4);
+  QCF[OQ_VRADDH].nodata=255;
+  QCF[OQ_VRADDH].undetect=0;
+
+  sprintf(QCF[OQ_VRADDH2].in_quantity,"VRADDH2");
+  sprintf(QCF[OQ_VRADDH2].quantity,"VRADDH");
+  QCF[OQ_VRADDH2].gain=0.01;
+  QCF[OQ_VRADDH2].offset=-327.68;
+  QCF[OQ_VRADDH2].nodata=65535;
+  QCF[OQ_VRADDH2].undetect=0;
+
+  sprintf(QCF[OQ_WRADH].in_quantity,"WRADH");
+  sprintf(QCF[OQ_WRADH].quantity,"WRADH");
+  QCF[OQ_WRADH].gain=1.0/256.0; 
+  QCF[OQ_WRADH].offset=0;
+  QCF[OQ_WRADH].nodata=255;
+  QCF[OQ_WRADH].undetect=0;
+
+  sprintf(QCF[OQ_WRADH2].in_quantity,"WRADH2");
+  sprintf(QCF[OQ_WRADH2].quantity,"WRADH");
+  QCF[OQ_WRADH2].gain=0.01;
+  QCF[OQ_WRADH2].offset=0;
+  QCF[OQ_WRADH2].nodata=65535;
+  QCF[OQ_WRADH2].undetect=0;
+
+  sprintf(QCF[OQ_ZDR].in_quantity,"ZDR");
+  sprintf(QCF[OQ_ZDR].quantity,"ZDR");
+  QCF[OQ_ZDR].gain=1.0/16.0;
+  QCF[OQ_ZDR].offset=128.0/16.0;
+  QCF[OQ_ZDR].nodata=255;
+  QCF[OQ_ZDR].undetect=0;
+
+  sprintf(QCF[OQ_ZDRC].in_quantity,"ZDRC");
+  sprintf(QCF[OQ_ZDRC].quantity,"ZDRC");
+  QCF[OQ_ZDRC].gain=1.0/16.0;
+  QCF[OQ_ZDRC].offset=128.0/16.0;
+  QCF[OQ_ZDRC].nodata=255;
+  QCF[OQ_ZDRC].undetect=0;
+
+  sprintf(QCF[OQ_TH2].in_quantity,"TH2");
+  sprintf(QCF[OQ_TH2].quantity,"TH");
+  QCF[OQ_TH2].gain=0.01;
+  QCF[OQ_TH2].offset=-327.68;
+  QCF[OQ_TH2].nodata=65535;
+  QCF[OQ_TH2].undetect=0;
+
+  sprintf(QCF[OQ_TV2].in_quantity,"TV2");
+  sprintf(QCF[OQ_TV2].quantity,"TV");
+  QCF[OQ_TV2].gain=0.01;
+  QCF[OQ_TV2].offset=-327.68;
+  QCF[OQ_TV2].nodata=65535;
+  QCF[OQ_TV2].undetect=0;
+
+  sprintf(QCF[OQ_TX2].in_quantity,"TX2");
+  sprintf(QCF[OQ_TX2].quantity,"TX");
+  QCF[OQ_TX2].gain=0.01;
+  QCF[OQ_TX2].offset=-327.68;
+  QCF[OQ_TX2].nodata=65535;
+  QCF[OQ_TX2].undetect=0;
+
+  sprintf(QCF[OQ_DBZH2].in_quantity,"DBZH2");
+  sprintf(QCF[OQ_DBZH2].quantity,"DBZH");
+  QCF[OQ_DBZH2].gain=0.01;
+  QCF[OQ_DBZH2].offset=-327.68;
+  QCF[OQ_DBZH2].nodata=65535;
+  QCF[OQ_DBZH2].undetect=0;
+
+  sprintf(QCF[OQ_DBZV2].in_quantity,"DBZV2");
+  sprintf(QCF[OQ_DBZV2].quantity,"DBZV");
+  QCF[OQ_DBZV2].gain=0.01;
+  QCF[OQ_DBZV2].offset=-327.68;
+  QCF[OQ_DBZV2].nodata=65535;
+  QCF[OQ_DBZV2].undetect=0;
+
+  sprintf(QCF[OQ_DBZX2].in_quantity,"DBZX2");
+  sprintf(QCF[OQ_DBZX2].quantity,"DBZX");
+  QCF[OQ_DBZX2].gain=0.01;
+  QCF[OQ_DBZX2].offset=-327.68;
+  QCF[OQ_DBZX2].nodata=65535;
+  QCF[OQ_DBZX2].undetect=0;
+
+  sprintf(QCF[OQ_SNR2].in_quantity,"SNR2");
+  sprintf(QCF[OQ_SNR2].quantity,"SNR");
+  QCF[OQ_SNR2].gain=0.01;
+  QCF[OQ_SNR2].offset=-327.68;
+  QCF[OQ_SNR2].nodata=65535;
+  QCF[OQ_SNR2].undetect=0;
+
+  sprintf(QCF[OQ_LOG2].in_quantity,"LOG2");
+  sprintf(QCF[OQ_LOG2].quantity,"LOG");
+  QCF[OQ_LOG2].gain=0.01;
+  QCF[OQ_LOG2].offset=-327.68;
+  QCF[OQ_LOG2].nodata=65535;
+  QCF[OQ_LOG2].undetect=0;
+
+  sprintf(QCF[OQ_CSP2].in_quantity,"CSP2");
+  sprintf(QCF[OQ_CSP2].quantity,"CSP");
+  QCF[OQ_CSP2].gain=0.01;
+  QCF[OQ_CSP2].offset=-327.68;
+  QCF[OQ_CSP2].nodata=65535;
+  QCF[OQ_CSP2].undetect=0;
+
+  sprintf(QCF[OQ_ATTV2].in_quantity,"ATTV2");
+  sprintf(QCF[OQ_ATTV2].quantity,"ATTV");
+  QCF[OQ_ATTV2].gain=0.01;
+  QCF[OQ_ATTV2].offset=-327.68;
+  QCF[OQ_ATTV2].nodata=65535;
+  QCF[OQ_ATTV2].undetect=0;
+
+  sprintf(QCF[OQ_PIA2].in_quantity,"PIA2");
+  sprintf(QCF[OQ_PIA2].quantity,"PIA");
+  QCF[OQ_PIA2].gain=0.01;
+  QCF[OQ_PIA2].offset=-327.68;
+  QCF[OQ_PIA2].nodata=65535;
+  QCF[OQ_PIA2].undetect=0;
+
+  sprintf(QCF[OQ_ATTZDR2].in_quantity,"ATTZDR2");
+  sprintf(QCF[OQ_ATTZDR2].quantity,"ATTZDR");
+  QCF[OQ_ATTZDR2].gain=0.01;
+  QCF[OQ_ATTZDR2].offset=-327.68;
+  QCF[OQ_ATTZDR2].nodata=65535;
+  QCF[OQ_ATTZDR2].undetect=0;
+
+  sprintf(QCF[OQ_DBZHC2].in_quantity,"DBZHC2");
+  sprintf(QCF[OQ_DBZHC2].quantity,"DBZHC");
+  QCF[OQ_DBZHC2].gain=0.01;
+  QCF[OQ_DBZHC2].offset=-327.68;
+  QCF[OQ_DBZHC2].nodata=65535;
+  QCF[OQ_DBZHC2].undetect=0;
+
+  sprintf(QCF[OQ_ZDR2].in_quantity,"ZDR2");
+  sprintf(QCF[OQ_ZDR2].quantity,"ZDR");
+  QCF[OQ_ZDR2].gain=0.01;
+  QCF[OQ_ZDR2].offset=-327.68;
+  QCF[OQ_ZDR2].nodata=65535;
+  QCF[OQ_ZDR2].undetect=0;
+
+  sprintf(QCF[OQ_ZDRC2].in_quantity,"ZDRC2");
+  sprintf(QCF[OQ_ZDRC2].quantity,"ZDRC");
+  QCF[OQ_ZDRC2].gain=0.01;
+  QCF[OQ_ZDRC2].offset=-327.68;
+  QCF[OQ_ZDRC2].nodata=65535;
+  QCF[OQ_ZDRC2].undetect=0;
+
+  sprintf(QCF[OQ_KDP2].in_quantity,"KDP2");
+  sprintf(QCF[OQ_KDP2].quantity,"KDP");
+  QCF[OQ_KDP2].gain=0.01;
+  QCF[OQ_KDP2].offset=-327.68;
+  QCF[OQ_KDP2].nodata=65535;
+  QCF[OQ_KDP2].undetect=0;
+
+  sprintf(QCF[OQ_PHIDP].in_quantity,"PHIDP");
+  sprintf(QCF[OQ_PHIDP].quantity,"PHIDP");
+  QCF[OQ_PHIDP].gain=180.0/254.0;
+  QCF[OQ_PHIDP].offset=-QCF[OQ_PHIDP].gain;
+  QCF[OQ_PHIDP].nodata=255;
+  QCF[OQ_PHIDP].undetect=0;
+
+  sprintf(QCF[OQ_SQIH2].in_quantity,"SQIH2");
+  sprintf(QCF[OQ_SQIH2].quantity,"SQIH");
+  QCF[OQ_SQIH2].gain=1.0/65533.0;
+  QCF[OQ_SQIH2].offset=-QCF[OQ_SQIH2].gain;
+  QCF[OQ_SQIH2].nodata=65535;
+  QCF[OQ_SQIH2].undetect=0;
+
+  sprintf(QCF[OQ_PMI2].in_quantity,"PMI2");
+  sprintf(QCF[OQ_PMI2].quantity,"PMI");
+  QCF[OQ_PMI2].gain=1.0/65533.0;
+  QCF[OQ_PMI2].offset=-QCF[OQ_PMI2].gain;
+  QCF[OQ_PMI2].nodata=65535;
+  QCF[OQ_PMI2].undetect=0;
+
+  sprintf(QCF[OQ_CCOR2].in_quantity,"CCOR2");
+  sprintf(QCF[OQ_CCOR2].quantity,"CCOR");
+  QCF[OQ_CCOR2].gain=1.0/65533.0;
+  QCF[OQ_CCOR2].offset=-QCF[OQ_CCOR2].gain;
+  QCF[OQ_CCOR2].nodata=65535;
+  QCF[OQ_CCOR2].undetect=0;
+
+  sprintf(QCF[OQ_RHOHV2].in_quantity,"RHOHV2");
+  sprintf(QCF[OQ_RHOHV2].quantity,"RHOHV");
+  QCF[OQ_RHOHV2].gain=1.0/65533.0;
+  QCF[OQ_RHOHV2].offset=-QCF[OQ_RHOHV2].gain;
+  QCF[OQ_RHOHV2].nodata=65535;
+  QCF[OQ_RHOHV2].undetect=0;
+
+  sprintf(QCF[OQ_RHOHV].in_quantity,"RHOHV");
+  sprintf(QCF[OQ_RHOHV].quantity,"RHOHV");
+  QCF[OQ_RHOHV].gain=1.0/65533.0;
+  QCF[OQ_RHOHV].offset=-QCF[OQ_RHOHV].gain;
+  QCF[OQ_RHOHV].nodata=65535;
+  QCF[OQ_RHOHV].undetect=0;
+
+  sprintf(QCF[OQ_PHIDP2].in_quantity,"PHIDP2");
+  sprintf(QCF[OQ_PHIDP2].quantity,"PHIDP");
+  QCF[OQ_PHIDP2].gain=360.0/65534.0;
+  QCF[OQ_PHIDP2].offset=-QCF[OQ_PHIDP2].gain;
+  QCF[OQ_PHIDP2].nodata=65535;
+  QCF[OQ_PHIDP2].undetect=0;
+
+  sprintf(QCF[OQ_LDR].in_quantity,"LDR");
+  sprintf(QCF[OQ_LDR].quantity,"LDR");
+  QCF[OQ_LDR].gain=0.2;
+  QCF[OQ_LDR].offset=-QCF[OQ_LDR].gain-45.0;
+  QCF[OQ_LDR].nodata=255;
+  QCF[OQ_LDR].undetect=0;
+
+  sprintf(QCF[OQ_LDR2].in_quantity,"LDR2");
+  sprintf(QCF[OQ_LDR2].quantity,"LDR");
+  QCF[OQ_LDR2].gain=0.01;
+  QCF[OQ_LDR2].offset=-327.68;
+  QCF[OQ_LDR2].nodata=65535;
+  QCF[OQ_LDR2].undetect=0;
+
+  sprintf(QCF[OQ_LDRV].in_quantity,"LDRV");
+  sprintf(QCF[OQ_LDRV].quantity,"LDRV");
+  QCF[OQ_LDRV].gain=0.2;
+  QCF[OQ_LDRV].offset=-QCF[OQ_LDRV].gain-45.0;
+  QCF[OQ_LDRV].nodata=255;
+  QCF[OQ_LDRV].undetect=0;
+
+  sprintf(QCF[OQ_LDRV2].in_quantity,"LDRV2");
+  sprintf(QCF[OQ_LDRV2].quantity,"LDRV");
+  QCF[OQ_LDRV2].gain=0.01;
+  QCF[OQ_LDRV2].offset=-327.68;
+  QCF[OQ_LDRV2].nodata=65535;
+  QCF[OQ_LDRV2].undetect=0;
+
+  sprintf(QCF[OQ_HCLASS].in_quantity,"HCLASS");
+  sprintf(QCF[OQ_HCLASS].quantity,"HCLASS");
+  QCF[OQ_HCLASS].gain=1.0;
+  QCF[OQ_HCLASS].offset=0.0;
+  QCF[OQ_HCLASS].nodata=255;
+  QCF[OQ_HCLASS].undetect=0;
+
+  sprintf(QCF[OQ_HCLASS2].in_quantity,"HCLASS2");
+  sprintf(QCF[OQ_HCLASS2].quantity,"HCLASS");
+  QCF[OQ_HCLASS2].gain=1.0;
+  QCF[OQ_HCLASS2].offset=0.0;
+  QCF[OQ_HCLASS2].nodata=65535;
+  QCF[OQ_HCLASS2].undetect=0;
+
+
+}
+
+
+/** \brief Sets quantity \#<I>qu</I> (origin 0) of the zero terminated list <I>*row</I> to <I>Qcode</I>, growing the list */
+static void set_wanted_quantity(short **row, int qu, short Qcode)
+{
+   int n=0;
+
+   if(*row) while((*row)[n]) n++;
+   if(qu >= n)
+   {
+      *row=realloc(*row,(qu+2)*sizeof(short));
+      memset(*row+n,0,(qu+2-n)*sizeof(short));
+   }
+   (*row)[qu]=Qcode;
+}
+
+/** \brief Gives the zero terminated wanted quantity codes of scan \#<I>scan</I> (origin 1) */
+short *wanted_quants_of_scan(int scan)
+{
+   static short none=0;
+
+   if(scan >= 0 && scan < wanted_scans && wanted_scanquants[scan]) return(wanted_scanquants[scan]);
+   if(wanted_default) return(wanted_default);
+   return(&none);
+}
+
+/** \brief Parses wanted quantities from ODIM_</I>SITE</I>_quantities environment
+variable.<BR> <I>SITE</I> is the IRIS radar site code.<BR> The codes of quantities found are
+put to <I>wanted_scanquants[scan index][quantity index]</I> table, or to <I>wanted_default</I>
+for all scans ('*'). Call SetQuantityParams() first. */ 
+void get_wanted_quantities(char *Qstr)
+{
+         /* reading wanted quantities */
+          char *votoken, *swtoken, *qutoken, *vostr, *swstr, *qustr;
+          char *vo_saveptr, *sw_saveptr, *qu_saveptr; 
+          char volim[2]=" ",swlim[2]=":",qulim[2]="," ;
+          short Qcode,vo,sw,qu;
+          int swcount,swI,*swlist,allscans;
+
+          if(!Qstr || strcmp(Qstr,"ALL")==0 || strcmp(Qstr,"*")==0   || strcmp(Qstr,"*:*")==0) 
+          {
+            ALL_QUANTS=1;
+            set_wanted_quantity(&wanted_default,0,-1);
+           log_msg(LOG_INFO,"\nAll found quantities will be encoded\n\n");
+            return;
+          } else log_msg(LOG_INFO,"\nSEARCHING: %s\n\n",Qstr);
+
+          /* scan numbers of a list are at most half of the characters */
+          swlist=calloc(strlen(Qstr)/2+1,sizeof(int));
+          for(vo=1,vostr=&Qstr[0];;vo++,vostr=NULL)
+          {
+               swcount=0;
+               allscans=0;
+               votoken=strtok_r(vostr,volim,&vo_saveptr);
+               if(votoken == NULL) break;
+               for(sw=1,swstr=votoken;;sw++,swstr=NULL)
+               {
+                  swtoken=strtok_r(swstr,swlim,&sw_saveptr);
+                  if(swtoken == NULL) break;
+                  for(qu=1,qustr=swtoken;;qu++,qustr=NULL)
+                  {
+                    qutoken=strtok_r(qustr,qulim,&qu_saveptr);
+                    if(qutoken==NULL) break;
+                    if(sw==1) 
+                    { 
+                      if(qutoken[0]=='*') allscans=1;
+                      else
+                      {
+                        swlist[swcount]=atoi(qutoken);
+                        if(swlist[swcount]<0) continue;
+                        /* a scan listed first time gets the quantities given for all scans so far */
+                        if(swlist[swcount] >= wanted_scans)
+                        {
+                           wanted_scanquants=realloc(wanted_scanquants,(swlist[swcount]+1)*sizeof(short *));
+                           memset(wanted_scanquants+wanted_scans,0,(swlist[swcount]+1-wanted_scans)*sizeof(short *));
+                           wanted_scans=swlist[swcount]+1;
+                        }
+                        if(!wanted_scanquants[swlist[swcount]])
+                        {
+                           short *def=wanted_quants_of_scan(-1);
+
+                           for(swI=0;def[swI];swI++) set_wanted_quantity(&wanted_scanquants[swlist[swcount]],swI,def[swI]);
+                           set_wanted_quantity(&wanted_scanquants[swlist[swcount]],swI,0);
+                        }
+                        swcount++;
+                      }
+                    } else
+                    {
+                      if(qutoken[0]=='*') Qcode=-1; else
+                         Qcode=getQuantityCode(qutoken);
+                      if(allscans)
+                      {
+                         set_wanted_quantity(&wanted_default,qu-1,Qcode);
+                         for(swI=0;swI<wanted_scans;swI++)
+                           if(wanted_scanquants[swI]) set_wanted_quantity(&wanted_scanquants[swI],qu-1,Qcode);
+                      }
+                      else for(swI=0;swI<swcount;swI++) set_wanted_quantity(&wanted_scanquants[swlist[swI]],qu-1,Qcode);
+                    }
+                  }
+               }
+          }
+          free(swlist);
+ }
+
+/** \brief Tells if quantity of code <I>AQ</I> is in the zero terminated list <I>wanted</I>. A quantity
+is wanted also as 1- or 2-byte version of a wanted one, and all are wanted if the list has -1. */
+int quantity_wanted(short *wanted, short AQ)
+{
+   short wq,WQ;
+
+   for(wq=0;(WQ=wanted[wq]);wq++)
+   {
+      if(WQ<0) return(1);
+      if((WQ == AQ) || (WQ == AQ+TWOB) || (AQ == WQ+TWOB)) return(1);
+   }
+   return(0);
+}
@@ -12,31 +12,22 @@ are given here as an example.
 Data is organized so that the root level (e.g. /what) contains common attributes
 for all data. Dataset attributes (e.g. /dataset1/what) are common for all data types of a scan,
 and quantity attributes (e.g. /dataset2/data3/what) defines the characteristics of one data type, 
-e.g. reflectivity, doppler velocity etc. These all are combined to MetaData structure having
-fixed size: Maximum number of datasets (scans) in one file is 50 and maximum number of datatypes 
-in a dataset is 64.
+e.g. reflectivity, doppler velocity etc. These all are combined to MetaData structure.
+The datasets, the quantities of a dataset and the per ray attributes of a dataset are
+allocated for the actual counts of the product, so there is no limit of scans, quantities
+or rays.
 
 The intermediate data/metadata file written by IRIS_decoder and read by
-ODIM_encoder is generated by dumping the MetaData structure to disk 
-immediately followed by data dump.
+ODIM_encoder holds the MetaData structure immediately followed by data dump
+(see ODIM_io.h). The structures written to the file are packed to 4 byte alignment, the
+alignment of the i386 ABI, so the file layout is the same for 32- and 64-bit builds and
+64-bit builds read the files of the 32-bit binaries.
 */
 
 /*!\def OQ_QUANTS_TOTAL
 /\brief Codes reserved for radar data quantities 
 */
 # define OQ_QUANTS_TOTAL 300
-/*!\def MAX_QUANTS
-\brief maximum amount of IRIS quantities 
-*/ 
-# define MAX_QUANTS 128
-/*!\def MAX_SCANS
-\brief maximum amount of scans in one file 
-*/ 
-# define MAX_SCANS 50
-/*!\def MAX_AZIMS
-\brief maximum amount of azimuths in one scan 
-*/ 
-# define MAX_AZIMS 3600
 
 /*!\def TWOB
 \brief Codes incremented by this are reserved for 2-byte data 
@@ -159,6 +150,9 @@ typedef struct {
                  int undetect; /**< value used for measurement under detection limit, e.g. no echo detected */
                } QuantCfg;
 
+/* structures of the intermediate file, alignment as in i386 */
+#pragma pack(push,4)
+
 /*!\struct RootWhat
 \brief HDF5 group <B>/what</B> attributes
 */
@@ -272,12 +266,6 @@ typedef struct {
                   uint16_t Cflags[2];
                   double LDR_bias;
                   double ZDR_bias;
-                  double startazA[MAX_AZIMS]; /* V23: list of scan start azimuths per ray */ 
-                  double stopazA[MAX_AZIMS];  /* V23: list of scan stop azimuths per ray */ 
-                  double startelA[MAX_AZIMS]; /* V23: list of scan start elevations per ray */ 
-                  double stopelA[MAX_AZIMS];  /* V23: list of scan stop elevations per ray */ 
-                  double startT[MAX_AZIMS];   /* V23: list of start times per ray */ 
-                  double stopT[MAX_AZIMS];    /* V23: list of stop times per ray */ 
                   char malfunc[6]; /* V23 */
                   char radar_msg[500]; /* V23 */
                   char Dclutter[200];                
@@ -358,15 +346,24 @@ typedef struct {
                   DataHow how;
                } QuantitySet;
 
+#pragma pack(pop)
+
 /*!\struct DataSet
 \brief Dataset specific attributes (common attributes of a scan) 
 */
 typedef struct {
                   short quantities; /* external: amount of quantities */ 
-                  QuantitySet data[MAX_QUANTS]; 
+                  QuantitySet *data; /* [quantities] */
                   SetWhat what;
                   SetWhere where;
                   How how;
+                  /* per ray lists of /datasetN/how, [where.nrays] each (one allocation, see alloc_dataset()) */
+                  double *startazA; /* V23: list of scan start azimuths per ray */ 
+                  double *stopazA;  /* V23: list of scan stop azimuths per ray */ 
+                  double *startelA; /* V23: list of scan start elevations per ray */ 
+                  double *stopelA;  /* V23: list of scan stop elevations per ray */ 
+                  double *startT;   /* V23: list of start times per ray */ 
+                  double *stopT;    /* V23: list of stop times per ray */ 
                } DataSet;
 
 /*!\struct MetaData
@@ -378,6 +375,6 @@ typedef struct {
                   RootWhat what;
                   RootWhere where;
                   How how;
-                  DataSet dataset[MAX_SCANS]; /* scans */
+                  DataSet *dataset; /* [scans] */
                } MetaData;
 
@@ -0,0 +1,241 @@
+/*! \file ODIM_timing.h
+\brief Low-overhead stage timers and throughput counters for <I>IRIS_decoder.c</I> and
+<I>ODIM_encoder.c</I>.
+
+Timing is switched on by setting the environment variable ODIM_TIMING_FILE to the path of
+the report file. A "%s" in the path is replaced with the program name, so both programs of a
+conversion can write their own report. The path "-" writes the report to stderr.<BR>
+ODIM_TIMING_FORMAT selects the report format:<BR>
+<B>json</B> (default) : one JSON object per run, appended to the file (JSON Lines) <BR>
+<B>prometheus</B> : Prometheus text exposition format, the file is rewritten every run
+(suitable for the node_exporter textfile collector) <BR>
+
+When timing is off every timer call returns after one flag test, so the timers can be left
+in the inner loops. Clock is CLOCK_MONOTONIC (link with -lrt on old glibc).
+*/
+
+#include <time.h>
+
+/*!\enum TimingStage
+\brief Measured stages of the conversion. Decoder and encoder use their own subsets.
+*/
+enum TimingStage {
+                  T_OPEN,       /*!< RAW product open/map */
+                  T_HEADER,     /*!< product and ingest header parsing */
+                  T_DECOMPRESS, /*!< ray decompression (uncompress_cowords) */
+                  T_CONVERT,    /*!< decoder 8/16-bit conversions of bins */
+                  T_WRITE,      /*!< intermediate file write */
+                  T_READ,       /*!< encoder read of intermediate file */
+                  T_REQUANT,    /*!< encoder requantization (Encode 8/16) */
+                  T_DEFLATE,    /*!< HDF5 dataset write including deflate */
+                  T_ATTRS,      /*!< HDF5 attribute writes */
+                  T_PROJECT,    /*!< encoder Cartesian product (ODIM_CART_FILE) */
+                  T_DEALIAS,    /*!< encoder dual-PRF velocity correction (ODIM_DEALIAS) */
+                  T_TOTAL,      /*!< whole run */
+                  T_STAGES
+                 };
+
+static const char *timing_stage_name[T_STAGES] =
+  {"open","header","decompress","convert","write","read","requant","deflate","attrs","project","dealias","total"};
+
+/*!\struct Timing
+\brief Accumulated times and counters of one run
+*/
+typedef struct {
+                  int on;                   /*!< TRUE if ODIM_TIMING_FILE is set */
+                  const char *program;      /*!< program name used in report */
+                  const char *product;      /*!< input product name used in report */
+                  double start_epoch;       /*!< wall clock start of run */
+                  struct timespec t0[T_STAGES]; /*!< start of running timer */
+                  double secs[T_STAGES];    /*!< accumulated seconds per stage */
+                  long calls[T_STAGES];     /*!< timer start/stop pairs per stage */
+                  uint64_t bytes_in;        /*!< bytes read (RAW product or intermediate file) */
+                  uint64_t bytes_out;       /*!< bytes written (intermediate file or HDF5 data) */
+                  uint64_t bins;            /*!< range bins decoded or encoded */
+                  int sweeps;               /*!< number of per-sweep entries */
+                  double *sweep_secs;       /*!< per-sweep ray decompression time */
+               } Timing;
+
+static Timing TIMING;
+
+static double timing_diff(struct timespec *a, struct timespec *b)
+{
+   return((double)(b->tv_sec - a->tv_sec) + 1.0e-9*(double)(b->tv_nsec - a->tv_nsec));
+}
+
+/** \brief Initializes timing if ODIM_TIMING_FILE is set and starts the T_TOTAL timer */
+static void timing_init(const char *program, const char *product)
+{
+   struct timespec now;
+
+   memset(&TIMING,0,sizeof(Timing));
+   if(getenv("ODIM_TIMING_FILE")==NULL) return;
+   TIMING.on=1;
+   TIMING.program=program;
+   TIMING.product=product;
+   clock_gettime(CLOCK_REALTIME,&now);
+   TIMING.start_epoch=(double)now.tv_sec+1.0e-9*(double)now.tv_nsec;
+   clock_gettime(CLOCK_MONOTONIC,&TIMING.t0[T_TOTAL]);
+}
+
+/** \brief Starts the timer of stage <I>st</I> */
+static void timing_start(int st)
+{
+   if(!TIMING.on) return;
+   clock_gettime(CLOCK_MONOTONIC,&TIMING.t0[st]);
+}
+
+/** \brief Stops the timer of stage <I>st</I> and adds the elapsed time to the stage total */
+static void timing_stop(int st)
+{
+   struct timespec now;
+
+   if(!TIMING.on) return;
+   clock_gettime(CLOCK_MONOTONIC,&now);
+   TIMING.secs[st]+=timing_diff(&TIMING.t0[st],&now);
+   TIMING.calls[st]++;
+}
+
+/** \brief Adds to byte and bin counters */
+static void timing_count(uint64_t bytes_in, uint64_t bytes_out, uint64_t bins)
+{
+   if(!TIMING.on) return;
+   TIMING.bytes_in+=bytes_in;
+   TIMING.bytes_out+=bytes_out;
+   TIMING.bins+=bins;
+}
+
+#ifdef IRIS_DECODER
+/** \brief Stores the ray decompression time of sweep \#<I>iS</I> (origin 0). Decoder only. */
+static void timing_sweep(int iS, double secs)
+{
+   if(!TIMING.on || iS<0) return;
+   if(iS>=TIMING.sweeps)
+   {
+      TIMING.sweep_secs=realloc(TIMING.sweep_secs,(iS+1)*sizeof(double));
+      memset(&TIMING.sweep_secs[TIMING.sweeps],0,(iS+1-TIMING.sweeps)*sizeof(double));
+      TIMING.sweeps=iS+1;
+   }
+   TIMING.sweep_secs[iS]=secs;
+}
+#endif
+
+/** \brief Writes <I>s</I> as a JSON string, escaping quotes, backslashes and control characters */
+static void timing_json_string(FILE *F, const char *s)
+{
+   fputc('"',F);
+   for(;*s;s++)
+   {
+      if(*s=='"' || *s=='\\') fprintf(F,"\\%c",*s);
+      else if((unsigned char)*s<0x20) fprintf(F,"\\u%04x",(unsigned char)*s);
+      else fputc(*s,F);
+   }
+   fputc('"',F);
+}
+
+/** \brief Stops the T_TOTAL timer and writes the report to ODIM_TIMING_FILE */
+static void timing_report(void)
+{
+   FILE *REPF;
+   char path[1000], tmppath[1100], *fmt, *fname, *subst;
+   size_t n,len;
+   int st,i,prom;
+
+   if(!TIMING.on) return;
+   timing_stop(T_TOTAL);
+   TIMING.on=0;
+
+   fname=getenv("ODIM_TIMING_FILE");
+   fmt=getenv("ODIM_TIMING_FORMAT");
+   prom=(fmt && (strcmp(fmt,"prometheus")==0 || strcmp(fmt,"prom")==0));
+
+   /* the first "%s" is replaced with the program name, the rest of the path is copied as is
+      (the path is never used as a format, so other % characters are harmless) */
+   n=0;
+   subst=strstr(fname,"%s");
+   if(subst)
+   {
+      len=(size_t)(subst-fname);
+      if(len>sizeof(path)-1) len=sizeof(path)-1;
+      memcpy(path,fname,len);
+      n=len;
+      len=strlen(TIMING.program);
+      if(len>sizeof(path)-1-n) len=sizeof(path)-1-n;
+      memcpy(path+n,TIMING.program,len);
+      n+=len;
+      fname=subst+2;
+   }
+   len=strlen(fname);
+   if(len>sizeof(path)-1-n) len=sizeof(path)-1-n;
+   memcpy(path+n,fname,len);
+   path[n+len]='\0';
+
+   if(strcmp(path,"-")==0) REPF=stderr;
+   else if(prom)
+   {
+      /* written to temporary file and renamed, so that a collector never sees a partial file */
+      snprintf(tmppath,sizeof(tmppath),"%s.tmp",path);
+      REPF=fopen(tmppath,"w");
+   }
+   else REPF=fopen(path,"a");
+   if(REPF==NULL) { fprintf(stderr,"Could not open timing report file %s\n",path); return; }
+
+   if(prom)
+   {
+      fprintf(REPF,"# HELP odim_stage_seconds Time spent in conversion stage\n");
+      fprintf(REPF,"# TYPE odim_stage_seconds gauge\n");
+      for(st=0;st<T_STAGES;st++) if(TIMING.calls[st])
+         fprintf(REPF,"odim_stage_seconds{program=\"%s\",stage=\"%s\"} %.6f\n",
+                 TIMING.program,timing_stage_name[st],TIMING.secs[st]);
+      fprintf(REPF,"# HELP odim_stage_calls Number of timed calls of conversion stage\n");
+      fprintf(REPF,"# TYPE odim_stage_calls gauge\n");
+      for(st=0;st<T_STAGES;st++) if(TIMING.calls[st])
+         fprintf(REPF,"odim_stage_calls{program=\"%s\",stage=\"%s\"} %ld\n",
+                 TIMING.program,timing_stage_name[st],TIMING.calls[st]);
+      fprintf(REPF,"# TYPE odim_sweep_decompress_seconds gauge\n");
+      for(i=0;i<TIMING.sweeps;i++)
+         fprintf(REPF,"odim_sweep_decompress_seconds{program=\"%s\",sweep=\"%d\"} %.6f\n",
+                 TIMING.program,i+1,TIMING.sweep_secs[i]);
+      fprintf(REPF,"# TYPE odim_bytes_in gauge\nodim_bytes_in{program=\"%s\"} %llu\n",
+              TIMING.program,(unsigned long long)TIMING.bytes_in);
+      fprintf(REPF,"# TYPE odim_bytes_out gauge\nodim_bytes_out{program=\"%s\"} %llu\n",
+              TIMING.program,(unsigned long long)TIMING.bytes_out);
+      fprintf(REPF,"# TYPE odim_bins gauge\nodim_bins{program=\"%s\"} %llu\n",
+              TIMING.program,(unsigned long long)TIMING.bins);
+      fprintf(REPF,"# TYPE odim_run_start_seconds gauge\nodim_run_start_seconds{program=\"%s\"} %.3f\n",
+              TIMING.program,TIMING.start_epoch);
+   }
+   else
+   {
+      fprintf(REPF,"{\"program\":\"%s\",\"product\":",TIMING.program);
+      timing_json_string(REPF,TIMING.product ? TIMING.product : "");
+      fprintf(REPF,",\"start\":%.3f,\"stages\":{",TIMING.start_epoch);
+      for(i=0,st=0;st<T_STAGES;st++) if(TIMING.calls[st])
+      {
+         fprintf(REPF,"%s\"%s\":{\"seconds\":%.6f,\"calls\":%ld}",i ? ",":"",
+                 timing_stage_name[st],TIMING.secs[st],TIMING.calls[st]);
+         i++;
+      }
+      fprintf(REPF,"}");
+      if(TIMING.sweeps)
+      {
+        fprintf(REPF,",\"sweep_decompress_seconds\":[");
+        for(i=0;i<TIMING.sweeps;i++) fprintf(REPF,"%s%.6f",i ? ",":"",TIMING.sweep_secs[i]);
+        fprintf(REPF,"]");
+      }
+      fprintf(REPF,",\"bytes_in\":%llu,\"bytes_out\":%llu,\"bins\":%llu",
+              (unsigned long long)TIMING.bytes_in,(unsigned long long)TIMING.bytes_out,
+              (unsigned long long)TIMING.bins);
+      if(TIMING.secs[T_TOTAL]>0.0)
+        fprintf(REPF,",\"bins_per_second\":%.0f",(double)TIMING.bins/TIMING.secs[T_TOTAL]);
+      fprintf(REPF,"}\n");
+   }
+
+   if(REPF!=stderr)
+   {
+     fclose(REPF);
+     if(prom) rename(tmppath,path);
+   }
+   free(TIMING.sweep_secs);
+   TIMING.sweep_secs=NULL;
+}
@@ -0,0 +1,129 @@
+#!/bin/bash
+
+# Benchmarks of IRIS_decoder and ODIM_encoder.
+#
+# Microbenchmarks (IRIS_bench, ODIM_bench) time the ray decompression, get_raw_bytes,
+# RHOHV conversion, the encoder 8/16-bit requantization and the dataset write at each
+# compression level and storage policy. End-to-end benchmarks time the decoder, the encoder and the whole
+# conversion (decoder + encoder) of small, typical and worst case volumes generated by
+# IRIS_rawgen. Each result is reported as p50 p90 p99 seconds.
+#
+# Results are compared to the baseline file: a benchmark fails if its p50 is more than
+# BENCH_THRESHOLD percent slower than in baseline, and the script exits 1.
+# The baseline is machine specific, make it on the benchmark machine with --update-baseline.
+#
+# Usage: ./bench.sh [--update-baseline]
+
+BIN=${BENCH_BIN:-bin}
+WORK=${BENCH_DIR:-/tmp/iris_to_hdf5_bench}
+RUNS=${BENCH_RUNS:-5}                 # end-to-end runs per benchmark
+MICRO_RUNS=${BENCH_MICRO_RUNS:-20}    # microbenchmark runs
+VOLUMES=${BENCH_VOLUMES:-"small typical worst"}
+BASELINE=${BENCH_BASELINE:-bench_baseline.txt}
+THRESHOLD=${BENCH_THRESHOLD:-10}      # [%] allowed p50 slowdown
+
+UPDATE=0
+[ "$1" == "--update-baseline" ] && UPDATE=1
+
+MOMENTS_ALL=DBT2,DBZ2,VEL2,WIDTH2,ZDR2,RHOHV2,PHIDP2,KDP2,SQI2,HCLASS2
+# IRIS_rawgen options of the volumes
+VOL_small="-s 1 -r 360 -b 500 -m DBZ2,VEL2,WIDTH2,ZDR2"
+VOL_typical="-s 10 -r 360 -b 1000 -g 250 -m $MOMENTS_ALL"
+VOL_worst="-s 6 -r 3600 -b 1000 -g 250 -p 34 -X -x 0.001 -m $MOMENTS_ALL"
+
+# Conversion environment as in test.sh
+export ODIM_OUTPUT_DIR=$WORK
+export ODIM_OUTPUT_FILE=bench.h5
+export ODIM_COMPRESSION_LEVEL=6
+export ODIM_VOLUME_INTERVAL=5
+export ODIM_Conventions='ODIM_H5/V2_3'
+export ODIM_what_version='H5rad 2.3'
+export ODIM_how_simulated=True
+export ODIM_ORIGCENTER='EFKL'
+export ODIM_VAN_source='WIGOS:0-246-0-101001,WMO:02975,RAD:FI42,PLC:Vantaa,NOD:fivan'
+export ODIM_VAN_system='VAISWRM200'
+export ODIM_VAN_quantities='*:*'
+export IRIS_VAN_antgain=45.2
+unset ODIM_TIMING_FILE ODIM_LOG_FILE
+
+mkdir -p $WORK || exit 1
+RESULTS=$WORK/results.txt
+: > $RESULTS
+
+# Prints "name p50 p90 p99" of the times (one per line) in file $2
+percentiles()
+{
+  sort -g $2 | awk -v name=$1 '{ t[NR]=$1 }
+    function p(q) { k=int(q*NR); if(k<q*NR) k++; if(k<1) k=1; return t[k] }
+    END { printf("%-28s %11.6f %11.6f %11.6f\n",name,p(0.5),p(0.9),p(0.99)) }'
+}
+
+# Runs command $2... RUNS times and appends the percentiles of benchmark $1 to results
+run_e2e()
+{
+  local name=$1 times=$WORK/times.txt i t0 t1
+  shift
+  : > $times
+  for((i=0;i<RUNS;i++)); do
+     t0=$(date +%s.%N)
+     "$@" > /dev/null 2>&1 || { echo "FAILED: $*"; exit 1; }
+     t1=$(date +%s.%N)
+     echo "$t1 $t0" | awk '{ printf("%.6f\n",$1-$2) }' >> $times
+  done
+  percentiles $name $times | tee -a $RESULTS
+}
+
+echo -e "\n#########################################################################"
+echo -e "\nBenchmarks: $RUNS end-to-end runs, $MICRO_RUNS microbenchmark runs\n"
+printf "%-28s %11s %11s %11s\n" benchmark p50 p90 p99
+
+for vol in $VOLUMES; do
+  opts=VOL_$vol
+  RAW=$WORK/$vol.raw
+  # volumes are generated once, the seed is fixed
+  if [ ! -s $RAW ]; then
+     ${BIN}/IRIS_rawgen -R 1 ${!opts} $RAW || { echo "FAILED: IRIS_rawgen ${!opts}"; exit 1; }
+  fi
+done
+
+# Microbenchmarks on the typical volume
+MICRO_RAW=$WORK/typical.raw
+[ -s $MICRO_RAW ] || MICRO_RAW=$WORK/$(echo $VOLUMES | cut -d' ' -f1).raw
+micro()
+{
+  grep -v '^#' | awk -v pre=$1 '{ printf("%-28s %11s %11s %11s  %s %s\n",pre"/"$1,$2,$3,$4,$5,$6) }'
+}
+${BIN}/IRIS_bench -n $MICRO_RUNS $MICRO_RAW | micro iris | tee -a $RESULTS
+${BIN}/ODIM_bench -n $MICRO_RUNS -r 360 -b 1000 | micro odim | tee -a $RESULTS
+
+for vol in $VOLUMES; do
+  RAW=$WORK/$vol.raw
+  DAT=$WORK/$vol.dat
+  run_e2e decoder/$vol ${BIN}/IRIS_decoder $RAW $DAT
+  run_e2e encoder/$vol ${BIN}/ODIM_encoder $DAT
+  run_e2e convert/$vol sh -c "${BIN}/IRIS_decoder $RAW $DAT && ${BIN}/ODIM_encoder $DAT"
+  rm -f $DAT $WORK/bench.h5
+done
+
+if [ $UPDATE == 1 ]; then
+  cp $RESULTS $BASELINE
+  echo -e "\nBaseline $BASELINE updated\n"
+  exit 0
+fi
+
+if [ ! -s $BASELINE ]; then
+  echo -e "\nNo baseline $BASELINE, make one with: $0 --update-baseline\n"
+  exit 0
+fi
+
+# p50 comparison to baseline
+echo -e "\nComparison of p50 to baseline $BASELINE (threshold $THRESHOLD %)\n"
+awk -v thr=$THRESHOLD 'NR==FNR { base[$1]=$2; next }
+   ($1 in base) && base[$1]>0 {
+      d=100.0*($2-base[$1])/base[$1]
+      st="ok"; if(d>thr) { st="FAIL"; fail++ }
+      printf("%-28s %11.6f %11.6f %+7.1f %%  %s\n",$1,base[$1],$2,d,st)
+   }
+   END { if(fail) { printf("\n%d benchmark(s) slower than threshold\n\n",fail); exit 1 } else printf("\nAll benchmarks within threshold\n\n") }' \
+   $BASELINE $RESULTS
+exit $?
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+# Catalogue of archived IRIS RAW files, made from their header records only.
+#
+# Each file is inventoried by IRIS_decoder -i, which reads the product and ingest header
+# records and probes one record header per sweep, so no ray data is read or decompressed.
+# The files are given to parallel decoder runs, -j at a time. The catalogue is a CSV file of
+# one line per RAW file, sorted by file name:
+#
+#   file,site,task,date,time,sweeps,elangles,quantities,iris_types,prf,lowprf,rays,bins,rscale
+#
+# file, site and task are quoted ("" for a quote), so a file path may contain commas.
+# elangles, quantities (ODIM, UNKNOWN if none) and iris_types are ';' separated lists, date and
+# time are the volume start (YYYYMMDD, hhmmss). Files that are not RAW products are reported and
+# skipped, then the script exits 1. E.g. the volumes having KDP at 0.5 degrees (GNU awk):
+#
+#   gawk -v FPAT='("([^"]|"")*")|([^,]*)' '$8 ~ /(^|;)KDP(;|$)/ && $7 ~ /(^|;)0.50(;|$)/' catalog.csv
+#
+# Usage: ./catalog.sh [-o catalog.csv] [-j jobs] [-n name] file.raw|dir ...
+#   -o catalog : output file (default catalog.csv, - is stdout)
+#   -j jobs    : parallel decoder runs (default number of processors)
+#   -n name    : only files of name pattern in directories (find -name, default all files)
+#
+# CATALOG_BIN (default bin) gives the program directory.
+
+BIN=${CATALOG_BIN:-bin}
+OUT=catalog.csv
+JOBS=$(nproc 2>/dev/null || echo 1)
+NAME='*'
+
+while getopts "o:j:n:" opt; do
+  case $opt in
+    o) OUT=$OPTARG ;;
+    j) JOBS=$OPTARG ;;
+    n) NAME=$OPTARG ;;
+    *) sed -n '/^# Usage/,/^#   -n/p' $0; exit 1 ;;
+  esac
+done
+shift $((OPTIND-1))
+if [ $# == 0 ]; then sed -n '/^# Usage/,/^#   -n/p' $0; exit 1; fi
+
+[ "$OUT" == "-" ] && OUT=/dev/stdout
+TMP=$(mktemp) || exit 1
+trap "rm -f $TMP" EXIT
+
+# 64 files per decoder run, each run writes a line per file with one write
+find "$@" -type f -name "$NAME" -print0 |
+  xargs -0 -r -P $JOBS -n 64 ${BIN}/IRIS_decoder -i > $TMP
+STATUS=$?
+
+{ echo "file,site,task,date,time,sweeps,elangles,quantities,iris_types,prf,lowprf,rays,bins,rscale"
+  LC_ALL=C sort $TMP; } > $OUT
+[ "$OUT" != /dev/stdout ] && echo "$(wc -l < $TMP) file(s) catalogued to $OUT" >&2
+[ $STATUS == 0 ]
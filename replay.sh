@@ -0,0 +1,160 @@
+#!/bin/bash
+
+# Real-time replay of IRIS RAW files thru IRIS_decoder and ODIM_encoder for end-to-end
+# latency measurement.
+#
+# Each simulated site replays the given RAW files (archived, or made by IRIS_rawgen) at the
+# original cadence taken from the file name time stamps (YYYYMMDDhhmm, as in testdata) or,
+# if the names have no time stamps, every -i seconds. -s accelerates the cadence, -s 0
+# feeds the products back-to-back. Like the IRIS output pipe, every product is converted
+# by its own decoder+encoder run as soon as it arrives, so conversions of the sites (and
+# slow conversions of one site) run concurrently.
+#
+# The arrival of a product stands for the end of its last sweep (endepochs), so the latency
+# is the time from arrival to the ODIM file being available. Reported are the latency
+# distribution of all products and of each site, and the stage times of the timing reports
+# of the programs (see ODIM_timing.h), as p50 p90 p99 max seconds.
+#
+# Usage: ./replay.sh [-n sites] [-s speed] [-i interval] [-r rounds] [-o] [-k] file.raw|dir ...
+#   -n sites    : number of simulated sites (default 1)
+#   -s speed    : cadence acceleration factor, 0 = back-to-back (default 1 = real time)
+#   -i interval : product interval [s] if not in file names (default 300)
+#   -r rounds   : times the file list is replayed (default 1)
+#   -o          : spread the site start times over one interval (default all sites in sync,
+#                 as radars running the same volume schedule)
+#   -k          : keep the ODIM files
+#
+# The conversion environment (ODIM_* and IRIS_* variables of the sites of the files) must be
+# set as in test.sh. REPLAY_BIN (default bin) and REPLAY_DIR (default /tmp/iris_to_hdf5_replay)
+# give the program and work directories.
+
+BIN=${REPLAY_BIN:-bin}
+WORK=${REPLAY_DIR:-/tmp/iris_to_hdf5_replay}
+SITES=1
+SPEED=1
+INTERVAL=300
+ROUNDS=1
+SPREAD=0
+KEEP=0
+
+while getopts "n:s:i:r:ok" opt; do
+  case $opt in
+    n) SITES=$OPTARG ;;
+    s) SPEED=$OPTARG ;;
+    i) INTERVAL=$OPTARG ;;
+    r) ROUNDS=$OPTARG ;;
+    o) SPREAD=1 ;;
+    k) KEEP=1 ;;
+    *) sed -n '/^# Usage/,/^#   -k/p' $0; exit 1 ;;
+  esac
+done
+shift $((OPTIND-1))
+
+FILES=()
+for f in "$@"; do
+  if [ -d "$f" ]; then FILES+=($(find "$f" -type f | sort)); else FILES+=("$f"); fi
+done
+if [ ${#FILES[@]} == 0 ]; then sed -n '/^# Usage/,/^#   -k/p' $0; exit 1; fi
+
+rm -rf $WORK
+mkdir -p $WORK || exit 1
+LOG=$WORK/products.txt   # site product arrival decoded done status
+unset ODIM_OUTPUT_FILE ODIM_NAME_FILE ODIM_LOG_FILE
+export ODIM_TIMING_FORMAT=json
+
+now() { date +%s.%N; }
+
+# Offset [s] of each file from the first one, from YYYYMMDDhhmm in name or -i interval
+OFFSETS=()
+T0=""
+for((k=0;k<${#FILES[@]};k++)); do
+  ts=$(basename "${FILES[$k]}" | grep -o '[0-9]\{12\}' | head -1)
+  if [ -n "$ts" ]; then
+     t=$(date -u -d "${ts:0:8} ${ts:8:2}:${ts:10:2}" +%s)
+     [ -z "$T0" ] && T0=$t
+     OFFSETS[$k]=$((t-T0))
+  else
+     OFFSETS[$k]=$((k*INTERVAL))
+  fi
+done
+# one round lasts until the next file would come after the last one
+ROUND_LEN=$(( ${OFFSETS[${#FILES[@]}-1]} + INTERVAL ))
+
+# Converts product $3 of site $1 (sequence number $2) arrived at $4
+convert()
+{
+  local site=$1 n=$2 raw=$3 arrival=$4 dir=$WORK/site$1 decoded done status=0
+  export ODIM_OUTPUT_DIR=$dir
+  export ODIM_OUTPUT_FILE=p$n.h5
+  export ODIM_TIMING_FILE=$dir/timing.%s.json
+
+  ${BIN}/IRIS_decoder "$raw" $dir/p$n.dat > /dev/null 2>&1 || status=1
+  decoded=$(now)
+  [ $status == 0 ] && { ${BIN}/ODIM_encoder $dir/p$n.dat > /dev/null 2>&1 || status=2; }
+  done=$(now)
+  rm -f $dir/p$n.dat
+  [ $KEEP == 0 ] && rm -f $dir/p$n.h5
+  echo "$site $(basename $raw) $arrival $decoded $done $status" >> $LOG
+}
+
+# Replays the files of one site
+site_loop()
+{
+  local site=$1 start=$2 r k n=0 due wait
+  mkdir -p $WORK/site$site
+  for((r=0;r<ROUNDS;r++)); do
+    for((k=0;k<${#FILES[@]};k++)); do
+      if [ "$SPEED" != 0 ]; then
+         due=$(awk -v s=$start -v o=$((r*ROUND_LEN+OFFSETS[k])) -v v=$SPEED 'BEGIN { printf("%.3f\n",s+o/v) }')
+         wait=$(awk -v d=$due -v t=$(now) 'BEGIN { w=d-t; printf("%.3f\n",w>0 ? w : 0) }')
+         sleep $wait
+         convert $site $n "${FILES[$k]}" $(now) &
+      else
+         convert $site $n "${FILES[$k]}" $(now)
+      fi
+      n=$((n+1))
+    done
+  done
+  wait
+}
+
+echo -e "\nReplaying ${#FILES[@]} file(s) x $ROUNDS round(s) from $SITES site(s), speed $SPEED\n"
+START=$(awk -v t=$(now) 'BEGIN { printf("%.3f\n",t+1.0) }')
+for((s=1;s<=SITES;s++)); do
+  if [ $SPREAD == 1 ] && [ "$SPEED" != 0 ]; then
+     st=$(awk -v t=$START -v s=$s -v n=$SITES -v i=$INTERVAL -v v=$SPEED 'BEGIN { printf("%.3f\n",t+(s-1)*i/(n*v)) }')
+  else
+     st=$START
+  fi
+  site_loop $s $st &
+done
+wait
+
+# Latency distributions
+stats()
+{
+  sort -g | awk -v name="$1" '{ t[NR]=$1 }
+    function p(q) { k=int(q*NR); if(k<q*NR) k++; if(k<1) k=1; return t[k] }
+    END { if(NR) printf("%-24s %6d %10.3f %10.3f %10.3f %10.3f\n",name,NR,p(0.5),p(0.9),p(0.99),t[NR]) }'
+}
+
+FAILED=$(awk '$6!=0' $LOG | wc -l)
+printf "%-24s %6s %10s %10s %10s %10s\n" latency products p50 p90 p99 max
+awk '$6==0 { printf("%.6f\n",$5-$3) }' $LOG | stats all
+for((s=1;s<=SITES;s++)); do
+  awk -v s=$s '$1==s && $6==0 { printf("%.6f\n",$5-$3) }' $LOG | stats site$s
+done
+awk '$6==0 { printf("%.6f\n",$4-$3) }' $LOG | stats decoder
+awk '$6==0 { printf("%.6f\n",$5-$4) }' $LOG | stats encoder
+
+# Stage times from the timing reports
+echo
+printf "%-24s %6s %10s %10s %10s %10s\n" stage runs p50 p90 p99 max
+for prog in IRIS_decoder ODIM_encoder; do
+  for st in open header decompress convert write read requant deflate attrs project dealias total; do
+    cat $WORK/site*/timing.$prog.json 2>/dev/null | grep -o "\"$st\":{\"seconds\":[0-9.]*" |
+      sed 's/.*://' | stats "$prog/$st"
+  done
+done
+echo -e "\nFailed conversions: $FAILED. Per product log: $LOG\n"
+[ $FAILED == 0 ]
@@ -6,6 +6,8 @@
 echo -e "\n#########################################################################"
 echo -e "\nRunning conversion tests for IRIS_decoder and ODIM_encoder\n\n"
 
+# The committed bin/ binaries are an old build without ODIMDAT2, -w, -t and the ODIM_* variables
+# below. Build both programs into bin/ from these sources first (README.md, Building).
 DECODER=bin/IRIS_decoder
 ENCODER=bin/ODIM_encoder
 
@@ -14,6 +16,27 @@ RAW=testdata/201303151250_VAN.PPI2_E.raw
 export ODIM_OUTPUT_FILE=test.h5
 export ODIM_OUTPUT_DIR=.
 export ODIM_COMPRESSION_LEVEL=6 # default 6, choose between 0 and 9
+# export ODIM_STORAGE='HCLASS=9 DBZH=shuffle/6 PHIDP=auto1.2' # per quantity storage (ODIM_hdf5.h)
+# export ODIM_ENCODE_DEADLINE=20 # [s] target encoding time, compression level is lowered for
+#                                # the remaining datasets when behind (how/compression_level),
+#                                # not of quantities with a level in ODIM_STORAGE
+# export ODIM_PHYSICAL=add     # float32 physical values: add as dataset "physical" of each data
+#                              # group, or "only" to store them as "data" (gain 1, offset 0)
+# export ODIM_PHYSICAL_NODATA=-9999 ODIM_PHYSICAL_UNDETECT=-32 # their values, default NaN
+# export ODIM_CROP_RANGE='0 250'      # [km] only the bins of this range window are written
+# export ODIM_CROP_SECTOR='90 180'    # [deg] and the rays centred in this sector, clockwise
+# export ODIM_AVERAGE='4 1'          # average 4 range bins (and 1 ray), e.g. 250 m -> 1 km
+# export ODIM_STATISTICS=True     # histogram, coverage and missing_rays of each data as how attributes
+# export ODIM_EMPTY_DATA=minimal  # data of undetect or nodata only: keep (default), minimal
+#                                 # (dataset of HDF5 fill value only, no chunks) or skip
+# export ODIM_DEALIAS=VRADDH2      # dual-PRF corrected velocities as VRADDH (ODIM_dealias.h)
+# export ODIM_DEALIAS_WINDOW='1 2'  # neighbourhood of the median: +-1 rays, +-2 bins
+# export ODIM_CART_FILE=cappi.h5       # Cartesian product (ODIM IMAGE) in ODIM_OUTPUT_DIR (ODIM_cart.h)
+# export ODIM_CART_PRODUCT=CAPPI        # PPI (default), CAPPI or PCAPPI
+# export ODIM_CART_PRODPAR=1000         # PPI elevation [deg] (default lowest) or CAPPI height [m]
+# export ODIM_CART_GRID='500 1000'      # pixels per side, pixel size [m]
+# export ODIM_CART_QUANTITIES=DBZH,VRADH
+# export ODIM_CART_CACHE_DIR=/var/cache/odim_cart # lookup tables of the site geometries
 export ODIM_VOLUME_INTERVAL=5  # [min], nominal volume time is rounded using this 
 
 export ODIM_Conventions='ODIM_H5/V2_3'
@@ -70,6 +93,8 @@ export IRIS_VAN_TXlossV=4.3
 
 # Before the quantity name is the sweep number of IRIS volume, e.g. "3:DBZH" will
 # convert DBZH data from the third sweep only. Comma-separated list gives several, and * all.
+# With option -w the decoder also decodes only these quantities and passes the others
+# compressed, which makes the decoder faster and the .dat smaller.
 
 # You can combine whatever amount of IRIS RAW files to one HDF5 volume by converting 
 # them first to *.dat files by IRIS_decoder and then give the list to the ODIM_encoder,
@@ -82,6 +107,49 @@ export IRIS_VAN_TXlossV=4.3
 # to get list of conversions done (for e.g. log files)
 # The -d option of IRIS_decoder dumps all metadata
 
+# Per-stage timing and throughput report (see ODIM_timing.h). "%s" in the filename
+# is replaced by the program name. Format json (one line per run appended) or prometheus.
+# export ODIM_TIMING_FILE=./%s_timing.json
+# export ODIM_TIMING_FORMAT=json
+
+# Output of both programs is buffered and written by a background thread (see ODIM_log.h).
+# Log records can be written to a file, and in structured format one line per record
+# having time, program and product name. The output filename is always printed to stdout.
+# export ODIM_LOG_FILE=./iris_to_hdf5.log
+# export ODIM_LOG_FORMAT=structured
+
+# Memory budget of the scan buffers of both programs in bytes, or with suffix k, M or G.
+# Scans are then processed in blocks of rays fitting the budget (see ODIM_io.h),
+# by default a scan at a time.
+# export ODIM_MEMORY_BUDGET=16M
+
+# Streaming of sweeps: each sweep is written also as a single scan intermediate file as soon
+# as it is decoded ("%d" is the sweep number, default output.dat.sweep%d), and
+# ODIM_SWEEP_COMMAND is run for it in background with the file as last argument. The encoder
+# makes a SCAN (T_PAxA) of it, the volume is encoded from the full file as before.
+# export ODIM_SWEEP_FILE=/tmp/sweep%d.dat
+# export ODIM_SWEEP_COMMAND="env -u ODIM_OUTPUT_FILE -u ODIM_NAME_FILE ${ENCODER} -q"
+# ODIM_SECTOR_WIDTH writes also sectors of the given width [deg] of each sweep, as files
+# sweep file.sectorN, for the command.
+# export ODIM_SECTOR_WIDTH=30
+# With decoder option -t a RAW file still being written is decoded, waiting at most
+# ODIM_TAIL_TIMEOUT seconds for each record.
+# export ODIM_TAIL_TIMEOUT=60
+
+# Cache of conversions (see ODIM_cache.h): a RAW product or intermediate file converted before
+# with the same settings is not converted again, the earlier output is linked from the cache.
+# export ODIM_CACHE_DIR=/var/cache/iris_to_hdf5
+
+# Output profiles: the encoder makes an output for each profile of ODIM_PROFILES in one run.
+# ODIM_PROFILE_<name>_<X> replaces ODIM_<X> for the profile, and ODIM_PROFILE_<name>_quantities
+# the quantities of the site. Give each profile its own OUTPUT_FILE or OUTPUT_DIR, profiles
+# writing the same file are rejected. The input is read once and shared by the profiles.
+# export ODIM_PROFILES="archive legacy"
+# export ODIM_PROFILE_archive_OUTPUT_FILE=archive.h5
+# export ODIM_PROFILE_archive_COMPRESSION_LEVEL=9
+# export ODIM_PROFILE_legacy_OUTPUT_FILE=legacy.h5
+# export ODIM_PROFILE_legacy_quantities='*:DBZH,VRADH'
+
 export ODIM_VAN_quantities='*:*'
 
 ${DECODER} -v  $RAW "$RAW".dat